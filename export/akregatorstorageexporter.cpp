@@ -24,6 +24,7 @@
 #include "storagefactory.h"
 #include "storagefactoryregistry.h"
 #include "plugin.h"
+#include "akregatorconfig.h"
 #include <KLocalizedString>
 
 #include <Syndication/Constants>
@@ -345,7 +346,8 @@ static void printUsage()
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
-    const QString backend = QStringLiteral("metakit");
+    // the layouts of the metakit backend keep their archives in different files, read the one Akregator writes to
+    const QString backend = Settings::archiveBackend();
 
     if (argc < 2) {
         printUsage();
@@ -379,6 +381,10 @@ int main(int argc, char *argv[])
         qCritical("Could not create storage object for %s.", qPrintable(backend));
         return 1;
     }
+    if (!storage->open(false)) {
+        qCritical("Could not open storage for %s.", qPrintable(backend));
+        return 1;
+    }
 
     QFile out;
     if (!out.open(stdout, QIODevice::WriteOnly)) {
@@ -387,6 +393,7 @@ int main(int argc, char *argv[])
     }
 
     serialize(storage, url, &out);
+    storage->close();
 
     return app.exec();
 }
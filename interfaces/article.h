@@ -49,7 +49,9 @@ typedef QSharedPointer<Item> ItemPtr;
 
 namespace Akregator {
 namespace Backend {
+class ArticleRecord;
 class FeedStorage;
+class GuidKey;
 }
 
 class Feed;
@@ -59,6 +61,7 @@ class AKREGATORINTERFACES_EXPORT Article
     friend class ArticleDeleteJob;
     friend class ArticleModifyJob;
     friend class Feed;
+    friend class FeedParser;
 
 public:
     enum ContentOption {
@@ -139,6 +142,36 @@ public:
     bool operator>=(const Article &other) const;
 
 private: //only for our friends
+    /** creates an article object from a @p record that the caller writes to the archive, without accessing the archive.
+        The status of @p record is set to @p status first, the keep flag is preserved.
+    */
+    Article(const QString &guid, Feed *feed, Backend::ArticleRecord &record, int status);
+
+    /** merges a parsed item into @p record, reading the stored article only if needed. Nothing is written to the archive.
+        @param key the guid of the item, resolving the archive row once for all lookups
+        @return @c true if @p record differs from the archive and has to be written
+    */
+    static bool mergeItem(const Syndication::ItemPtr &article, Backend::FeedStorage *archive, const Backend::GuidKey &key, Backend::ArticleRecord &record);
+
+    /** extracts the fields of a parsed item, without accessing any archive. Safe to call from the parser threads */
+    static Backend::ArticleRecord recordFromItem(const Syndication::ItemPtr &article);
+
+    /** merges the fields @p item of a parsed article into @p record, like mergeItem().
+        @param stored whether the archive contains the article, @param storedHash its stored hash
+    */
+    static bool mergeRecord(const Backend::GuidKey &key, const Backend::ArticleRecord &item, Backend::FeedStorage *archive, bool stored, uint storedHash, Backend::ArticleRecord &record);
+
+    /** creates an article object from the header fields of an archived article, without accessing the archive */
+    Article(const QString &guid, Feed *feed, Backend::FeedStorage *archive, int status, uint hash, uint pubDate);
+
+    /** interpret a status value as stored in the archive, for code working on Backend::ArticleHeaders */
+    static bool isDeletedStatus(int status);
+    static bool isReadStatus(int status);
+    static bool isKeepStatus(int status);
+    static bool isNewStatus(int status);
+    /** returns the stored @p status with the article marked as Unread, keeping the other flags */
+    static int unreadStatus(int status);
+
     void setStatus(int s);
     void setDeleted();
     void setKeep(bool keep);
@@ -24,8 +24,13 @@
 #ifndef AKREGATOR_BACKEND_FEEDSTORAGE_H
 #define AKREGATOR_BACKEND_FEEDSTORAGE_H
 
+#include "storagekey.h"
+
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
 
 class QString;
 class QStringList;
@@ -60,6 +65,42 @@ public:
     }
 };
 
+/** a convenience class holding the stored fields of one article, so that an article can be read or written with a single archive lookup */
+class ArticleRecord
+{
+public:
+
+    QString title;
+    QString description;
+    QString content;
+    QString link;
+    QString commentsLink;
+    QString authorName;
+    QString authorUri;
+    QString authorEMail;
+    QString enclosureUrl;
+    QString enclosureType;
+    uint hash = 0;
+    uint pubDate = 0;
+    int status = 0;
+    int comments = 0;
+    int enclosureLength = -1;
+    bool guidIsHash = false;
+    bool guidIsPermaLink = false;
+    bool hasEnclosure = false;
+};
+
+/** the header fields of all articles of a feed, stored column by column. Row @c i of each column belongs to @c guids[i] */
+class ArticleHeaders
+{
+public:
+
+    QStringList guids;
+    QVector<int> status;
+    QVector<uint> hash;
+    QVector<uint> pubDate;
+};
+
 class Storage;
 
 class FeedStorage : public QObject //krazy:exclude=qobject
@@ -72,12 +113,27 @@ public:
     virtual int lastFetch() const = 0;
     virtual void setLastFetch(int lastFetch) = 0;
 
+    /** HTTP validators of the last successful fetch, sent with the next fetch to allow a "not modified" reply */
+    virtual void httpValidators(QString &etag, QString &lastModified) const = 0;
+    virtual void setHttpValidators(const QString &etag, const QString &lastModified) = 0;
+
+    /** digest of the last document fetched and ingested, so that an identical document does not need to be parsed again */
+    virtual QByteArray contentDigest() const = 0;
+    virtual void setContentDigest(const QByteArray &digest) = 0;
+
     /** returns the guids of all articles in this storage. If a tagID is given, only articles with this tag are returned */
     virtual QStringList articles(const QString &tagID = QString()) const = 0;
 
     /** returns the guid of the articles in a given category */
     virtual QStringList articles(const Category &cat) const = 0;
 
+    /** returns guid, status, hash and publication date of all articles, read in a single pass over the archive */
+    virtual ArticleHeaders articleHeaders() const = 0;
+
+    /** returns the headers of the articles published in [@p from, @p to), newest first and, for equal dates, ordered by guid.
+        At most @p limit articles are returned, -1 meaning no limit. The cost depends on the number of articles returned only. */
+    virtual ArticleHeaders articleHeadersByDate(uint from, uint to, int limit = -1) const = 0;
+
     /** Appends all articles from another storage. If there is already an article in this feed with the same guid, it is replaced by the article from the source
     @param source the archive which articles should be appended
     */
@@ -92,6 +148,20 @@ public:
     virtual bool contains(const QString &guid) const = 0;
     virtual void addEntry(const QString &guid) = 0;
     virtual void deleteArticle(const QString &guid) = 0;
+
+    /** reads all fields of an article with a single lookup
+        @return @c false if the article is not in the archive, @p record is left untouched then
+    */
+    virtual bool readArticle(const QString &guid, ArticleRecord &record) const = 0;
+
+    /** writes all fields of an article with a single lookup. The article is added if it is not in the archive yet. Tags and categories are not touched. */
+    virtual void writeArticle(const QString &guid, const ArticleRecord &record) = 0;
+
+    /** applies the changes of one fetch at once: writes @p records (adding the articles not in the archive yet), deletes the articles in @p deleted and sets the unread count.
+        The total count is adjusted once for the whole batch.
+    */
+    virtual void applyChanges(const QHash<QString, ArticleRecord> &records, const QStringList &deleted, int unread) = 0;
+
     virtual int comments(const QString &guid) const = 0;
     virtual QString commentsLink(const QString &guid) const = 0;
     virtual void setCommentsLink(const QString &guid, const QString &commentsLink) = 0;
@@ -137,10 +207,36 @@ public:
     virtual QString authorEMail(const QString &guid) const = 0;
 
     virtual void enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const = 0;
+
+    /** overloads for callers accessing the same article repeatedly, see GuidKey */
+    virtual bool contains(const GuidKey &key) const = 0;
+    virtual uint hash(const GuidKey &key) const = 0;
+    virtual bool readArticle(const GuidKey &key, ArticleRecord &record) const = 0;
+    virtual void writeArticle(const GuidKey &key, const ArticleRecord &record) = 0;
+    virtual int status(const GuidKey &key) const = 0;
+    virtual void setStatus(const GuidKey &key, int status) = 0;
+    virtual QString title(const GuidKey &key) const = 0;
+    virtual QString description(const GuidKey &key) const = 0;
+    virtual QString content(const GuidKey &key) const = 0;
+    virtual QString link(const GuidKey &key) const = 0;
+    virtual QString commentsLink(const GuidKey &key) const = 0;
+    virtual int comments(const GuidKey &key) const = 0;
+    virtual bool guidIsHash(const GuidKey &key) const = 0;
+    virtual bool guidIsPermaLink(const GuidKey &key) const = 0;
+    virtual QString authorName(const GuidKey &key) const = 0;
+    virtual QString authorUri(const GuidKey &key) const = 0;
+    virtual QString authorEMail(const GuidKey &key) const = 0;
+    virtual void enclosure(const GuidKey &key, bool &hasEnclosure, QString &url, QString &type, int &length) const = 0;
+
     virtual void close() = 0;
     virtual void commit() = 0;
     virtual void rollback() = 0;
 
+    /** asks the backend to keep the archive open, e.g. while the feed is fetched or displayed.
+        Calls nest, every pin() needs a matching unpin(). */
+    virtual void pin() = 0;
+    virtual void unpin() = 0;
+
     virtual void convertOldArchive() = 0;
 };
 } // namespace Backend
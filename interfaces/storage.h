@@ -26,6 +26,7 @@
 #define AKREGATOR_BACKEND_STORAGE_H
 
 #include "akregatorinterfaces_export.h"
+#include "storagekey.h"
 #include <QObject>
 
 class QString;
@@ -88,6 +89,25 @@ public:
     virtual int lastFetchFor(const QString &url) const = 0;
     virtual void setLastFetchFor(const QString &url, int lastFetch) = 0;
 
+    /** overloads for feed storages asking for their counters repeatedly, see FeedKey */
+    virtual int unreadFor(const FeedKey &key) const = 0;
+    virtual void setUnreadFor(const FeedKey &key, int unread) = 0;
+    virtual int totalCountFor(const FeedKey &key) const = 0;
+    virtual void setTotalCountFor(const FeedKey &key, int total) = 0;
+    virtual int lastFetchFor(const FeedKey &key) const = 0;
+    virtual void setLastFetchFor(const FeedKey &key, int lastFetch) = 0;
+
+    /** returns the HTTP validators (ETag and Last-Modified headers) of the last successful fetch, empty if unknown */
+    virtual void httpValidatorsFor(const QString &url, QString &etag, QString &lastModified) const = 0;
+    virtual void setHttpValidatorsFor(const QString &url, const QString &etag, const QString &lastModified) = 0;
+    /** returns the digest of the last document fetched and ingested, empty if unknown */
+    virtual QByteArray contentDigestFor(const QString &url) const = 0;
+    virtual void setContentDigestFor(const QString &url, const QByteArray &digest) = 0;
+    virtual void httpValidatorsFor(const FeedKey &key, QString &etag, QString &lastModified) const = 0;
+    virtual void setHttpValidatorsFor(const FeedKey &key, const QString &etag, const QString &lastModified) = 0;
+    virtual QByteArray contentDigestFor(const FeedKey &key) const = 0;
+    virtual void setContentDigestFor(const FeedKey &key, const QByteArray &digest) = 0;
+
     /** stores the feed list in the storage backend. This is a fallback for the case that the
         feeds.opml file gets corrupted
         @param opmlStr the feed list in OPML format
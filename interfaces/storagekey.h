@@ -0,0 +1,100 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_BACKEND_STORAGEKEY_H
+#define AKREGATOR_BACKEND_STORAGEKEY_H
+
+#include <QByteArray>
+#include <QString>
+
+namespace Akregator {
+namespace Backend {
+/** \brief A guid or feed URL prepared for repeated storage lookups.
+
+    The key is encoded once when it is created instead of on every storage call. Storages may
+    also remember where they found the key last time, so that the next lookup only has to verify it.
+*/
+class StorageKey
+{
+public:
+    StorageKey()
+    {
+    }
+
+    explicit StorageKey(const QString &key)
+        : m_string(key)
+        , m_latin1(key.toLatin1())
+    {
+    }
+
+    bool isNull() const
+    {
+        return m_string.isNull();
+    }
+
+    const QString &toString() const
+    {
+        return m_string;
+    }
+
+    /** the key encoded as Latin-1, the way the storages keep guids and URLs */
+    const QByteArray &latin1() const
+    {
+        return m_latin1;
+    }
+
+    /** returns the position found by the last lookup, or -1. Storages must verify it before use. */
+    int hint() const
+    {
+        return m_hint;
+    }
+
+    void setHint(int hint) const
+    {
+        m_hint = hint;
+    }
+
+private:
+    QString m_string;
+    QByteArray m_latin1;
+    mutable int m_hint = -1;
+};
+
+/** key of an article in a FeedStorage */
+class GuidKey : public StorageKey
+{
+public:
+    using StorageKey::StorageKey;
+};
+
+/** key of a feed in a Storage */
+class FeedKey : public StorageKey
+{
+public:
+    using StorageKey::StorageKey;
+};
+} // namespace Backend
+} // namespace Akregator
+
+#endif // AKREGATOR_BACKEND_STORAGEKEY_H
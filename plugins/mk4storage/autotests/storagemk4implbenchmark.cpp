@@ -0,0 +1,179 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "storagemk4implbenchmark.h"
+#include "storagemk4impl.h"
+#include "feedstorage.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Akregator::Backend;
+
+namespace {
+const int FeedCount = 2000;
+const int ArticlesPerFeed = 20;
+
+QString archivePath(StorageMK4Impl::Layout layout, const QTemporaryDir *filePerFeedDir, const QTemporaryDir *singleFileDir)
+{
+    return layout == StorageMK4Impl::SingleFile ? singleFileDir->path() : filePerFeedDir->path();
+}
+
+void addLayoutRows()
+{
+    QTest::addColumn<int>("layout");
+    QTest::newRow("file per feed") << int(StorageMK4Impl::FilePerFeed);
+    QTest::newRow("single file") << int(StorageMK4Impl::SingleFile);
+}
+
+ArticleRecord record(int feed, int article)
+{
+    ArticleRecord record;
+    record.title = QStringLiteral("Article %1 of feed %2").arg(article).arg(feed);
+    record.description = QStringLiteral("A short description of the article, as most feeds send it.");
+    record.link = QStringLiteral("http://localhost/feed%1/article%2.html").arg(feed).arg(article);
+    record.authorName = QStringLiteral("Konqi");
+    record.hash = feed * ArticlesPerFeed + article;
+    record.pubDate = 1500000000 + article;
+    return record;
+}
+}
+
+StorageMK4ImplBenchmark::StorageMK4ImplBenchmark(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StorageMK4ImplBenchmark::~StorageMK4ImplBenchmark()
+{
+}
+
+void StorageMK4ImplBenchmark::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+    mFilePerFeedDir = new QTemporaryDir;
+    mSingleFileDir = new QTemporaryDir;
+    QVERIFY(mFilePerFeedDir->isValid());
+    QVERIFY(mSingleFileDir->isValid());
+
+    for (int feed = 0; feed < FeedCount; ++feed) {
+        mFeeds.append(QStringLiteral("http://localhost/feed%1.xml").arg(feed));
+    }
+
+    const StorageMK4Impl::Layout layouts[] = { StorageMK4Impl::FilePerFeed, StorageMK4Impl::SingleFile };
+    for (StorageMK4Impl::Layout layout : layouts) {
+        StorageMK4Impl storage(layout);
+        storage.setArchivePath(archivePath(layout, mFilePerFeedDir, mSingleFileDir));
+        QVERIFY(storage.open(false));
+        for (int feed = 0; feed < FeedCount; ++feed) {
+            FeedStorage *archive = storage.archiveFor(mFeeds.at(feed));
+            QHash<QString, ArticleRecord> records;
+            for (int article = 0; article < ArticlesPerFeed; ++article) {
+                records.insert(QStringLiteral("http://localhost/feed%1/article%2").arg(feed).arg(article), record(feed, article));
+            }
+            archive->applyChanges(records, QStringList(), ArticlesPerFeed);
+        }
+        QVERIFY(storage.commit());
+        storage.close();
+    }
+}
+
+void StorageMK4ImplBenchmark::cleanupTestCase()
+{
+    delete mFilePerFeedDir;
+    mFilePerFeedDir = nullptr;
+    delete mSingleFileDir;
+    mSingleFileDir = nullptr;
+}
+
+void StorageMK4ImplBenchmark::diskFootprint_data()
+{
+    addLayoutRows();
+}
+
+void StorageMK4ImplBenchmark::diskFootprint()
+{
+    QFETCH(int, layout);
+    const QDir dir(archivePath(StorageMK4Impl::Layout(layout), mFilePerFeedDir, mSingleFileDir));
+    const QFileInfoList files = dir.entryInfoList(QDir::Files);
+    qint64 bytes = 0;
+    // allocated size, a file occupies at least one file system block
+    qint64 blocks = 0;
+    for (const QFileInfo &file : files) {
+        bytes += file.size();
+        blocks += (file.size() + 4095) / 4096;
+    }
+    qDebug() << files.count() << "files," << bytes << "bytes," << blocks * 4096 << "bytes in 4 KiB blocks";
+    QVERIFY(bytes > 0);
+}
+
+void StorageMK4ImplBenchmark::openAndReadCounts_data()
+{
+    addLayoutRows();
+}
+
+void StorageMK4ImplBenchmark::openAndReadCounts()
+{
+    QFETCH(int, layout);
+    // what Akregator does at startup: open the storage and show the counts of every feed
+    QBENCHMARK {
+        StorageMK4Impl storage(StorageMK4Impl::Layout(layout));
+        storage.setArchivePath(archivePath(StorageMK4Impl::Layout(layout), mFilePerFeedDir, mSingleFileDir));
+        storage.open(false);
+        int unread = 0;
+        for (const QString &url : qAsConst(mFeeds)) {
+            unread += storage.archiveFor(url)->unread();
+        }
+        QCOMPARE(unread, FeedCount * ArticlesPerFeed);
+        storage.close();
+    }
+}
+
+void StorageMK4ImplBenchmark::openAndReadHeaders_data()
+{
+    addLayoutRows();
+}
+
+void StorageMK4ImplBenchmark::openAndReadHeaders()
+{
+    QFETCH(int, layout);
+    // as above, followed by loading the article headers of every feed, e.g. for "All Feeds"
+    QBENCHMARK {
+        StorageMK4Impl storage(StorageMK4Impl::Layout(layout));
+        storage.setArchivePath(archivePath(StorageMK4Impl::Layout(layout), mFilePerFeedDir, mSingleFileDir));
+        storage.open(false);
+        int articles = 0;
+        for (const QString &url : qAsConst(mFeeds)) {
+            articles += storage.archiveFor(url)->articleHeaders().guids.count();
+        }
+        QCOMPARE(articles, FeedCount * ArticlesPerFeed);
+        storage.close();
+    }
+}
+
+QTEST_GUILESS_MAIN(StorageMK4ImplBenchmark)
@@ -0,0 +1,592 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "storagemk4impltest.h"
+#include "storagemk4impl.h"
+#include "feedstorage.h"
+#include "storagedummyimpl.h"
+
+#include <QFile>
+#include <QScopedPointer>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <climits>
+
+using namespace Akregator::Backend;
+
+namespace {
+struct StorageCloser
+{
+    static void cleanup(Storage *storage)
+    {
+        if (storage) {
+            storage->close();
+            delete storage;
+        }
+    }
+};
+
+typedef QScopedPointer<Storage, StorageCloser> StoragePointer;
+
+QString feedUrl(int number = 0)
+{
+    return QStringLiteral("http://localhost/feed%1.xml").arg(number);
+}
+
+QString guid(int number)
+{
+    return QStringLiteral("http://localhost/article%1").arg(number);
+}
+
+ArticleRecord record(int number, uint pubDate = 0)
+{
+    ArticleRecord record;
+    record.title = QStringLiteral("Article %1 über Akregator").arg(number);
+    record.description = QStringLiteral("Description of article %1, long enough to be stored compressed. ").arg(number).repeated(8);
+    record.content = QStringLiteral("<p>Content of article %1</p>").arg(number);
+    record.link = QStringLiteral("http://localhost/article%1.html").arg(number);
+    record.commentsLink = QStringLiteral("http://localhost/article%1/comments").arg(number);
+    record.authorName = QStringLiteral("Konqi");
+    record.authorUri = QStringLiteral("http://kde.org");
+    record.authorEMail = QStringLiteral("konqi@kde.org");
+    record.enclosureUrl = QStringLiteral("http://localhost/article%1.ogg").arg(number);
+    record.enclosureType = QStringLiteral("audio/ogg");
+    record.hash = 1000 + number;
+    record.pubDate = pubDate ? pubDate : 1500000000 + number;
+    record.status = number % 3;
+    record.comments = number;
+    record.enclosureLength = 4096;
+    record.guidIsHash = number % 2;
+    record.guidIsPermaLink = !record.guidIsHash;
+    record.hasEnclosure = true;
+    return record;
+}
+
+void compareRecords(const ArticleRecord &actual, const ArticleRecord &expected)
+{
+    QCOMPARE(actual.title, expected.title);
+    QCOMPARE(actual.description, expected.description);
+    QCOMPARE(actual.content, expected.content);
+    QCOMPARE(actual.link, expected.link);
+    QCOMPARE(actual.commentsLink, expected.commentsLink);
+    QCOMPARE(actual.authorName, expected.authorName);
+    QCOMPARE(actual.authorUri, expected.authorUri);
+    QCOMPARE(actual.authorEMail, expected.authorEMail);
+    QCOMPARE(actual.enclosureUrl, expected.enclosureUrl);
+    QCOMPARE(actual.enclosureType, expected.enclosureType);
+    QCOMPARE(actual.hash, expected.hash);
+    QCOMPARE(actual.pubDate, expected.pubDate);
+    QCOMPARE(actual.status, expected.status);
+    QCOMPARE(actual.comments, expected.comments);
+    QCOMPARE(actual.enclosureLength, expected.enclosureLength);
+    QCOMPARE(actual.guidIsHash, expected.guidIsHash);
+    QCOMPARE(actual.guidIsPermaLink, expected.guidIsPermaLink);
+    QCOMPARE(actual.hasEnclosure, expected.hasEnclosure);
+}
+
+QStringList sorted(QStringList list)
+{
+    list.sort();
+    return list;
+}
+
+void addBackendRows(bool withDummy = true)
+{
+    QTest::addColumn<QString>("backend");
+    if (withDummy) {
+        QTest::newRow("dummy") << QStringLiteral("dummy");
+    }
+    QTest::newRow("metakit") << QStringLiteral("metakit");
+    QTest::newRow("metakit-single") << QStringLiteral("metakit-single");
+}
+}
+
+StorageMK4ImplTest::StorageMK4ImplTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StorageMK4ImplTest::~StorageMK4ImplTest()
+{
+}
+
+void StorageMK4ImplTest::initTestCase()
+{
+    // the storage reads the compression and open archive settings
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void StorageMK4ImplTest::init()
+{
+    mDir = new QTemporaryDir;
+    QVERIFY(mDir->isValid());
+}
+
+void StorageMK4ImplTest::cleanup()
+{
+    delete mDir;
+    mDir = nullptr;
+}
+
+Storage *StorageMK4ImplTest::createStorage(const QString &backend) const
+{
+    Storage *storage = nullptr;
+    if (backend == QLatin1String("dummy")) {
+        storage = new StorageDummyImpl;
+    } else {
+        StorageMK4Impl *mk4Storage = new StorageMK4Impl(backend == QLatin1String("metakit-single") ? StorageMK4Impl::SingleFile : StorageMK4Impl::FilePerFeed);
+        mk4Storage->setArchivePath(mDir->path());
+        storage = mk4Storage;
+    }
+    storage->open(false);
+    return storage;
+}
+
+void StorageMK4ImplTest::shouldKeepFeedCounters_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldKeepFeedCounters()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+    FeedStorage *archive = storage->archiveFor(feedUrl());
+
+    archive->setUnread(5);
+    archive->setLastFetch(1500000000);
+    QCOMPARE(archive->unread(), 5);
+    QCOMPARE(archive->lastFetch(), 1500000000);
+    QCOMPARE(storage->unreadFor(feedUrl()), 5);
+    QCOMPARE(storage->lastFetchFor(FeedKey(feedUrl())), 1500000000);
+
+    const int total = archive->totalCount();
+    archive->writeArticle(guid(1), record(1));
+    archive->writeArticle(guid(2), record(2));
+    archive->writeArticle(guid(1), record(1));
+    QCOMPARE(archive->totalCount(), total + 2);
+    QVERIFY(storage->feeds().contains(feedUrl()));
+}
+
+void StorageMK4ImplTest::shouldReadBackWrittenArticle_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldReadBackWrittenArticle()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+    FeedStorage *archive = storage->archiveFor(feedUrl());
+
+    const ArticleRecord expected = record(1);
+    archive->writeArticle(guid(1), expected);
+    QVERIFY(archive->contains(guid(1)));
+    QVERIFY(archive->contains(GuidKey(guid(1))));
+    QCOMPARE(archive->articles(), QStringList() << guid(1));
+
+    ArticleRecord actual;
+    QVERIFY(archive->readArticle(guid(1), actual));
+    compareRecords(actual, expected);
+    ArticleRecord byKey;
+    QVERIFY(archive->readArticle(GuidKey(guid(1)), byKey));
+    compareRecords(byKey, expected);
+
+    // the single field getters see the same data
+    QCOMPARE(archive->title(guid(1)), expected.title);
+    QCOMPARE(archive->description(guid(1)), expected.description);
+    QCOMPARE(archive->content(guid(1)), expected.content);
+    QCOMPARE(archive->link(guid(1)), expected.link);
+    QCOMPARE(archive->authorName(guid(1)), expected.authorName);
+    QCOMPARE(archive->hash(guid(1)), expected.hash);
+    QCOMPARE(archive->pubDate(guid(1)), expected.pubDate);
+    QCOMPARE(archive->status(guid(1)), expected.status);
+    QCOMPARE(archive->comments(guid(1)), expected.comments);
+    QCOMPARE(archive->guidIsHash(guid(1)), expected.guidIsHash);
+    bool hasEnclosure = false;
+    QString url;
+    QString type;
+    int length = 0;
+    archive->enclosure(guid(1), hasEnclosure, url, type, length);
+    QVERIFY(hasEnclosure);
+    QCOMPARE(url, expected.enclosureUrl);
+    QCOMPARE(type, expected.enclosureType);
+    QCOMPARE(length, expected.enclosureLength);
+
+    ArticleRecord missing;
+    QVERIFY(!archive->contains(guid(2)));
+    QVERIFY(!archive->readArticle(guid(2), missing));
+    QVERIFY(missing.title.isEmpty());
+}
+
+void StorageMK4ImplTest::shouldUpdateExistingArticle_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldUpdateExistingArticle()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+    FeedStorage *archive = storage->archiveFor(feedUrl());
+
+    archive->writeArticle(guid(1), record(1));
+    archive->addTag(guid(1), QStringLiteral("kde"));
+    ArticleRecord changed = record(2);
+    changed.status = 2;
+    archive->writeArticle(guid(1), changed);
+    QCOMPARE(archive->articles().count(), 1);
+
+    ArticleRecord actual;
+    QVERIFY(archive->readArticle(guid(1), actual));
+    compareRecords(actual, changed);
+    // writing the fields leaves the tags alone
+    QCOMPARE(archive->tags(guid(1)), QStringList() << QStringLiteral("kde"));
+
+    archive->setStatus(guid(1), 1);
+    QCOMPARE(archive->status(guid(1)), 1);
+    archive->setTitle(guid(1), QStringLiteral("New title"));
+    QCOMPARE(archive->title(guid(1)), QStringLiteral("New title"));
+}
+
+void StorageMK4ImplTest::shouldListHeadersByDate_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldListHeadersByDate()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+    FeedStorage *archive = storage->archiveFor(feedUrl());
+
+    archive->writeArticle(guid(1), record(1, 300));
+    archive->writeArticle(guid(2), record(2, 100));
+    archive->writeArticle(guid(3), record(3, 200));
+    archive->writeArticle(guid(4), record(4, 200));
+
+    const ArticleHeaders headers = archive->articleHeaders();
+    QCOMPARE(sorted(headers.guids), QStringList() << guid(1) << guid(2) << guid(3) << guid(4));
+    for (int i = 0; i < headers.guids.count(); ++i) {
+        const ArticleRecord expected = record(headers.guids.at(i).right(1).toInt());
+        QCOMPARE(headers.status.at(i), expected.status);
+        QCOMPARE(headers.hash.at(i), expected.hash);
+    }
+
+    // newest first, equal dates by guid
+    ArticleHeaders byDate = archive->articleHeadersByDate(0, 1000);
+    QCOMPARE(byDate.guids, QStringList() << guid(1) << guid(3) << guid(4) << guid(2));
+    QCOMPARE(byDate.pubDate, QVector<uint>() << 300 << 200 << 200 << 100);
+
+    byDate = archive->articleHeadersByDate(100, 300);
+    QCOMPARE(byDate.guids, QStringList() << guid(3) << guid(4) << guid(2));
+    byDate = archive->articleHeadersByDate(0, 1000, 2);
+    QCOMPARE(byDate.guids, QStringList() << guid(1) << guid(3));
+
+    // a changed date moves the article
+    ArticleRecord moved = record(2, 400);
+    archive->writeArticle(guid(2), moved);
+    byDate = archive->articleHeadersByDate(0, 1000, 1);
+    QCOMPARE(byDate.guids, QStringList() << guid(2));
+}
+
+void StorageMK4ImplTest::shouldIndexTags_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldIndexTags()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+    FeedStorage *archive = storage->archiveFor(feedUrl());
+    const QString kde = QStringLiteral("kde");
+    const QString news = QStringLiteral("news");
+
+    archive->writeArticle(guid(1), record(1));
+    archive->writeArticle(guid(2), record(2));
+    archive->addTag(guid(1), kde);
+    archive->addTag(guid(2), kde);
+    archive->addTag(guid(1), news);
+
+    QCOMPARE(sorted(archive->articles(kde)), QStringList() << guid(1) << guid(2));
+    QCOMPARE(archive->articles(news), QStringList() << guid(1));
+    QCOMPARE(sorted(archive->tags(guid(1))), QStringList() << kde << news);
+    QCOMPARE(sorted(archive->tags()), QStringList() << kde << news);
+
+    archive->removeTag(guid(1), kde);
+    QCOMPARE(archive->articles(kde), QStringList() << guid(2));
+    QCOMPARE(archive->tags(guid(1)), QStringList() << news);
+    archive->removeTag(guid(1), news);
+    QVERIFY(archive->articles(news).isEmpty());
+    QCOMPARE(archive->tags(), QStringList() << kde);
+}
+
+void StorageMK4ImplTest::shouldIndexCategories_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldIndexCategories()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+    FeedStorage *archive = storage->archiveFor(feedUrl());
+
+    Category category;
+    category.term = QStringLiteral("desktop");
+    category.scheme = QStringLiteral("http://kde.org/categories");
+    category.name = QStringLiteral("Desktop");
+
+    archive->writeArticle(guid(1), record(1));
+    archive->writeArticle(guid(2), record(2));
+    archive->addCategory(guid(1), category);
+
+    QCOMPARE(archive->articles(category), QStringList() << guid(1));
+    const QList<Category> categories = archive->categories(guid(1));
+    QCOMPARE(categories.count(), 1);
+    QCOMPARE(categories.first().term, category.term);
+    QCOMPARE(categories.first().scheme, category.scheme);
+    QCOMPARE(categories.first().name, category.name);
+    QVERIFY(archive->categories().contains(category));
+    QVERIFY(archive->categories(guid(2)).isEmpty());
+}
+
+void StorageMK4ImplTest::shouldDeleteArticles_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldDeleteArticles()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+    FeedStorage *archive = storage->archiveFor(feedUrl());
+    const QString kde = QStringLiteral("kde");
+
+    archive->writeArticle(guid(1), record(1));
+    archive->writeArticle(guid(2), record(2));
+    archive->addTag(guid(1), kde);
+    archive->addTag(guid(2), kde);
+
+    archive->deleteArticle(guid(1));
+    QVERIFY(!archive->contains(guid(1)));
+    QVERIFY(archive->contains(guid(2)));
+    QCOMPARE(archive->articles(), QStringList() << guid(2));
+    QCOMPARE(archive->articles(kde), QStringList() << guid(2));
+    QCOMPARE(archive->articleHeaders().guids, QStringList() << guid(2));
+    QCOMPARE(archive->articleHeadersByDate(0, UINT_MAX).guids, QStringList() << guid(2));
+
+    // deleting an unknown article does nothing
+    archive->deleteArticle(guid(3));
+    QCOMPARE(archive->articles(), QStringList() << guid(2));
+}
+
+void StorageMK4ImplTest::shouldApplyChanges_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldApplyChanges()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+    FeedStorage *archive = storage->archiveFor(feedUrl());
+
+    archive->writeArticle(guid(1), record(1));
+    archive->writeArticle(guid(2), record(2));
+
+    QHash<QString, ArticleRecord> records;
+    ArticleRecord changed = record(2);
+    changed.title = QStringLiteral("Changed");
+    records.insert(guid(2), changed);
+    records.insert(guid(3), record(3));
+    archive->applyChanges(records, QStringList() << guid(1), 7);
+
+    QCOMPARE(sorted(archive->articles()), QStringList() << guid(2) << guid(3));
+    QCOMPARE(archive->title(guid(2)), QStringLiteral("Changed"));
+    ArticleRecord actual;
+    QVERIFY(archive->readArticle(guid(3), actual));
+    compareRecords(actual, record(3));
+    QCOMPARE(archive->unread(), 7);
+}
+
+void StorageMK4ImplTest::shouldKeepValidatorsAndDigest_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldKeepValidatorsAndDigest()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+    FeedStorage *archive = storage->archiveFor(feedUrl());
+
+    const QString etag = QStringLiteral("\"abc123\"");
+    const QString lastModified = QStringLiteral("Wed, 21 Oct 2015 07:28:00 GMT");
+    const QByteArray digest("\x01\x02\x00\xff", 4);
+    archive->setHttpValidators(etag, lastModified);
+    archive->setContentDigest(digest);
+
+    QString readEtag;
+    QString readLastModified;
+    archive->httpValidators(readEtag, readLastModified);
+    QCOMPARE(readEtag, etag);
+    QCOMPARE(readLastModified, lastModified);
+    QCOMPARE(archive->contentDigest(), digest);
+
+    storage->httpValidatorsFor(FeedKey(feedUrl()), readEtag, readLastModified);
+    QCOMPARE(readEtag, etag);
+    QCOMPARE(storage->contentDigestFor(feedUrl()), digest);
+}
+
+void StorageMK4ImplTest::shouldKeepFeedList_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldKeepFeedList()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+
+    const QString feedList = QStringLiteral("<opml version=\"1.0\"><body><outline text=\"KDE\"/></body></opml>");
+    const QString tagSet = QStringLiteral("<tagSet/>");
+    storage->storeFeedList(feedList);
+    storage->storeTagSet(tagSet);
+    QCOMPARE(storage->restoreFeedList(), feedList);
+    QCOMPARE(storage->restoreTagSet(), tagSet);
+}
+
+void StorageMK4ImplTest::shouldKeepFeedsApart_data()
+{
+    addBackendRows();
+}
+
+void StorageMK4ImplTest::shouldKeepFeedsApart()
+{
+    QFETCH(QString, backend);
+    StoragePointer storage(createStorage(backend));
+
+    for (int feed = 0; feed < 3; ++feed) {
+        FeedStorage *archive = storage->archiveFor(feedUrl(feed));
+        archive->writeArticle(guid(feed), record(feed));
+        archive->addTag(guid(feed), QStringLiteral("tag%1").arg(feed));
+        archive->setUnread(feed);
+    }
+    for (int feed = 0; feed < 3; ++feed) {
+        FeedStorage *archive = storage->archiveFor(feedUrl(feed));
+        QCOMPARE(archive->articles(), QStringList() << guid(feed));
+        QCOMPARE(archive->tags(), QStringList() << QStringLiteral("tag%1").arg(feed));
+        QCOMPARE(archive->unread(), feed);
+    }
+}
+
+void StorageMK4ImplTest::shouldPersistArchive_data()
+{
+    addBackendRows(false);
+}
+
+void StorageMK4ImplTest::shouldPersistArchive()
+{
+    QFETCH(QString, backend);
+    {
+        StoragePointer storage(createStorage(backend));
+        for (int feed = 0; feed < 3; ++feed) {
+            FeedStorage *archive = storage->archiveFor(feedUrl(feed));
+            archive->writeArticle(guid(feed), record(feed));
+            archive->writeArticle(guid(feed + 10), record(feed + 10));
+            archive->addTag(guid(feed), QStringLiteral("kde"));
+            archive->setUnread(feed + 1);
+            archive->setHttpValidators(QStringLiteral("etag%1").arg(feed), QString());
+        }
+        storage->storeFeedList(QStringLiteral("<opml/>"));
+        QVERIFY(storage->commit());
+    }
+
+    StoragePointer storage(createStorage(backend));
+    QCOMPARE(sorted(storage->feeds()), QStringList() << feedUrl(0) << feedUrl(1) << feedUrl(2));
+    QCOMPARE(storage->restoreFeedList(), QStringLiteral("<opml/>"));
+    for (int feed = 0; feed < 3; ++feed) {
+        FeedStorage *archive = storage->archiveFor(feedUrl(feed));
+        QCOMPARE(sorted(archive->articles()), QStringList() << guid(feed) << guid(feed + 10));
+        ArticleRecord actual;
+        QVERIFY(archive->readArticle(guid(feed), actual));
+        compareRecords(actual, record(feed));
+        QCOMPARE(archive->articles(QStringLiteral("kde")), QStringList() << guid(feed));
+        QCOMPARE(archive->unread(), feed + 1);
+        QCOMPARE(archive->totalCount(), 2);
+        QString etag;
+        QString lastModified;
+        archive->httpValidators(etag, lastModified);
+        QCOMPARE(etag, QStringLiteral("etag%1").arg(feed));
+    }
+}
+
+void StorageMK4ImplTest::shouldMigrateToSingleFile()
+{
+    Category category;
+    category.term = QStringLiteral("desktop");
+    category.scheme = QStringLiteral("http://kde.org/categories");
+    {
+        StoragePointer storage(createStorage(QStringLiteral("metakit")));
+        for (int feed = 0; feed < 2; ++feed) {
+            FeedStorage *archive = storage->archiveFor(feedUrl(feed));
+            archive->writeArticle(guid(feed), record(feed));
+            archive->addTag(guid(feed), QStringLiteral("kde"));
+            archive->addCategory(guid(feed), category);
+            archive->setUnread(1);
+            archive->setHttpValidators(QStringLiteral("etag%1").arg(feed), QStringLiteral("yesterday"));
+            archive->setContentDigest(QByteArray("digest") + char('0' + feed));
+        }
+        storage->storeFeedList(QStringLiteral("<opml/>"));
+        QVERIFY(storage->commit());
+    }
+    QVERIFY(!QFile::exists(mDir->path() + QLatin1String("/archive.mk4")));
+
+    StoragePointer storage(createStorage(QStringLiteral("metakit-single")));
+    QVERIFY(QFile::exists(mDir->path() + QLatin1String("/archive.mk4")));
+    QCOMPARE(sorted(storage->feeds()), QStringList() << feedUrl(0) << feedUrl(1));
+    QCOMPARE(storage->restoreFeedList(), QStringLiteral("<opml/>"));
+    for (int feed = 0; feed < 2; ++feed) {
+        FeedStorage *archive = storage->archiveFor(feedUrl(feed));
+        ArticleRecord actual;
+        QVERIFY(archive->readArticle(guid(feed), actual));
+        compareRecords(actual, record(feed));
+        QCOMPARE(archive->articles(QStringLiteral("kde")), QStringList() << guid(feed));
+        QCOMPARE(archive->articles(category), QStringList() << guid(feed));
+        QCOMPARE(archive->unread(), 1);
+        QCOMPARE(archive->totalCount(), 1);
+        QString etag;
+        QString lastModified;
+        archive->httpValidators(etag, lastModified);
+        QCOMPARE(etag, QStringLiteral("etag%1").arg(feed));
+        QCOMPARE(lastModified, QStringLiteral("yesterday"));
+        QCOMPARE(archive->contentDigest(), QByteArray("digest") + char('0' + feed));
+    }
+}
+
+QTEST_GUILESS_MAIN(StorageMK4ImplTest)
@@ -0,0 +1,83 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef STORAGEMK4IMPLTEST_H
+#define STORAGEMK4IMPLTEST_H
+
+#include <QObject>
+
+class QTemporaryDir;
+
+namespace Akregator {
+namespace Backend {
+class Storage;
+}
+}
+
+/** runs the same checks against the dummy storage and both layouts of the metakit storage */
+class StorageMK4ImplTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StorageMK4ImplTest(QObject *parent = nullptr);
+    ~StorageMK4ImplTest();
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void shouldKeepFeedCounters_data();
+    void shouldKeepFeedCounters();
+    void shouldReadBackWrittenArticle_data();
+    void shouldReadBackWrittenArticle();
+    void shouldUpdateExistingArticle_data();
+    void shouldUpdateExistingArticle();
+    void shouldListHeadersByDate_data();
+    void shouldListHeadersByDate();
+    void shouldIndexTags_data();
+    void shouldIndexTags();
+    void shouldIndexCategories_data();
+    void shouldIndexCategories();
+    void shouldDeleteArticles_data();
+    void shouldDeleteArticles();
+    void shouldApplyChanges_data();
+    void shouldApplyChanges();
+    void shouldKeepValidatorsAndDigest_data();
+    void shouldKeepValidatorsAndDigest();
+    void shouldKeepFeedList_data();
+    void shouldKeepFeedList();
+    void shouldKeepFeedsApart_data();
+    void shouldKeepFeedsApart();
+    void shouldPersistArchive_data();
+    void shouldPersistArchive();
+    void shouldMigrateToSingleFile();
+
+private:
+    /** creates and opens the storage @p backend, keeping metakit files in the temporary directory */
+    Akregator::Backend::Storage *createStorage(const QString &backend) const;
+
+    QTemporaryDir *mDir = nullptr;
+};
+
+#endif // STORAGEMK4IMPLTEST_H
@@ -24,6 +24,7 @@
 
 #include "feedstoragemk4impl.h"
 #include "storagemk4impl.h"
+#include "akregator_mk4storage_debug.h"
 
 #include <Syndication/DocumentSource>
 #include <Syndication/Global>
@@ -34,9 +35,14 @@
 
 #include <qdom.h>
 #include <QFile>
-#include <qdebug.h>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QPair>
+#include <QVector>
 #include <QStandardPaths>
 
+#include <algorithm>
+
 namespace {
 static uint calcHash(const QString &str)
 {
@@ -51,6 +57,76 @@ static uint calcHash(const QString &str)
     }
     return hash;
 }
+
+/** version 1 kept all fields of an article in one wide articles view, version 2 splits them into a header and a body view */
+const int SchemaVersion = 2;
+
+/** the fields read and written often, e.g. to list articles or mark them read. body is the row of the article in the bodies view */
+const char HeadersSchema[] = "[guid:S,status:I,pubDate:I,hash:I,flags:I,body:I]";
+/** the fields only needed to show an article. descriptionZ and contentZ hold description and content when stored compressed */
+const char BodiesSchema[] = "[title:S,description:S,content:S,descriptionZ:B,contentZ:B,link:S,commentsLink:S,comments:I,authorName:S,authorUri:S,authorEMail:S,enclosureUrl:S,enclosureType:S,enclosureLength:I,tags[tag:S],categories[catTerm:S,catScheme:S,catName:S]]";
+const char ArticlesSchemaV1[] = "[guid:S,title:S,hash:I,guidIsHash:I,guidIsPermaLink:I,description:S,link:S,comments:I,commentsLink:S,status:I,pubDate:I,tags[tag:S],hasEnclosure:I,enclosureUrl:S,enclosureType:S,enclosureLength:I,categories[catTerm:S,catScheme:S,catName:S],authorName:S,content:S,authorUri:S,authorEMail:S]";
+
+/** texts shorter than this are stored uncompressed, zlib gains little on them */
+const int CompressThreshold = 256;
+
+/** the inverted indexes listing the guids of the articles per tag and per category */
+const char TagIndexSchema[] = "[tag:S,taggedArticles[guid:S]]";
+const char CategoryIndexSchema[] = "[catTerm:S,catScheme:S,catName:S,categorizedArticles[guid:S]]";
+
+/** pubDate and guid of every article, ascending by date and, for equal dates, descending by guid.
+    Read backwards it lists the articles newest first, in the order of Article::operator< */
+const char DateIndexSchema[] = "[pubDate:I,guid:S]";
+
+/** the schema version of the archive and the storage form its bodies were converted to */
+const char SchemaInfoSchema[] = "[version:I,compressed:I]";
+
+/** bits of the flags column of the headers view */
+enum HeaderFlag {
+    GuidIsHashFlag = 1,
+    GuidIsPermaLinkFlag = 2,
+    HasEnclosureFlag = 4
+};
+
+int recordFlags(const Akregator::Backend::ArticleRecord &record)
+{
+    return (record.guidIsHash ? GuidIsHashFlag : 0) | (record.guidIsPermaLink ? GuidIsPermaLinkFlag : 0) | (record.hasEnclosure ? HasEnclosureFlag : 0);
+}
+
+/** returns whether @p storage has a top-level view @p name, without creating it */
+bool hasView(c4_Storage *storage, const QByteArray &name)
+{
+    const QByteArray description(storage->Description());
+    const QByteArray field = name + '[';
+    return description.startsWith(field) || description.contains(',' + field);
+}
+
+/** an archive is compacted only if at least this many bytes and this share of the file are free space */
+const qint64 CompactMinReclaim = 64 * 1024;
+const double CompactMinFragmentation = 0.25;
+
+/** writes a metakit storage to a QIODevice */
+class DeviceStream : public c4_Stream
+{
+public:
+    explicit DeviceStream(QIODevice *device)
+        : m_device(device)
+    {
+    }
+
+    int Read(void *buffer, int length) override
+    {
+        return static_cast<int>(m_device->read(static_cast<char *>(buffer), length));
+    }
+
+    bool Write(const void *buffer, int length) override
+    {
+        return m_device->write(static_cast<const char *>(buffer), length) == length;
+    }
+
+private:
+    QIODevice *m_device;
+};
 }
 
 namespace Akregator {
@@ -87,23 +163,390 @@ public:
         , ptaggedArticles("taggedArticles")
         , pcategorizedArticles("categorizedArticles")
         , pcategories("categories")
+        , pflags("flags")
+        , pbody("body")
+        , pversion("version")
+        , pcompressed("compressed")
+        , pdescriptionZ("descriptionZ")
+        , pcontentZ("contentZ")
+        , pheaders("headers")
+        , pheadersHash("headersHash")
+        , pbodies("bodies")
+        , ptagIndex("tagIndex")
+        , ptagIndexHash("tagIndexHash")
+        , pcategoryIndex("categoryIndex")
+        , pcategoryIndexHash("categoryIndexHash")
+        , pdateIndex("dateIndex")
+        , pschema("schema")
     {
     }
 
     QString url;
-    c4_Storage *storage;
+    FeedKey key;
+    QString filePath;
+    c4_Storage *storage = nullptr;
+    /** whether storage is the single file of the main storage, holding the articles in row table of its feed tables view */
+    bool sharedStorage = false;
+    int table = -1;
     StorageMK4Impl *mainStorage;
-    c4_View archiveView;
+    /** the narrow view of the article headers, hashed on guid */
+    c4_View headerView;
+    /** the article bodies, in rows referenced by the body column of headerView */
+    c4_View bodyView;
+    /** rows of bodyView no longer referenced by any header, reused for new articles */
+    QVector<int> freeBodies;
+    bool freeBodiesScanned = false;
 
     bool autoCommit;
     bool modified;
+    int pinCount = 0;
+    quint64 lastUse = 0;
     bool convert;
     QString oldArchivePath;
     c4_StringProp pguid, ptitle, pdescription, pcontent, plink, pcommentsLink, ptag, pEnclosureType, pEnclosureUrl, pcatTerm, pcatScheme, pcatName, pauthorName, pauthorUri, pauthorEMail;
     c4_IntProp phash, pguidIsHash, pguidIsPermaLink, pcomments, pstatus, ppubDate, pHasEnclosure, pEnclosureLength;
     c4_ViewProp ptags, ptaggedArticles, pcategorizedArticles, pcategories;
+    c4_IntProp pflags, pbody, pversion, pcompressed;
+    c4_BytesProp pdescriptionZ, pcontentZ;
+    /** the views of a feed in the single file layout, subviews of its row in the feed tables view */
+    c4_ViewProp pheaders, pheadersHash, pbodies, ptagIndex, ptagIndexHash, pcategoryIndex, pcategoryIndexHash, pdateIndex, pschema;
+    /** the per-feed schema view, recording the version and whether the bodies were converted to compressed storage */
+    c4_View schemaView;
+    /** tag -> articles index, hashed on tag */
+    c4_View tagIndexView;
+    /** category -> articles index, hashed on term and scheme */
+    c4_View categoryIndexView;
+    /** the articles ordered by date, see DateIndexSchema */
+    c4_View dateIndexView;
+    /** next body row to visit when converting the bodies to the configured storage form */
+    int recompressRow = 0;
+
+    /** returns the body row of the article in header row @p index */
+    c4_RowRef body(int index) const
+    {
+        return bodyView[pbody(headerView[index])];
+    }
+
+    void setFlag(int index, int flag, bool on)
+    {
+        const c4_RowRef row = headerView[index];
+        const int flags = pflags(row);
+        pflags(row) = on ? (flags | flag) : (flags & ~flag);
+    }
+
+    bool hasFlag(int index, int flag) const
+    {
+        return (pflags(headerView[index]) & flag) != 0;
+    }
+
+    /** returns the text stored in @p plain of @p row, or compressed in @p packed */
+    QString text(const c4_RowRef &row, const c4_StringProp &plain, const c4_BytesProp &packed) const
+    {
+        const c4_Bytes bytes = packed(row);
+        if (bytes.Size() > 0) {
+            return QString::fromUtf8(qUncompress(bytes.Contents(), bytes.Size()));
+        }
+        return QString::fromUtf8(plain(row));
+    }
+
+    /** stores @p text in @p row, compressed in @p packed if @p compress is set and it pays off. Returns the number of bytes stored */
+    int setText(const c4_RowRef &row, const c4_StringProp &plain, const c4_BytesProp &packed, const QString &text, bool compress)
+    {
+        const QByteArray utf8 = text.toUtf8();
+        if (compress && utf8.size() >= CompressThreshold) {
+            const QByteArray compressed = qCompress(utf8);
+            if (compressed.size() < utf8.size()) {
+                plain(row) = "";
+                packed(row) = c4_Bytes(compressed.constData(), compressed.size());
+                return compressed.size();
+            }
+        }
+        plain(row) = utf8.constData();
+        packed(row) = c4_Bytes();
+        return utf8.size();
+    }
+
+    /** stores @p text UTF-8 encoded in @p row, returns the number of bytes stored */
+    int setString(const c4_RowRef &row, const c4_StringProp &prop, const QString &text)
+    {
+        const QByteArray utf8 = text.toUtf8();
+        prop(row) = utf8.constData();
+        return utf8.size();
+    }
+
+    /** drops all views into the storage. Views keep the storage file mapped, so this must precede closing it */
+    void resetViews()
+    {
+        headerView = c4_View();
+        bodyView = c4_View();
+        schemaView = c4_View();
+        tagIndexView = c4_View();
+        categoryIndexView = c4_View();
+        dateIndexView = c4_View();
+    }
+
+    /** returns a body row for a new article */
+    int allocateBody();
+    /** clears the body row of the article in header row @p index and makes it available for reuse */
+    void releaseBody(int index);
+    /** converts the articles view of schema version 1, returns the number of articles converted */
+    int migrateFromV1();
+
+    /** returns the row of @p tag in the tag index, adding it if @p create is set. Returns -1 if not found */
+    int findTag(const QString &tag, bool create);
+    /** returns the row of @p cat in the category index, adding it if @p create is set. Returns -1 if not found */
+    int findCategory(const Category &cat, bool create);
+    /** removes the article in header row @p index from the tag and category indexes */
+    void unindexArticle(int index);
+    /** fills the category index from the categories stored with the articles */
+    void buildIndexes();
+
+    /** returns the first row of the date index not ordered before @p pubDate, or before (@p pubDate, @p guid) if @p guid is given */
+    int dateLowerBound(uint pubDate, const char *guid = nullptr) const;
+    void indexDate(uint pubDate, const QByteArray &guid);
+    void unindexDate(uint pubDate, const QByteArray &guid);
+    /** refills the date index from the headers */
+    void buildDateIndex();
 };
 
+namespace {
+/** removes @p guid from the guid list @p articles */
+void removeGuid(c4_View articles, const c4_StringProp &pguid, const QByteArray &guid)
+{
+    const int size = articles.GetSize();
+    for (int i = 0; i < size; ++i) {
+        if (guid == static_cast<const char *>(pguid(articles[i]))) {
+            articles.RemoveAt(i);
+            return;
+        }
+    }
+}
+}
+
+int FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::findTag(const QString &tag, bool create)
+{
+    c4_Row findrow;
+    ptag(findrow) = tag.toUtf8().constData();
+    const int findidx = tagIndexView.Find(findrow);
+    if (findidx != -1 || !create) {
+        return findidx;
+    }
+    return tagIndexView.Add(findrow);
+}
+
+int FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::findCategory(const Category &cat, bool create)
+{
+    c4_Row findrow;
+    pcatTerm(findrow) = cat.term.toUtf8().constData();
+    pcatScheme(findrow) = cat.scheme.toUtf8().constData();
+    const int findidx = categoryIndexView.Find(findrow);
+    if (findidx != -1 || !create) {
+        return findidx;
+    }
+    pcatName(findrow) = cat.name.toUtf8().constData();
+    return categoryIndexView.Add(findrow);
+}
+
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::unindexArticle(int index)
+{
+    const QByteArray guid(pguid(headerView[index]));
+    const c4_RowRef row = body(index);
+
+    // only the index entries of the article's own tags and categories are visited
+    const c4_View tags = ptags(row);
+    for (int i = 0; i < tags.GetSize(); ++i) {
+        const int tagidx = findTag(QString::fromUtf8(ptag(tags[i])), false);
+        if (tagidx == -1) {
+            continue;
+        }
+        c4_View articles = ptaggedArticles(tagIndexView[tagidx]);
+        removeGuid(articles, pguid, guid);
+        if (articles.GetSize() == 0) {
+            tagIndexView.RemoveAt(tagidx);
+        }
+    }
+
+    const c4_View categories = pcategories(row);
+    for (int i = 0; i < categories.GetSize(); ++i) {
+        Category cat;
+        cat.term = QString::fromUtf8(pcatTerm(categories[i]));
+        cat.scheme = QString::fromUtf8(pcatScheme(categories[i]));
+        const int catidx = findCategory(cat, false);
+        if (catidx == -1) {
+            continue;
+        }
+        c4_View articles = pcategorizedArticles(categoryIndexView[catidx]);
+        removeGuid(articles, pguid, guid);
+        if (articles.GetSize() == 0) {
+            categoryIndexView.RemoveAt(catidx);
+        }
+    }
+}
+
+int FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::dateLowerBound(uint pubDate, const char *guid) const
+{
+    int lo = 0;
+    int hi = dateIndexView.GetSize();
+    while (lo < hi) {
+        const int mid = (lo + hi) / 2;
+        const c4_RowRef row = dateIndexView[mid];
+        const uint rowDate = ppubDate(row);
+        if (rowDate < pubDate || (guid && rowDate == pubDate && qstrcmp(static_cast<const char *>(pguid(row)), guid) > 0)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::indexDate(uint pubDate, const QByteArray &guid)
+{
+    c4_Row row;
+    ppubDate(row) = pubDate;
+    pguid(row) = guid.constData();
+    dateIndexView.InsertAt(dateLowerBound(pubDate, guid.constData()), row);
+}
+
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::unindexDate(uint pubDate, const QByteArray &guid)
+{
+    const int pos = dateLowerBound(pubDate, guid.constData());
+    if (pos < dateIndexView.GetSize() && guid == static_cast<const char *>(pguid(dateIndexView[pos]))) {
+        dateIndexView.RemoveAt(pos);
+    }
+}
+
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::buildDateIndex()
+{
+    const int size = headerView.GetSize();
+    QVector<QPair<uint, QByteArray> > entries;
+    entries.reserve(size);
+    for (int i = 0; i < size; ++i) {
+        const c4_RowRef row = headerView[i];
+        entries.append(qMakePair(static_cast<uint>(ppubDate(row)), QByteArray(pguid(row))));
+    }
+    std::sort(entries.begin(), entries.end(), [](const QPair<uint, QByteArray> &lhs, const QPair<uint, QByteArray> &rhs) {
+        return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second > rhs.second);
+    });
+
+    dateIndexView.SetSize(size);
+    for (int i = 0; i < size; ++i) {
+        const c4_RowRef row = dateIndexView[i];
+        ppubDate(row) = entries.at(i).first;
+        pguid(row) = entries.at(i).second.constData();
+    }
+}
+
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::buildIndexes()
+{
+    const int size = headerView.GetSize();
+    for (int i = 0; i < size; ++i) {
+        c4_Row guidrow;
+        pguid(guidrow) = static_cast<const char *>(pguid(headerView[i]));
+
+        const c4_View tags = ptags(body(i));
+        for (int j = 0; j < tags.GetSize(); ++j) {
+            const int tagidx = findTag(QString::fromUtf8(ptag(tags[j])), true);
+            c4_View articles = ptaggedArticles(tagIndexView[tagidx]);
+            articles.Add(guidrow);
+        }
+
+        const c4_View categories = pcategories(body(i));
+        for (int j = 0; j < categories.GetSize(); ++j) {
+            Category cat;
+            cat.term = QString::fromUtf8(pcatTerm(categories[j]));
+            cat.scheme = QString::fromUtf8(pcatScheme(categories[j]));
+            cat.name = QString::fromUtf8(pcatName(categories[j]));
+            const int catidx = findCategory(cat, true);
+            c4_View articles = pcategorizedArticles(categoryIndexView[catidx]);
+            articles.Add(guidrow);
+        }
+    }
+}
+
+int FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::allocateBody()
+{
+    if (!freeBodiesScanned) {
+        // only the narrow body column is read to find the unreferenced rows
+        QVector<bool> used(bodyView.GetSize(), false);
+        const int size = headerView.GetSize();
+        for (int i = 0; i < size; ++i) {
+            const int body = pbody(headerView[i]);
+            if (body >= 0 && body < used.size()) {
+                used[body] = true;
+            }
+        }
+        freeBodies.clear();
+        for (int i = 0; i < used.size(); ++i) {
+            if (!used.at(i)) {
+                freeBodies.append(i);
+            }
+        }
+        freeBodiesScanned = true;
+    }
+    if (!freeBodies.isEmpty()) {
+        return freeBodies.takeLast();
+    }
+    return bodyView.Add(c4_Row());
+}
+
+void FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::releaseBody(int index)
+{
+    unindexArticle(index);
+    const c4_RowRef header = headerView[index];
+    unindexDate(ppubDate(header), QByteArray(pguid(header)));
+    const int body = pbody(headerView[index]);
+    bodyView.SetAt(body, c4_Row());
+    if (freeBodiesScanned) {
+        freeBodies.append(body);
+    }
+}
+
+int FeedStorageMK4Impl::FeedStorageMK4ImplPrivate::migrateFromV1()
+{
+    if (!hasView(storage, "articles")) {
+        return 0;
+    }
+
+    c4_View articles = storage->GetAs(QByteArray(QByteArray("articles") + ArticlesSchemaV1).constData());
+    const int size = articles.GetSize();
+    for (int i = 0; i < size; ++i) {
+        const c4_RowRef article = articles[i];
+
+        c4_Row body;
+        ptitle(body) = static_cast<const char *>(ptitle(article));
+        pdescription(body) = static_cast<const char *>(pdescription(article));
+        pcontent(body) = static_cast<const char *>(pcontent(article));
+        plink(body) = static_cast<const char *>(plink(article));
+        pcommentsLink(body) = static_cast<const char *>(pcommentsLink(article));
+        pcomments(body) = pcomments(article);
+        pauthorName(body) = static_cast<const char *>(pauthorName(article));
+        pauthorUri(body) = static_cast<const char *>(pauthorUri(article));
+        pauthorEMail(body) = static_cast<const char *>(pauthorEMail(article));
+        pEnclosureUrl(body) = static_cast<const char *>(pEnclosureUrl(article));
+        pEnclosureType(body) = static_cast<const char *>(pEnclosureType(article));
+        pEnclosureLength(body) = pEnclosureLength(article);
+        ptags(body) = static_cast<c4_View>(ptags(article));
+        pcategories(body) = static_cast<c4_View>(pcategories(article));
+
+        c4_Row header;
+        pguid(header) = static_cast<const char *>(pguid(article));
+        pstatus(header) = pstatus(article);
+        ppubDate(header) = ppubDate(article);
+        phash(header) = phash(article);
+        pflags(header) = (pguidIsHash(article) ? GuidIsHashFlag : 0) | (pguidIsPermaLink(article) ? GuidIsPermaLinkFlag : 0)
+                         | (pHasEnclosure(article) ? HasEnclosureFlag : 0);
+        pbody(header) = bodyView.Add(body);
+        headerView.Add(header);
+    }
+
+    // drop the old view and its hash index
+    articles = c4_View();
+    storage->GetAs("articles");
+    storage->GetAs("archiveHash");
+    return size;
+}
+
 void FeedStorageMK4Impl::convertOldArchive()
 {
     if (!d->convert) {
@@ -130,20 +573,37 @@ void FeedStorageMK4Impl::convertOldArchive()
     }
 }
 
+QByteArray FeedStorageMK4Impl::feedTablesDescription()
+{
+    return QByteArray("feedTables[headers") + HeadersSchema + ",headersHash[_H:I,_R:I],bodies" + BodiesSchema
+           + ",tagIndex" + TagIndexSchema + ",tagIndexHash[_H:I,_R:I],categoryIndex" + CategoryIndexSchema
+           + ",categoryIndexHash[_H:I,_R:I],dateIndex" + DateIndexSchema + ",schema" + SchemaInfoSchema + "]";
+}
+
 FeedStorageMK4Impl::FeedStorageMK4Impl(const QString &url, StorageMK4Impl *main)
 {
     d = new FeedStorageMK4ImplPrivate;
     d->autoCommit = main->autoCommit();
     d->url = url;
+    d->key = FeedKey(url);
     d->mainStorage = main;
 
+    if (main->sharedStorage()) {
+        d->sharedStorage = true;
+        d->storage = main->sharedStorage();
+        d->table = main->tableFor(d->key);
+        d->convert = false;
+        openViews();
+        return;
+    }
+
     QString url2 = url;
 
     if (url.length() > 255) {
         url2 = url.left(200) + QString::number(::calcHash(url), 16);
     }
 
-    qDebug() << url2;
+    qCDebug(AKREGATOR_MK4_LOG) << url2;
     QString t = url2;
     QString t2 = url2;
     QString filePath = main->archivePath() + QLatin1Char('/') + t.replace(QLatin1Char('/'), QLatin1Char('_')).replace(QLatin1Char(':'), QLatin1Char('_'));
@@ -153,42 +613,233 @@ FeedStorageMK4Impl::FeedStorageMK4Impl(const QString &url, StorageMK4Impl *main)
                                                                                                                                                                                                    '_'))
                         + QLatin1String(".xml");
     d->convert = !QFile::exists(filePath + QLatin1String(".mk4")) && QFile::exists(d->oldArchivePath);
-    d->storage = new c4_Storage(QString(filePath + QLatin1String(".mk4")).toLocal8Bit(), true);
-
-    d->archiveView = d->storage->GetAs(
-        "articles[guid:S,title:S,hash:I,guidIsHash:I,guidIsPermaLink:I,description:S,link:S,comments:I,commentsLink:S,status:I,pubDate:I,tags[tag:S],hasEnclosure:I,enclosureUrl:S,enclosureType:S,enclosureLength:I,categories[catTerm:S,catScheme:S,catName:S],authorName:S,content:S,authorUri:S,authorEMail:S]");
-
-    c4_View hash = d->storage->GetAs("archiveHash[_H:I,_R:I]");
-    d->archiveView = d->archiveView.Hash(hash, 1); // hash on guid
+    d->filePath = filePath + QLatin1String(".mk4");
+    // the metakit file is opened on first access, see ensureOpen()
 }
 
 FeedStorageMK4Impl::~FeedStorageMK4Impl()
 {
-    delete d->storage;
+    d->resetViews();
+    if (!d->sharedStorage) {
+        delete d->storage;
+    }
     delete d;
     d = 0;
 }
 
-void FeedStorageMK4Impl::markDirty()
+void FeedStorageMK4Impl::ensureOpen() const
 {
-    if (!d->modified) {
-        d->modified = true;
-        // Tell this to mainStorage
-        d->mainStorage->markDirty();
+    d->lastUse = d->mainStorage->nextUse();
+    if (d->storage) {
+        return;
     }
+
+    d->storage = new c4_Storage(d->filePath.toLocal8Bit(), true);
+    openViews();
+
+    d->mainStorage->archiveOpened(const_cast<FeedStorageMK4Impl *>(this));
 }
 
-void FeedStorageMK4Impl::commit()
+void FeedStorageMK4Impl::openViews() const
+{
+    bool indexed = true;
+    if (d->sharedStorage) {
+        // a row of one view rather than views of their own, so that opening a feed does not restructure the file
+        const c4_RowRef tables = d->mainStorage->feedTables(d->table);
+        d->headerView = static_cast<c4_View>(d->pheaders(tables)).Hash(d->pheadersHash(tables), 1); // hash on guid
+        d->bodyView = d->pbodies(tables);
+        d->tagIndexView = static_cast<c4_View>(d->ptagIndex(tables)).Hash(d->ptagIndexHash(tables), 1); // hash on tag
+        d->categoryIndexView = static_cast<c4_View>(d->pcategoryIndex(tables)).Hash(d->pcategoryIndexHash(tables), 2); // hash on term and scheme
+        d->dateIndexView = d->pdateIndex(tables);
+        d->schemaView = d->pschema(tables);
+    } else {
+        d->headerView = d->storage->GetAs((QByteArray("headers") + HeadersSchema).constData());
+        c4_View hashView = d->storage->GetAs("headersHash[_H:I,_R:I]");
+        d->headerView = d->headerView.Hash(hashView, 1); // hash on guid
+        d->bodyView = d->storage->GetAs((QByteArray("bodies") + BodiesSchema).constData());
+
+        indexed = hasView(d->storage, "categoryIndex");
+        d->tagIndexView = d->storage->GetAs((QByteArray("tagIndex") + TagIndexSchema).constData());
+        hashView = d->storage->GetAs("tagIndexHash[_H:I,_R:I]");
+        d->tagIndexView = d->tagIndexView.Hash(hashView, 1); // hash on tag
+        d->categoryIndexView = d->storage->GetAs((QByteArray("categoryIndex") + CategoryIndexSchema).constData());
+        hashView = d->storage->GetAs("categoryIndexHash[_H:I,_R:I]");
+        d->categoryIndexView = d->categoryIndexView.Hash(hashView, 2); // hash on term and scheme
+
+        d->dateIndexView = d->storage->GetAs((QByteArray("dateIndex") + DateIndexSchema).constData());
+        d->schemaView = d->storage->GetAs((QByteArray("schema") + SchemaInfoSchema).constData());
+    }
+    d->freeBodies.clear();
+    d->freeBodiesScanned = false;
+
+    d->recompressRow = 0;
+
+    c4_View &schemaView = d->schemaView;
+    int migrated = 0;
+    if (schemaView.GetSize() == 0 || d->pversion(schemaView[0]) < SchemaVersion) {
+        // the single file layout was introduced with schema version 2
+        migrated = d->sharedStorage ? 0 : d->migrateFromV1();
+        c4_Row version;
+        d->pversion(version) = SchemaVersion;
+        if (schemaView.GetSize() > 0) {
+            d->pversion(schemaView[0]) = SchemaVersion;
+        } else {
+            schemaView.Add(version);
+        }
+        if (migrated > 0) {
+            qCDebug(AKREGATOR_MK4_LOG) << "Converted" << migrated << "articles of" << d->url << "to archive schema version" << SchemaVersion;
+        }
+    }
+
+    // archives written before the indexes existed may have categories stored with the articles
+    if (!indexed && d->headerView.GetSize() > 0) {
+        d->buildIndexes();
+    }
+    // also repairs an index out of step with the headers, e.g. after a crash between two commits
+    const bool dateIndexed = d->dateIndexView.GetSize() == d->headerView.GetSize();
+    if (!dateIndexed) {
+        d->buildDateIndex();
+    }
+    if (migrated > 0 || (!indexed && d->headerView.GetSize() > 0) || !dateIndexed) {
+        const_cast<FeedStorageMK4Impl *>(this)->markDirty();
+    }
+}
+
+void FeedStorageMK4Impl::release()
 {
+    // a shared storage holds no resources of its own
+    if (!d->storage || d->sharedStorage) {
+        return;
+    }
     if (d->modified) {
         d->storage->Commit();
+        d->modified = false;
+    }
+    d->resetViews();
+    delete d->storage;
+    d->storage = nullptr;
+    d->mainStorage->archiveReleased(this);
+}
+
+bool FeedStorageMK4Impl::isOpen() const
+{
+    return d->storage != nullptr;
+}
+
+bool FeedStorageMK4Impl::isPinned() const
+{
+    return d->pinCount > 0;
+}
+
+quint64 FeedStorageMK4Impl::lastUse() const
+{
+    return d->lastUse;
+}
+
+void FeedStorageMK4Impl::pin()
+{
+    ++d->pinCount;
+}
+
+void FeedStorageMK4Impl::unpin()
+{
+    if (d->pinCount > 0) {
+        --d->pinCount;
+    }
+}
+
+qint64 FeedStorageMK4Impl::compact(qint64 maxSize)
+{
+    if (d->sharedStorage || isPinned() || d->modified) {
+        return -1;
+    }
+    const qint64 size = QFileInfo(d->filePath).size();
+    if (size < CompactMinReclaim || size > maxSize) {
+        return -1;
+    }
+
+    ensureOpen();
+    t4_i32 freeBytes = 0;
+    d->storage->FreeSpace(&freeBytes);
+    const double fragmentation = static_cast<double>(freeBytes) / size;
+    if (freeBytes < CompactMinReclaim || fragmentation < CompactMinFragmentation) {
+        return -1;
+    }
+
+    // the copy is written next to the archive and renamed over it, so a failure leaves the archive untouched
+    QSaveFile file(d->filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return -1;
+    }
+    DeviceStream stream(&file);
+    d->storage->SaveTo(stream);
+    // the old file must be closed before it is replaced, it is reopened on the next access
+    release();
+    if (!file.commit()) {
+        qCDebug(AKREGATOR_MK4_LOG) << "Could not compact archive of" << d->url << ":" << file.errorString();
+        return -1;
+    }
+
+    const qint64 reclaimed = size - QFileInfo(d->filePath).size();
+    qCDebug(AKREGATOR_MK4_LOG) << "Compacted archive of" << d->url << ": reclaimed" << reclaimed << "bytes, fragmentation was" << qRound(fragmentation * 100) << "%";
+    return reclaimed;
+}
+
+bool FeedStorageMK4Impl::recompressBodies(bool compress, int &budget)
+{
+    ensureOpen();
+    if (d->schemaView.GetSize() > 0 && (d->pcompressed(d->schemaView[0]) != 0) == compress) {
+        return true;
+    }
+
+    int bytes = 0;
+    const int size = d->bodyView.GetSize();
+    for (; d->recompressRow < size && budget > 0; ++d->recompressRow, --budget) {
+        const c4_RowRef row = d->bodyView[d->recompressRow];
+        const bool packed = static_cast<c4_Bytes>(d->pdescriptionZ(row)).Size() > 0 || static_cast<c4_Bytes>(d->pcontentZ(row)).Size() > 0;
+        if (packed == compress) {
+            continue;
+        }
+        const QString description = d->text(row, d->pdescription, d->pdescriptionZ);
+        const QString content = d->text(row, d->pcontent, d->pcontentZ);
+        bytes += d->setText(row, d->pdescription, d->pdescriptionZ, description, compress);
+        bytes += d->setText(row, d->pcontent, d->pcontentZ, content, compress);
+    }
+    if (d->recompressRow < size) {
+        markDirty(bytes);
+        return false;
+    }
+
+    d->recompressRow = 0;
+    if (d->schemaView.GetSize() == 0) {
+        d->schemaView.Add(c4_Row());
+    }
+    d->pcompressed(d->schemaView[0]) = compress ? 1 : 0;
+    markDirty(bytes);
+    return true;
+}
+
+void FeedStorageMK4Impl::markDirty(int bytes)
+{
+    d->modified = true;
+    // Tell this to mainStorage, every change restarts its commit delay
+    d->mainStorage->markDirty(this, bytes);
+}
+
+void FeedStorageMK4Impl::commit()
+{
+    // a shared storage is committed once for all feeds by the main storage
+    if (d->modified && d->storage && !d->sharedStorage) {
+        d->storage->Commit();
     }
     d->modified = false;
 }
 
 void FeedStorageMK4Impl::rollback()
 {
-    d->storage->Rollback();
+    if (d->storage && !d->sharedStorage) {
+        d->storage->Rollback();
+    }
 }
 
 void FeedStorageMK4Impl::close()
@@ -200,89 +851,140 @@ void FeedStorageMK4Impl::close()
 
 int FeedStorageMK4Impl::unread() const
 {
-    return d->mainStorage->unreadFor(d->url);
+    return d->mainStorage->unreadFor(d->key);
 }
 
 void FeedStorageMK4Impl::setUnread(int unread)
 {
-    d->mainStorage->setUnreadFor(d->url, unread);
+    d->mainStorage->setUnreadFor(d->key, unread);
 }
 
 int FeedStorageMK4Impl::totalCount() const
 {
-    return d->mainStorage->totalCountFor(d->url);
+    return d->mainStorage->totalCountFor(d->key);
 }
 
 void FeedStorageMK4Impl::setTotalCount(int total)
 {
-    d->mainStorage->setTotalCountFor(d->url, total);
+    d->mainStorage->setTotalCountFor(d->key, total);
 }
 
 int FeedStorageMK4Impl::lastFetch() const
 {
-    return d->mainStorage->lastFetchFor(d->url);
+    return d->mainStorage->lastFetchFor(d->key);
 }
 
 void FeedStorageMK4Impl::setLastFetch(int lastFetch)
 {
-    d->mainStorage->setLastFetchFor(d->url, lastFetch);
+    d->mainStorage->setLastFetchFor(d->key, lastFetch);
+}
+
+void FeedStorageMK4Impl::httpValidators(QString &etag, QString &lastModified) const
+{
+    d->mainStorage->httpValidatorsFor(d->key, etag, lastModified);
+}
+
+void FeedStorageMK4Impl::setHttpValidators(const QString &etag, const QString &lastModified)
+{
+    d->mainStorage->setHttpValidatorsFor(d->key, etag, lastModified);
+}
+
+QByteArray FeedStorageMK4Impl::contentDigest() const
+{
+    return d->mainStorage->contentDigestFor(d->key);
+}
+
+void FeedStorageMK4Impl::setContentDigest(const QByteArray &digest)
+{
+    d->mainStorage->setContentDigestFor(d->key, digest);
 }
 
 QStringList FeedStorageMK4Impl::articles(const QString &tag) const
 {
     QStringList list;
-#if 0 //category and tag support disabled
+    ensureOpen();
     if (tag.isNull()) { // return all articles
-#endif
-    int size = d->archiveView.GetSize();
-    for (int i = 0; i < size; ++i) {     // fill with guids
-        list += QString::fromLatin1(d->pguid(d->archiveView.GetAt(i)));
-    }
-#if 0 //category and tag support disabled
-} else {
-    c4_Row tagrow;
-    d->ptag(tagrow) = tag.toUtf8().data();
-    int tagidx = d->tagView.Find(tagrow);
+        int size = d->headerView.GetSize();
+        for (int i = 0; i < size; ++i) {     // fill with guids
+            list += QString::fromLatin1(d->pguid(d->headerView[i]));
+        }
+        return list;
+    }
+
+    const int tagidx = d->findTag(tag, false);
     if (tagidx != -1) {
-        tagrow = d->tagView.GetAt(tagidx);
-        c4_View tagView = d->ptaggedArticles(tagrow);
+        const c4_View tagView = d->ptaggedArticles(d->tagIndexView[tagidx]);
         int size = tagView.GetSize();
         for (int i = 0; i < size; ++i) {
-            list += QString(d->pguid(tagView.GetAt(i)));
+            list += QString::fromLatin1(d->pguid(tagView[i]));
         }
     }
-}
-#endif
     return list;
 }
 
 QStringList FeedStorageMK4Impl::articles(const Category &cat) const
 {
     QStringList list;
-#if 0 //category and tag support disabled
-    c4_Row catrow;
-    d->pcatTerm(catrow) = cat.term.toUtf8().data();
-    d->pcatScheme(catrow) = cat.scheme.toUtf8().data();
-
-    int catidx = d->catView.Find(catrow);
+    ensureOpen();
+    const int catidx = d->findCategory(cat, false);
     if (catidx != -1) {
-        catrow = d->catView.GetAt(catidx);
-        c4_View catView = d->pcategorizedArticles(catrow);
+        const c4_View catView = d->pcategorizedArticles(d->categoryIndexView[catidx]);
         int size = catView.GetSize();
         for (int i = 0; i < size; ++i) {
-            list += QString(d->pguid(catView.GetAt(i)));
+            list += QString::fromLatin1(d->pguid(catView[i]));
         }
     }
-#endif
     return list;
 }
 
+ArticleHeaders FeedStorageMK4Impl::articleHeaders() const
+{
+    ArticleHeaders headers;
+    ensureOpen();
+    const int size = d->headerView.GetSize();
+    headers.guids.reserve(size);
+    headers.status.reserve(size);
+    headers.hash.reserve(size);
+    headers.pubDate.reserve(size);
+    for (int i = 0; i < size; ++i) {
+        const c4_RowRef row = d->headerView[i];
+        headers.guids.append(QString::fromLatin1(d->pguid(row)));
+        headers.status.append(d->pstatus(row));
+        headers.hash.append(d->phash(row));
+        headers.pubDate.append(d->ppubDate(row));
+    }
+    return headers;
+}
+
+ArticleHeaders FeedStorageMK4Impl::articleHeadersByDate(uint from, uint to, int limit) const
+{
+    ArticleHeaders headers;
+    ensureOpen();
+    const int first = d->dateLowerBound(from);
+    for (int i = d->dateLowerBound(to) - 1; i >= first && (limit < 0 || headers.guids.count() < limit); --i) {
+        const c4_RowRef row = d->dateIndexView[i];
+        const QString guid = QString::fromLatin1(d->pguid(row));
+        const int findidx = findArticle(guid);
+        if (findidx == -1) {
+            continue;
+        }
+        const c4_RowRef header = d->headerView[findidx];
+        headers.guids.append(guid);
+        headers.status.append(d->pstatus(header));
+        headers.hash.append(d->phash(header));
+        headers.pubDate.append(d->ppubDate(header));
+    }
+    return headers;
+}
+
 void FeedStorageMK4Impl::addEntry(const QString &guid)
 {
-    c4_Row row;
-    d->pguid(row) = guid.toLatin1();
     if (!contains(guid)) {
-        d->archiveView.Add(row);
+        c4_Row row;
+        d->pguid(row) = guid.toLatin1();
+        d->pbody(row) = d->allocateBody();
+        d->headerView.Add(row);
+        d->indexDate(0, guid.toLatin1());
         markDirty();
         setTotalCount(totalCount() + 1);
     }
@@ -290,58 +992,225 @@ void FeedStorageMK4Impl::addEntry(const QString &guid)
 
 bool FeedStorageMK4Impl::contains(const QString &guid) const
 {
-    return findArticle(guid) != -1;
+    return contains(GuidKey(guid));
+}
+
+bool FeedStorageMK4Impl::contains(const GuidKey &key) const
+{
+    return findArticle(key) != -1;
 }
 
 int FeedStorageMK4Impl::findArticle(const QString &guid) const
 {
+    return findArticle(GuidKey(guid));
+}
+
+int FeedStorageMK4Impl::findArticle(const GuidKey &key) const
+{
+    ensureOpen();
+    // rows only move when articles are deleted, verify the row found last time before searching
+    const int hint = key.hint();
+    if (hint != -1 && hint < d->headerView.GetSize() && key.latin1() == static_cast<const char *>(d->pguid(d->headerView[hint]))) {
+        return hint;
+    }
     c4_Row findrow;
-    d->pguid(findrow) = guid.toLatin1();
-    return d->archiveView.Find(findrow);
+    d->pguid(findrow) = key.latin1().constData();
+    const int findidx = d->headerView.Find(findrow);
+    key.setHint(findidx);
+    return findidx;
 }
 
 void FeedStorageMK4Impl::deleteArticle(const QString &guid)
 {
     int findidx = findArticle(guid);
     if (findidx != -1) {
-        QStringList list = tags(guid);
-        for (QStringList::ConstIterator it = list.constBegin(); it != list.constEnd(); ++it) {
-            removeTag(guid, *it);
-        }
         setTotalCount(totalCount() - 1);
-        d->archiveView.RemoveAt(findidx);
+        d->releaseBody(findidx);
+        d->headerView.RemoveAt(findidx);
         markDirty();
     }
 }
 
+bool FeedStorageMK4Impl::readArticle(const QString &guid, ArticleRecord &record) const
+{
+    return readArticle(GuidKey(guid), record);
+}
+
+bool FeedStorageMK4Impl::readArticle(const GuidKey &key, ArticleRecord &record) const
+{
+    int findidx = findArticle(key);
+    if (findidx == -1) {
+        return false;
+    }
+
+    const c4_RowRef header = d->headerView[findidx];
+    record.hash = d->phash(header);
+    record.pubDate = d->ppubDate(header);
+    record.status = d->pstatus(header);
+    const int flags = d->pflags(header);
+    record.guidIsHash = flags & GuidIsHashFlag;
+    record.guidIsPermaLink = flags & GuidIsPermaLinkFlag;
+    record.hasEnclosure = flags & HasEnclosureFlag;
+
+    const c4_RowRef row = d->bodyView[d->pbody(header)];
+    record.title = QString::fromUtf8(d->ptitle(row));
+    record.description = d->text(row, d->pdescription, d->pdescriptionZ);
+    record.content = d->text(row, d->pcontent, d->pcontentZ);
+    record.link = QString::fromLatin1(d->plink(row));
+    record.commentsLink = QString::fromLatin1(d->pcommentsLink(row));
+    record.authorName = QString::fromUtf8(d->pauthorName(row));
+    record.authorUri = QString::fromUtf8(d->pauthorUri(row));
+    record.authorEMail = QString::fromUtf8(d->pauthorEMail(row));
+    record.enclosureUrl = QLatin1String(d->pEnclosureUrl(row));
+    record.enclosureType = QLatin1String(d->pEnclosureType(row));
+    record.comments = d->pcomments(row);
+    record.enclosureLength = d->pEnclosureLength(row);
+    return true;
+}
+
+void FeedStorageMK4Impl::writeArticle(const QString &guid, const ArticleRecord &record)
+{
+    writeArticle(GuidKey(guid), record);
+}
+
+void FeedStorageMK4Impl::writeArticle(const GuidKey &key, const ArticleRecord &record)
+{
+    int bytes = 0;
+    if (storeArticle(key, record, bytes)) {
+        setTotalCount(totalCount() + 1);
+    }
+    markDirty(bytes);
+}
+
+void FeedStorageMK4Impl::applyChanges(const QHash<QString, ArticleRecord> &records, const QStringList &deleted, int unread)
+{
+    int added = 0;
+    int bytes = 0;
+    for (auto it = records.constBegin(), end = records.constEnd(); it != end; ++it) {
+        if (storeArticle(GuidKey(it.key()), it.value(), bytes)) {
+            ++added;
+        }
+    }
+
+    int removed = 0;
+    for (const QString &guid : deleted) {
+        int findidx = findArticle(guid);
+        if (findidx != -1) {
+            d->releaseBody(findidx);
+            d->headerView.RemoveAt(findidx);
+            ++removed;
+        }
+    }
+
+    if (added != removed) {
+        setTotalCount(totalCount() + added - removed);
+    }
+    setUnread(unread);
+    markDirty(bytes);
+}
+
+bool FeedStorageMK4Impl::storeArticle(const GuidKey &key, const ArticleRecord &record, int &bytes)
+{
+    const int findidx = findArticle(key);
+    const bool added = findidx == -1;
+
+    // the body row is updated field by field, so the tags and categories subviews are kept
+    const int body = added ? d->allocateBody() : d->pbody(d->headerView[findidx]);
+    const c4_RowRef row = d->bodyView[body];
+    bytes += d->setString(row, d->ptitle, record.title);
+    const bool compress = d->mainStorage->compressArticles();
+    bytes += d->setText(row, d->pdescription, d->pdescriptionZ, record.description, compress);
+    bytes += d->setText(row, d->pcontent, d->pcontentZ, record.content, compress);
+    d->plink(row) = !record.link.isEmpty() ? record.link.toLatin1() : "";
+    bytes += record.link.size();
+    bytes += d->setString(row, d->pcommentsLink, record.commentsLink);
+    bytes += d->setString(row, d->pauthorName, record.authorName);
+    bytes += d->setString(row, d->pauthorUri, record.authorUri);
+    bytes += d->setString(row, d->pauthorEMail, record.authorEMail);
+    bytes += d->setString(row, d->pEnclosureUrl, record.enclosureUrl);
+    bytes += d->setString(row, d->pEnclosureType, record.enclosureType);
+    d->pcomments(row) = record.comments;
+    d->pEnclosureLength(row) = record.enclosureLength;
+
+    if (added) {
+        c4_Row header;
+        d->pguid(header) = key.latin1().constData();
+        d->phash(header) = record.hash;
+        d->ppubDate(header) = record.pubDate;
+        d->pstatus(header) = record.status;
+        d->pflags(header) = recordFlags(record);
+        d->pbody(header) = body;
+        key.setHint(d->headerView.Add(header));
+        d->indexDate(record.pubDate, key.latin1());
+        return true;
+    }
+
+    const c4_RowRef header = d->headerView[findidx];
+    const uint oldPubDate = d->ppubDate(header);
+    if (oldPubDate != record.pubDate) {
+        d->unindexDate(oldPubDate, key.latin1());
+        d->indexDate(record.pubDate, key.latin1());
+    }
+    d->phash(header) = record.hash;
+    d->ppubDate(header) = record.pubDate;
+    d->pstatus(header) = record.status;
+    d->pflags(header) = recordFlags(record);
+    return false;
+}
+
 int FeedStorageMK4Impl::comments(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->pcomments(d->archiveView.GetAt(findidx)) : 0;
+    return comments(GuidKey(guid));
+}
+
+int FeedStorageMK4Impl::comments(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? d->pcomments(d->body(findidx)) : 0;
 }
 
 QString FeedStorageMK4Impl::commentsLink(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromLatin1(d->pcommentsLink(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    return commentsLink(GuidKey(guid));
+}
+
+QString FeedStorageMK4Impl::commentsLink(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? QString::fromLatin1(d->pcommentsLink(d->body(findidx))) : QLatin1String("");
 }
 
 bool FeedStorageMK4Impl::guidIsHash(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->pguidIsHash(d->archiveView.GetAt(findidx)) : false;
+    return guidIsHash(GuidKey(guid));
+}
+
+bool FeedStorageMK4Impl::guidIsHash(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? d->hasFlag(findidx, GuidIsHashFlag) : false;
 }
 
 bool FeedStorageMK4Impl::guidIsPermaLink(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->pguidIsPermaLink(d->archiveView.GetAt(findidx)) : false;
+    return guidIsPermaLink(GuidKey(guid));
+}
+
+bool FeedStorageMK4Impl::guidIsPermaLink(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? d->hasFlag(findidx, GuidIsPermaLinkFlag) : false;
 }
 
 uint FeedStorageMK4Impl::hash(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->phash(d->archiveView.GetAt(findidx)) : 0;
+    return hash(GuidKey(guid));
+}
+
+uint FeedStorageMK4Impl::hash(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? d->phash(d->headerView[findidx]) : 0;
 }
 
 void FeedStorageMK4Impl::setDeleted(const QString &guid)
@@ -351,71 +1220,97 @@ void FeedStorageMK4Impl::setDeleted(const QString &guid)
         return;
     }
 
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    QStringList list = tags(guid);
-    for (QStringList::ConstIterator it = list.constBegin(); it != list.constEnd(); ++it) {
-        removeTag(guid, *it);
-    }
+    d->unindexArticle(findidx);
+    const c4_RowRef row = d->body(findidx);
+    d->ptags(row) = c4_View();
+    d->pcategories(row) = c4_View();
     d->pdescription(row) = "";
     d->pcontent(row) = "";
+    d->pdescriptionZ(row) = c4_Bytes();
+    d->pcontentZ(row) = c4_Bytes();
     d->ptitle(row) = "";
     d->plink(row) = "";
     d->pauthorName(row) = "";
     d->pauthorUri(row) = "";
     d->pauthorEMail(row) = "";
     d->pcommentsLink(row) = "";
-    d->archiveView.SetAt(findidx, row);
     markDirty();
 }
 
 QString FeedStorageMK4Impl::link(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromLatin1(d->plink(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    return link(GuidKey(guid));
+}
+
+QString FeedStorageMK4Impl::link(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? QString::fromLatin1(d->plink(d->body(findidx))) : QLatin1String("");
 }
 
 uint FeedStorageMK4Impl::pubDate(const QString &guid) const
 {
     int findidx = findArticle(guid);
-    return findidx != -1 ? d->ppubDate(d->archiveView.GetAt(findidx)) : 0;
+    return findidx != -1 ? d->ppubDate(d->headerView[findidx]) : 0;
 }
 
 int FeedStorageMK4Impl::status(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? d->pstatus(d->archiveView.GetAt(findidx)) : 0;
+    return status(GuidKey(guid));
+}
+
+int FeedStorageMK4Impl::status(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? d->pstatus(d->headerView[findidx]) : 0;
 }
 
 void FeedStorageMK4Impl::setStatus(const QString &guid, int status)
 {
-    int findidx = findArticle(guid);
+    setStatus(GuidKey(guid), status);
+}
+
+void FeedStorageMK4Impl::setStatus(const GuidKey &key, int status)
+{
+    int findidx = findArticle(key);
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pstatus(row) = status;
-    d->archiveView.SetAt(findidx, row);
+    d->pstatus(d->headerView[findidx]) = status;
     markDirty();
 }
 
 QString FeedStorageMK4Impl::title(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->ptitle(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    return title(GuidKey(guid));
+}
+
+QString FeedStorageMK4Impl::title(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? QString::fromUtf8(d->ptitle(d->body(findidx))) : QLatin1String("");
 }
 
 QString FeedStorageMK4Impl::description(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pdescription(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    return description(GuidKey(guid));
+}
+
+QString FeedStorageMK4Impl::description(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? d->text(d->body(findidx), d->pdescription, d->pdescriptionZ) : QLatin1String("");
 }
 
 QString FeedStorageMK4Impl::content(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pcontent(d->archiveView.GetAt(findidx))) : QLatin1String("");
+    return content(GuidKey(guid));
+}
+
+QString FeedStorageMK4Impl::content(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? d->text(d->body(findidx), d->pcontent, d->pcontentZ) : QLatin1String("");
 }
 
 void FeedStorageMK4Impl::setPubDate(const QString &guid, uint pubdate)
@@ -424,10 +1319,14 @@ void FeedStorageMK4Impl::setPubDate(const QString &guid, uint pubdate)
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->ppubDate(row) = pubdate;
-    d->archiveView.SetAt(findidx, row);
+    const c4_RowRef header = d->headerView[findidx];
+    const uint oldPubDate = d->ppubDate(header);
+    if (oldPubDate == pubdate) {
+        return;
+    }
+    d->unindexDate(oldPubDate, guid.toLatin1());
+    d->indexDate(pubdate, guid.toLatin1());
+    d->ppubDate(header) = pubdate;
     markDirty();
 }
 
@@ -437,10 +1336,7 @@ void FeedStorageMK4Impl::setGuidIsHash(const QString &guid, bool isHash)
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pguidIsHash(row) = isHash;
-    d->archiveView.SetAt(findidx, row);
+    d->setFlag(findidx, GuidIsHashFlag, isHash);
     markDirty();
 }
 
@@ -450,10 +1346,7 @@ void FeedStorageMK4Impl::setLink(const QString &guid, const QString &link)
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->plink(row) = !link.isEmpty() ? link.toLatin1() : "";
-    d->archiveView.SetAt(findidx, row);
+    d->plink(d->body(findidx)) = !link.isEmpty() ? link.toLatin1() : "";
     markDirty();
 }
 
@@ -463,10 +1356,7 @@ void FeedStorageMK4Impl::setHash(const QString &guid, uint hash)
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->phash(row) = hash;
-    d->archiveView.SetAt(findidx, row);
+    d->phash(d->headerView[findidx]) = hash;
     markDirty();
 }
 
@@ -476,10 +1366,7 @@ void FeedStorageMK4Impl::setTitle(const QString &guid, const QString &title)
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->ptitle(row) = !title.isEmpty() ? title.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    d->ptitle(d->body(findidx)) = !title.isEmpty() ? title.toUtf8().data() : "";
     markDirty();
 }
 
@@ -489,10 +1376,7 @@ void FeedStorageMK4Impl::setDescription(const QString &guid, const QString &desc
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pdescription(row) = !description.isEmpty() ? description.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    d->setText(d->body(findidx), d->pdescription, d->pdescriptionZ, description, d->mainStorage->compressArticles());
     markDirty();
 }
 
@@ -502,10 +1386,7 @@ void FeedStorageMK4Impl::setContent(const QString &guid, const QString &content)
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pcontent(row) = !content.isEmpty() ? content.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    d->setText(d->body(findidx), d->pcontent, d->pcontentZ, content, d->mainStorage->compressArticles());
     markDirty();
 }
 
@@ -515,10 +1396,7 @@ void FeedStorageMK4Impl::setAuthorName(const QString &guid, const QString &autho
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pauthorName(row) = !author.isEmpty() ? author.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    d->pauthorName(d->body(findidx)) = !author.isEmpty() ? author.toUtf8().data() : "";
     markDirty();
 }
 
@@ -528,10 +1406,7 @@ void FeedStorageMK4Impl::setAuthorUri(const QString &guid, const QString &author
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pauthorUri(row) = !author.isEmpty() ? author.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    d->pauthorUri(d->body(findidx)) = !author.isEmpty() ? author.toUtf8().data() : "";
     markDirty();
 }
 
@@ -541,29 +1416,41 @@ void FeedStorageMK4Impl::setAuthorEMail(const QString &guid, const QString &auth
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pauthorEMail(row) = !author.isEmpty() ? author.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    d->pauthorEMail(d->body(findidx)) = !author.isEmpty() ? author.toUtf8().data() : "";
     markDirty();
 }
 
 QString FeedStorageMK4Impl::authorName(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pauthorName(d->archiveView.GetAt(findidx))) : QString();
+    return authorName(GuidKey(guid));
+}
+
+QString FeedStorageMK4Impl::authorName(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? QString::fromUtf8(d->pauthorName(d->body(findidx))) : QString();
 }
 
 QString FeedStorageMK4Impl::authorUri(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pauthorUri(d->archiveView.GetAt(findidx))) : QString();
+    return authorUri(GuidKey(guid));
+}
+
+QString FeedStorageMK4Impl::authorUri(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? QString::fromUtf8(d->pauthorUri(d->body(findidx))) : QString();
 }
 
 QString FeedStorageMK4Impl::authorEMail(const QString &guid) const
 {
-    int findidx = findArticle(guid);
-    return findidx != -1 ? QString::fromUtf8(d->pauthorEMail(d->archiveView.GetAt(findidx))) : QString();
+    return authorEMail(GuidKey(guid));
+}
+
+QString FeedStorageMK4Impl::authorEMail(const GuidKey &key) const
+{
+    int findidx = findArticle(key);
+    return findidx != -1 ? QString::fromUtf8(d->pauthorEMail(d->body(findidx))) : QString();
 }
 
 void FeedStorageMK4Impl::setCommentsLink(const QString &guid, const QString &commentsLink)
@@ -572,10 +1459,7 @@ void FeedStorageMK4Impl::setCommentsLink(const QString &guid, const QString &com
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pcommentsLink(row) = !commentsLink.isEmpty() ? commentsLink.toUtf8().data() : "";
-    d->archiveView.SetAt(findidx, row);
+    d->pcommentsLink(d->body(findidx)) = !commentsLink.isEmpty() ? commentsLink.toUtf8().data() : "";
     markDirty();
 }
 
@@ -585,10 +1469,7 @@ void FeedStorageMK4Impl::setComments(const QString &guid, int comments)
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pcomments(row) = comments;
-    d->archiveView.SetAt(findidx, row);
+    d->pcomments(d->body(findidx)) = comments;
     markDirty();
 }
 
@@ -598,10 +1479,7 @@ void FeedStorageMK4Impl::setGuidIsPermaLink(const QString &guid, bool isPermaLin
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pguidIsPermaLink(row) = isPermaLink;
-    d->archiveView.SetAt(findidx, row);
+    d->setFlag(findidx, GuidIsPermaLinkFlag, isPermaLink);
     markDirty();
 }
 
@@ -612,88 +1490,49 @@ void FeedStorageMK4Impl::addCategory(const QString &guid, const Category &cat)
         return;
     }
 
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    c4_View catView = d->pcategories(row);
+    c4_View catView = d->pcategories(d->body(findidx));
     c4_Row findrow;
-
     d->pcatTerm(findrow) = cat.term.toUtf8().data();
     d->pcatScheme(findrow) = cat.scheme.toUtf8().data();
-
-    int catidx = catView.Find(findrow);
-    if (catidx == -1) {
-        d->pcatName(findrow) = cat.name.toUtf8().data();
-        catidx = catView.Add(findrow);
-        d->pcategories(row) = catView;
-        d->archiveView.SetAt(findidx, row);
-
-        // add to category->articles index
-        c4_Row catrow;
-        d->pcatTerm(catrow) = cat.term.toUtf8().data();
-        d->pcatScheme(catrow) = cat.scheme.toUtf8().data();
-        d->pcatName(catrow) = cat.name.toUtf8().data();
-#if 0 //category and tag support disabled
-        int catidx2 = d->catView.Find(catrow);
-
-        if (catidx2 == -1) {
-            catidx2 = d->catView.Add(catrow);
-        }
-
-        c4_Row catrow2 = d->catView.GetAt(catidx2);
-        c4_View catView2 = d->pcategorizedArticles(catrow2);
-
-        c4_Row row3;
-        d->pguid(row3) = guid.toLatin1();
-        int guididx = catView2.Find(row3);
-        if (guididx == -1) {
-            guididx = catView2.Add(row3);
-            catView2.SetAt(guididx, row3);
-            d->pcategorizedArticles(catrow2) = catView2;
-            d->catView.SetAt(catidx2, catrow2);
-        }
-#endif
-        markDirty();
+    if (catView.Find(findrow) != -1) {
+        return;
     }
+    d->pcatName(findrow) = cat.name.toUtf8().data();
+    catView.Add(findrow);
+
+    // add to category->articles index
+    c4_Row guidrow;
+    d->pguid(guidrow) = guid.toLatin1();
+    c4_View articles = d->pcategorizedArticles(d->categoryIndexView[d->findCategory(cat, true)]);
+    articles.Add(guidrow);
+    markDirty();
 }
 
 QList<Category> FeedStorageMK4Impl::categories(const QString &guid) const
 {
     QList<Category> list;
+    c4_View catView;
 
     if (!guid.isNull()) { // return categories for an article
         int findidx = findArticle(guid);
         if (findidx == -1) {
             return list;
         }
-
-        c4_Row row;
-        row = d->archiveView.GetAt(findidx);
-        c4_View catView = d->pcategories(row);
-        int size = catView.GetSize();
-
-        for (int i = 0; i < size; ++i) {
-            Category cat;
-
-            cat.term = QString::fromUtf8(d->pcatTerm(catView.GetAt(i)));
-            cat.scheme = QString::fromUtf8(d->pcatScheme(catView.GetAt(i)));
-            cat.name = QString::fromUtf8(d->pcatName(catView.GetAt(i)));
-
-            list += cat;
-        }
+        catView = d->pcategories(d->body(findidx));
     } else { // return all categories in the feed
-#if 0 //category and tag support disabled
-        int size = d->catView.GetSize();
-        for (int i = 0; i < size; ++i) {
-            c4_Row row = d->catView.GetAt(i);
+        ensureOpen();
+        catView = d->categoryIndexView;
+    }
 
-            Category cat;
-            cat.term = QString(d->pcatTerm(row));
-            cat.scheme = QString(d->pcatScheme(row));
-            cat.name = QString(d->pcatName(row));
+    int size = catView.GetSize();
+    for (int i = 0; i < size; ++i) {
+        Category cat;
 
-            list += cat;
-        }
-#endif
+        cat.term = QString::fromUtf8(d->pcatTerm(catView[i]));
+        cat.scheme = QString::fromUtf8(d->pcatScheme(catView[i]));
+        cat.name = QString::fromUtf8(d->pcatName(catView[i]));
+
+        list += cat;
     }
 
     return list;
@@ -701,116 +1540,75 @@ QList<Category> FeedStorageMK4Impl::categories(const QString &guid) const
 
 void FeedStorageMK4Impl::addTag(const QString &guid, const QString &tag)
 {
-#if 0 //category and tag support disabled
     int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
     }
 
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    c4_View tagView = d->ptags(row);
+    c4_View tagView = d->ptags(d->body(findidx));
     c4_Row findrow;
     d->ptag(findrow) = tag.toUtf8().data();
-    int tagidx = tagView.Find(findrow);
-    if (tagidx == -1) {
-        tagidx = tagView.Add(findrow);
-        d->ptags(row) = tagView;
-        d->archiveView.SetAt(findidx, row);
-
-        // add to tag->articles index
-        c4_Row tagrow;
-        d->ptag(tagrow) = tag.toUtf8().data();
-        int tagidx2 = d->tagView.Find(tagrow);
-        if (tagidx2 == -1) {
-            tagidx2 = d->tagView.Add(tagrow);
-        }
-        tagrow = d->tagView.GetAt(tagidx2);
-        c4_View tagView2 = d->ptaggedArticles(tagrow);
-
-        c4_Row row3;
-        d->pguid(row3) = guid.toLatin1();
-        int guididx = tagView2.Find(row3);
-        if (guididx == -1) {
-            guididx = tagView2.Add(row3);
-            tagView2.SetAt(guididx, row3);
-            d->ptaggedArticles(tagrow) = tagView2;
-            d->tagView.SetAt(tagidx2, tagrow);
-        }
-        markDirty();
+    if (tagView.Find(findrow) != -1) {
+        return;
     }
-#endif
+    tagView.Add(findrow);
+
+    // add to tag->articles index
+    c4_Row guidrow;
+    d->pguid(guidrow) = guid.toLatin1();
+    c4_View articles = d->ptaggedArticles(d->tagIndexView[d->findTag(tag, true)]);
+    articles.Add(guidrow);
+    markDirty();
 }
 
 void FeedStorageMK4Impl::removeTag(const QString &guid, const QString &tag)
 {
-#if 0 //category and tag support disabled
     int findidx = findArticle(guid);
     if (findidx == -1) {
         return;
     }
 
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    c4_View tagView = d->ptags(row);
+    c4_View tagView = d->ptags(d->body(findidx));
     c4_Row findrow;
     d->ptag(findrow) = tag.toUtf8().data();
-    int tagidx = tagView.Find(findrow);
-    if (tagidx != -1) {
-        tagView.RemoveAt(tagidx);
-        d->ptags(row) = tagView;
-        d->archiveView.SetAt(findidx, row);
-
-        // remove from tag->articles index
-        c4_Row tagrow;
-        d->ptag(tagrow) = tag.toUtf8().data();
-        int tagidx2 = d->tagView.Find(tagrow);
-        if (tagidx2 != -1) {
-            tagrow = d->tagView.GetAt(tagidx2);
-            c4_View tagView2 = d->ptaggedArticles(tagrow);
-
-            c4_Row row3;
-            d->pguid(row3) = guid.toLatin1();
-            int guididx = tagView2.Find(row3);
-            if (guididx != -1) {
-                tagView2.RemoveAt(guididx);
-                d->ptaggedArticles(tagrow) = tagView2;
-                d->tagView.SetAt(tagidx2, tagrow);
-            }
+    const int tagidx = tagView.Find(findrow);
+    if (tagidx == -1) {
+        return;
+    }
+    tagView.RemoveAt(tagidx);
+
+    // remove from tag->articles index
+    const int tagidx2 = d->findTag(tag, false);
+    if (tagidx2 != -1) {
+        c4_View articles = d->ptaggedArticles(d->tagIndexView[tagidx2]);
+        removeGuid(articles, d->pguid, guid.toLatin1());
+        if (articles.GetSize() == 0) {
+            d->tagIndexView.RemoveAt(tagidx2);
         }
-
-        markDirty();
     }
-#endif
+    markDirty();
 }
 
 QStringList FeedStorageMK4Impl::tags(const QString &guid) const
 {
-    Q_UNUSED(guid);
-//TODO what is the need of the unused parameter(s)?
     QStringList list;
-#if 0 //category and tag support disabled
+    c4_View tagView;
+
     if (!guid.isNull()) { // return tags for an articles
         int findidx = findArticle(guid);
         if (findidx == -1) {
             return list;
         }
-
-        c4_Row row;
-        row = d->archiveView.GetAt(findidx);
-        c4_View tagView = d->ptags(row);
-        int size = tagView.GetSize();
-
-        for (int i = 0; i < size; ++i) {
-            list += QString::fromUtf8(d->ptag(tagView.GetAt(i)));
-        }
+        tagView = d->ptags(d->body(findidx));
     } else { // return all tags in the feed
-        int size = d->tagView.GetSize();
-        for (int i = 0; i < size; ++i) {
-            list += QString(d->ptag(d->tagView.GetAt(i)));
-        }
+        ensureOpen();
+        tagView = d->tagIndexView;
+    }
+
+    int size = tagView.GetSize();
+    for (int i = 0; i < size; ++i) {
+        list += QString::fromUtf8(d->ptag(tagView[i]));
     }
-#endif
     return list;
 }
 
@@ -823,31 +1621,30 @@ void FeedStorageMK4Impl::add(FeedStorage *source)
     setUnread(source->unread());
     setLastFetch(source->lastFetch());
     setTotalCount(source->totalCount());
+
+    QString etag;
+    QString lastModified;
+    source->httpValidators(etag, lastModified);
+    setHttpValidators(etag, lastModified);
+    setContentDigest(source->contentDigest());
 }
 
 void FeedStorageMK4Impl::copyArticle(const QString &guid, FeedStorage *source)
 {
-    if (!contains(guid)) {
-        addEntry(guid);
-    }
-    setComments(guid, source->comments(guid));
-    setCommentsLink(guid, source->commentsLink(guid));
-    setDescription(guid, source->description(guid));
-    setGuidIsHash(guid, source->guidIsHash(guid));
-    setGuidIsPermaLink(guid, source->guidIsPermaLink(guid));
-    setHash(guid, source->hash(guid));
-    setLink(guid, source->link(guid));
-    setPubDate(guid, source->pubDate(guid));
-    setStatus(guid, source->status(guid));
-    setTitle(guid, source->title(guid));
-    setAuthorName(guid, source->authorName(guid));
-    setAuthorUri(guid, source->authorUri(guid));
-    setAuthorEMail(guid, source->authorEMail(guid));
+    ArticleRecord record;
+    if (!source->readArticle(guid, record)) {
+        return;
+    }
+    writeArticle(guid, record);
 
     QStringList tags = source->tags(guid);
     for (QStringList::ConstIterator it = tags.constBegin(); it != tags.constEnd(); ++it) {
         addTag(guid, *it);
     }
+    const QList<Category> categories = source->categories(guid);
+    for (const Category &cat : categories) {
+        addCategory(guid, cat);
+    }
 }
 
 void FeedStorageMK4Impl::setEnclosure(const QString &guid, const QString &url, const QString &type, int length)
@@ -856,14 +1653,11 @@ void FeedStorageMK4Impl::setEnclosure(const QString &guid, const QString &url, c
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pHasEnclosure(row) = true;
+    d->setFlag(findidx, HasEnclosureFlag, true);
+    const c4_RowRef row = d->body(findidx);
     d->pEnclosureUrl(row) = !url.isEmpty() ? url.toUtf8().data() : "";
     d->pEnclosureType(row) = !type.isEmpty() ? type.toUtf8().data() : "";
     d->pEnclosureLength(row) = length;
-
-    d->archiveView.SetAt(findidx, row);
     markDirty();
 }
 
@@ -873,20 +1667,22 @@ void FeedStorageMK4Impl::removeEnclosure(const QString &guid)
     if (findidx == -1) {
         return;
     }
-    c4_Row row;
-    row = d->archiveView.GetAt(findidx);
-    d->pHasEnclosure(row) = false;
+    d->setFlag(findidx, HasEnclosureFlag, false);
+    const c4_RowRef row = d->body(findidx);
     d->pEnclosureUrl(row) = "";
     d->pEnclosureType(row) = "";
     d->pEnclosureLength(row) = -1;
-
-    d->archiveView.SetAt(findidx, row);
     markDirty();
 }
 
 void FeedStorageMK4Impl::enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const
 {
-    int findidx = findArticle(guid);
+    enclosure(GuidKey(guid), hasEnclosure, url, type, length);
+}
+
+void FeedStorageMK4Impl::enclosure(const GuidKey &key, bool &hasEnclosure, QString &url, QString &type, int &length) const
+{
+    int findidx = findArticle(key);
     if (findidx == -1) {
         hasEnclosure = false;
         url.clear();
@@ -894,8 +1690,8 @@ void FeedStorageMK4Impl::enclosure(const QString &guid, bool &hasEnclosure, QStr
         length = -1;
         return;
     }
-    c4_Row row = d->archiveView.GetAt(findidx);
-    hasEnclosure = d->pHasEnclosure(row);
+    hasEnclosure = d->hasFlag(findidx, HasEnclosureFlag);
+    const c4_RowRef row = d->body(findidx);
     url = QLatin1String(d->pEnclosureUrl(row));
     type = QLatin1String(d->pEnclosureType(row));
     length = d->pEnclosureLength(row);
@@ -903,7 +1699,14 @@ void FeedStorageMK4Impl::enclosure(const QString &guid, bool &hasEnclosure, QStr
 
 void FeedStorageMK4Impl::clear()
 {
-    d->storage->RemoveAll();
+    ensureOpen();
+    d->headerView.RemoveAll();
+    d->bodyView.RemoveAll();
+    d->tagIndexView.RemoveAll();
+    d->categoryIndexView.RemoveAll();
+    d->dateIndexView.RemoveAll();
+    d->freeBodies.clear();
+    d->freeBodiesScanned = true;
 
     setUnread(0);
     markDirty();
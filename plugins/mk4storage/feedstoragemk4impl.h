@@ -25,6 +25,7 @@
 #define AKREGATOR_BACKEND_FEEDSTORAGEMK4IMPL_H
 
 #include "feedstorage.h"
+
 namespace Akregator {
 namespace Backend {
 class StorageMK4Impl;
@@ -43,14 +44,23 @@ public:
     int totalCount() const override;
     int lastFetch() const override;
     void setLastFetch(int lastFetch) override;
+    void httpValidators(QString &etag, QString &lastModified) const override;
+    void setHttpValidators(const QString &etag, const QString &lastModified) override;
+    QByteArray contentDigest() const override;
+    void setContentDigest(const QByteArray &digest) override;
 
     QStringList articles(const QString &tag = QString()) const override;
 
     QStringList articles(const Category &cat) const override;
+    ArticleHeaders articleHeaders() const override;
+    ArticleHeaders articleHeadersByDate(uint from, uint to, int limit = -1) const override;
 
     bool contains(const QString &guid) const override;
     void addEntry(const QString &guid) override;
     void deleteArticle(const QString &guid) override;
+    bool readArticle(const QString &guid, ArticleRecord &record) const override;
+    void writeArticle(const QString &guid, const ArticleRecord &record) override;
+    void applyChanges(const QHash<QString, ArticleRecord> &records, const QStringList &deleted, int unread) override;
     int comments(const QString &guid) const override;
     QString commentsLink(const QString &guid) const override;
     void setCommentsLink(const QString &guid, const QString &commentsLink) override;
@@ -79,6 +89,25 @@ public:
     void removeEnclosure(const QString &guid) override;
     void enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const override;
 
+    bool contains(const GuidKey &key) const override;
+    uint hash(const GuidKey &key) const override;
+    bool readArticle(const GuidKey &key, ArticleRecord &record) const override;
+    void writeArticle(const GuidKey &key, const ArticleRecord &record) override;
+    int status(const GuidKey &key) const override;
+    void setStatus(const GuidKey &key, int status) override;
+    QString title(const GuidKey &key) const override;
+    QString description(const GuidKey &key) const override;
+    QString content(const GuidKey &key) const override;
+    QString link(const GuidKey &key) const override;
+    QString commentsLink(const GuidKey &key) const override;
+    int comments(const GuidKey &key) const override;
+    bool guidIsHash(const GuidKey &key) const override;
+    bool guidIsPermaLink(const GuidKey &key) const override;
+    QString authorName(const GuidKey &key) const override;
+    QString authorUri(const GuidKey &key) const override;
+    QString authorEMail(const GuidKey &key) const override;
+    void enclosure(const GuidKey &key, bool &hasEnclosure, QString &url, QString &type, int &length) const override;
+
     void addTag(const QString &guid, const QString &tag) override;
     void removeTag(const QString &guid, const QString &tag) override;
     QStringList tags(const QString &guid = QString()) const override;
@@ -97,13 +126,44 @@ public:
     void close() override;
     void commit() override;
     void rollback() override;
+    void pin() override;
+    void unpin() override;
 
     void convertOldArchive() override;
+
+    /** returns the description of the view holding the tables of all feeds in the single file layout, one row per table number */
+    static QByteArray feedTablesDescription();
+
+    /** returns whether the metakit file is currently open */
+    bool isOpen() const;
+    /** returns whether the archive must not be closed to save resources */
+    bool isPinned() const;
+    /** returns a counter value telling when the archive was accessed last, for least-recently-used eviction */
+    quint64 lastUse() const;
+    /** commits pending changes and closes the metakit file. The archive is reopened transparently on the next access. */
+    void release();
+    /** converts up to @p budget article bodies to compressed or plain storage as given by @p compress
+        and decreases @p budget accordingly. Returns @c true once all bodies of the archive are converted. */
+    bool recompressBodies(bool compress, int &budget);
+    /** rewrites the metakit file without the free space left behind by deleted data, if enough can be reclaimed,
+        the archive is neither in use nor modified and the file is not larger than @p maxSize. The copy is written
+        synchronously, @p maxSize bounds the time this takes. Returns the number of bytes reclaimed, -1 if the archive
+        was not compacted. Not supported for feeds stored in the single file layout. */
+    qint64 compact(qint64 maxSize);
 private:
-    void markDirty();
+    /** opens the metakit file if needed and records the access **/
+    void ensureOpen() const;
+    /** sets up the header and body views of the open metakit storage, converting archives of older schema versions **/
+    void openViews() const;
+    /** @param bytes size of the data written in bytes, used by the storage to decide when to commit */
+    void markDirty(int bytes = 0);
     /** finds article by guid, returns -1 if not in archive **/
     int findArticle(const QString &guid) const;
+    int findArticle(const GuidKey &key) const;
     void setTotalCount(int total);
+    /** writes the fields of @p record to the row of @p key without updating counters, adding the number of bytes stored to @p bytes.
+        Returns @c true if the row was added **/
+    bool storeArticle(const GuidKey &key, const ArticleRecord &record, int &bytes);
     class FeedStorageMK4ImplPrivate;
     FeedStorageMK4ImplPrivate *d;
 };
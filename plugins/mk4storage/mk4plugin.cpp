@@ -37,10 +37,13 @@ void MK4Plugin::doInitialize()
 {
     m_factory = new StorageFactoryMK4Impl();
     StorageFactoryRegistry::self()->registerFactory(m_factory, QStringLiteral("metakit"));
+    m_singleFileFactory = new StorageFactoryMK4Impl(StorageMK4Impl::SingleFile);
+    StorageFactoryRegistry::self()->registerFactory(m_singleFileFactory, m_singleFileFactory->key());
 }
 
 MK4Plugin::MK4Plugin(QObject *parent, const QVariantList &params) : Plugin(parent, params)
     , m_factory(0)
+    , m_singleFileFactory(0)
 {
 }
 
@@ -48,6 +51,8 @@ MK4Plugin::~MK4Plugin()
 {
     StorageFactoryRegistry::self()->unregisterFactory(QStringLiteral("metakit"));
     delete m_factory;
+    StorageFactoryRegistry::self()->unregisterFactory(QStringLiteral("metakit-single"));
+    delete m_singleFileFactory;
 }
 } // namespace Backend
 } // namespace Akregator
@@ -45,6 +45,7 @@ private:
 
 private:
     StorageFactory *m_factory;
+    StorageFactory *m_singleFileFactory;
 };
 } // namespace Backend
 } // namespace Akregator
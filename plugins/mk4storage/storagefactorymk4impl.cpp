@@ -30,21 +30,26 @@
 
 namespace Akregator {
 namespace Backend {
+StorageFactoryMK4Impl::StorageFactoryMK4Impl(StorageMK4Impl::Layout layout)
+    : m_layout(layout)
+{
+}
+
 Storage *StorageFactoryMK4Impl::createStorage(const QStringList &params) const
 {
-    Storage *storage = new StorageMK4Impl;
+    Storage *storage = new StorageMK4Impl(m_layout);
     storage->initialize(params);
     return storage;
 }
 
 QString StorageFactoryMK4Impl::key() const
 {
-    return QStringLiteral("metakit");
+    return m_layout == StorageMK4Impl::SingleFile ? QStringLiteral("metakit-single") : QStringLiteral("metakit");
 }
 
 QString StorageFactoryMK4Impl::name() const
 {
-    return i18n("Metakit");
+    return m_layout == StorageMK4Impl::SingleFile ? i18n("Metakit (single file)") : i18n("Metakit");
 }
 
 void StorageFactoryMK4Impl::configure()
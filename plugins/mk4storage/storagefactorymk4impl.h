@@ -26,6 +26,7 @@
 #define AKREGATOR_BACKEND_STORAGEFACTORYMK4IMPL_H
 
 #include "storagefactory.h"
+#include "storagemk4impl.h"
 #include <QString>
 class QStringList;
 
@@ -36,6 +37,8 @@ class Storage;
 class StorageFactoryMK4Impl : public StorageFactory
 {
 public:
+    explicit StorageFactoryMK4Impl(StorageMK4Impl::Layout layout = StorageMK4Impl::FilePerFeed);
+
     QString key() const override;
     QString name() const override;
     void configure() override;
@@ -44,6 +47,9 @@ public:
     {
         return false;
     }
+
+private:
+    StorageMK4Impl::Layout m_layout;
 };
 } // namespace Backend
 } // namespace Akregator
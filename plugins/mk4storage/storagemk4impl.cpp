@@ -24,28 +24,64 @@
 */
 #include "storagemk4impl.h"
 #include "feedstoragemk4impl.h"
+#include "akregatorconfig.h"
+#include "akregator_mk4storage_debug.h"
 
 #include <mk4.h>
 
+#include <QElapsedTimer>
+#include <QFile>
+#include <QVector>
 #include <QMap>
+#include <QSet>
 #include <QString>
 #include <QStringList>
 #include <QTimer>
 
-#include <qdebug.h>
 #include <QDir>
 #include <QStandardPaths>
 
+#include <algorithm>
+
+namespace {
+/** changes are committed after this quiet period... */
+const int CommitDelay = 3000;
+/** ...but not later than this after the first change */
+const int MaxCommitDelay = 30000;
+/** commit right away once this many bytes of article data are pending */
+const qint64 CommitByteBudget = 4 * 1024 * 1024;
+/** the conversion of article bodies after a change of the compression setting starts this long after opening... */
+const int RecompressStartDelay = 60000;
+/** ...and converts this many bodies at a time, with this pause in between */
+const int RecompressBatchSize = 200;
+const int RecompressInterval = 250;
+/** compaction of fragmented feed archives starts this long after opening... */
+const int CompactStartDelay = 5 * 60 * 1000;
+/** ...and rewrites at most one archive per interval, waiting until nothing was written for the idle time */
+const int CompactInterval = 2000;
+const int CompactIdleTime = 30000;
+/** archives are rewritten on the GUI thread, metakit is not thread-safe. Larger ones are left alone to keep each
+    rewrite short, and the pause after a rewrite is at least this many times its duration */
+const qint64 CompactMaxSize = 8 * 1024 * 1024;
+const int CompactPauseFactor = 20;
+}
+
 class Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate
 {
 public:
     StorageMK4ImplPrivate() : modified(false)
+        , layout(StorageMK4Impl::FilePerFeed)
         , purl("url")
         , pFeedList("feedList")
         , pTagSet("tagSet")
         , punread("unread")
         , ptotalCount("totalCount")
         , plastFetch("lastFetch")
+        , petag("etag")
+        , plastModified("lastModified")
+        , pcontentDigest("contentDigest")
+        , ptable("table")
+        , pconvertedMode("convertedMode")
     {
     }
 
@@ -54,29 +90,238 @@ public:
     c4_View archiveView;
     bool autoCommit;
     bool modified;
+    StorageMK4Impl::Layout layout;
     mutable QMap<QString, Akregator::Backend::FeedStorageMK4Impl *> feeds;
     QStringList feedURLs;
     c4_StringProp purl, pFeedList, pTagSet;
     c4_IntProp punread, ptotalCount, plastFetch;
+    c4_StringProp petag, plastModified;
+    c4_BytesProp pcontentDigest;
+    c4_IntProp ptable;
     QString archivePath;
+    /** number of the next feed table to create in the single file layout */
+    int nextTable = 0;
+
+    /** the views of all feeds in the single file layout, see FeedStorageMK4Impl::feedTablesDescription() */
+    c4_View feedTablesView;
 
-    c4_Storage *feedListStorage;
+    /** the feed list backup has a file of its own, except in the single file layout */
+    c4_Storage *feedListStorage = nullptr;
     c4_View feedListView;
 
+    /** feed storages modified since the last commit, so that a commit does not need to visit every feed */
+    QSet<Akregator::Backend::FeedStorageMK4Impl *> dirtyFeeds;
+    /** estimated size of the article data written since the last commit */
+    qint64 pendingBytes = 0;
+    QTimer *commitTimer = nullptr;
+    QElapsedTimer dirtySince;
+
+    /** drives the conversion of existing article bodies to the configured storage form */
+    QTimer *recompressTimer = nullptr;
+    /** whether a conversion was started since opening, and for which compression setting */
+    bool recompressStarted = false;
+    bool recompressMode = false;
+    /** feeds left to convert */
+    QStringList recompressQueue;
+    /** remembers the form all article bodies were converted to, -1 while unknown or converting */
+    c4_View stateView;
+    c4_IntProp pconvertedMode;
+
+    QTimer *compactTimer = nullptr;
+    /** feeds whose archive is still to be checked for compaction */
+    QStringList compactQueue;
+    int compactedFeeds = 0;
+    qint64 compactReclaimed = 0;
+    /** time since the last change, compaction waits for the storage to be idle */
+    QElapsedTimer lastActivity;
+
+    /** feed storages whose metakit file is currently open */
+    QSet<Akregator::Backend::FeedStorageMK4Impl *> openFeeds;
+    quint64 useCounter = 0;
+
     Akregator::Backend::FeedStorageMK4Impl *createFeedStorage(const QString &url);
+    void scheduleCommit();
+    /** starts converting the article bodies if the compression setting changed since the last run */
+    void startRecompression(int delay);
+    int convertedMode() const;
+    void setConvertedMode(int mode);
+    /** continues with the next feed to compact after @p delay, or reports the result of the run */
+    void scheduleCompaction(int delay);
+    void releaseArchives(Akregator::Backend::FeedStorageMK4Impl *keep, int limit);
+    void openSingleFile();
+    void migrateArchives();
+    /** returns the index row of @p key, -1 if the feed is not in the archive */
+    int findFeed(const Akregator::Backend::FeedKey &key) const;
 };
 
-Akregator::Backend::StorageMK4Impl::StorageMK4Impl() : d(new StorageMK4ImplPrivate)
+int Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::findFeed(const Akregator::Backend::FeedKey &key) const
+{
+    // index rows are only ever appended, so the row found last time is almost always still right
+    const int hint = key.hint();
+    if (hint != -1 && hint < archiveView.GetSize() && key.latin1() == static_cast<const char *>(purl(archiveView.GetAt(hint)))) {
+        return hint;
+    }
+    c4_Row findrow;
+    purl(findrow) = key.latin1().constData();
+    const int findidx = archiveView.Find(findrow);
+    key.setHint(findidx);
+    return findidx;
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::openSingleFile()
+{
+    const QString filePath = archivePath + QLatin1String("/archive.mk4");
+    const bool migrate = !QFile::exists(filePath) && QFile::exists(archivePath + QLatin1String("/archiveindex.mk4"));
+
+    storage = new c4_Storage(filePath.toLocal8Bit(), true);
+    archiveView = storage->GetAs("archive[url:S,unread:I,totalCount:I,lastFetch:I,etag:S,lastModified:S,contentDigest:B,table:I]");
+    c4_View hash = storage->GetAs("archiveHash[_H:I,_R:I]");
+    archiveView = archiveView.Hash(hash, 1); // hash on url
+    feedListView = storage->GetAs("feedListBackup[feedList:S,tagSet:S]");
+    stateView = storage->GetAs("storageState[convertedMode:I]");
+    feedTablesView = storage->GetAs(Akregator::Backend::FeedStorageMK4Impl::feedTablesDescription().constData());
+
+    const int size = archiveView.GetSize();
+    for (int i = 0; i < size; ++i) {
+        nextTable = qMax(nextTable, ptable(archiveView.GetAt(i)) + 1);
+    }
+
+    if (migrate) {
+        migrateArchives();
+    }
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::migrateArchives()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // the per-feed files are left in place, so switching back to the old layout keeps working
+    StorageMK4Impl source(StorageMK4Impl::FilePerFeed);
+    source.setArchivePath(archivePath);
+    source.open(false);
+    q->add(&source);
+    q->storeFeedList(source.restoreFeedList());
+    q->storeTagSet(source.restoreTagSet());
+    q->commit();
+
+    qCDebug(AKREGATOR_MK4_LOG) << "Migrated" << archiveView.GetSize() << "feed archives into a single file in" << timer.elapsed() << "ms";
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::releaseArchives(Akregator::Backend::FeedStorageMK4Impl *keep, int limit)
+{
+    QVector<Akregator::Backend::FeedStorageMK4Impl *> candidates;
+    candidates.reserve(openFeeds.count());
+    for (Akregator::Backend::FeedStorageMK4Impl *fs : qAsConst(openFeeds)) {
+        if (fs != keep && !fs->isPinned()) {
+            candidates.append(fs);
+        }
+    }
+
+    // close a few more than necessary, so that the next opens do not have to scan again
+    const int count = qMin(candidates.count(), openFeeds.count() - limit + limit / 10);
+    if (count <= 0) {
+        return;
+    }
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [](const Akregator::Backend::FeedStorageMK4Impl *lhs, const Akregator::Backend::FeedStorageMK4Impl *rhs) {
+        return lhs->lastUse() < rhs->lastUse();
+    });
+    for (int i = 0; i < count; ++i) {
+        candidates.at(i)->release();
+    }
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::scheduleCommit()
+{
+    if (pendingBytes >= CommitByteBudget) {
+        // slotCommit() only commits a modified storage
+        if (!modified) {
+            modified = true;
+            dirtySince.start();
+        }
+        commitTimer->start(0);
+        return;
+    }
+    if (!modified) {
+        modified = true;
+        dirtySince.start();
+        commitTimer->start(CommitDelay);
+        return;
+    }
+    // more changes arrive: wait for them to settle, but do not defer the commit forever
+    const qint64 remaining = MaxCommitDelay - dirtySince.elapsed();
+    commitTimer->start(static_cast<int>(qBound<qint64>(0, remaining, CommitDelay)));
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::startRecompression(int delay)
+{
+    const bool compress = q->compressArticles();
+    if (recompressStarted && recompressMode == compress) {
+        return;
+    }
+    recompressStarted = true;
+    recompressMode = compress;
+    if (convertedMode() == int(compress)) {
+        // converted in an earlier session, no need to open every archive again
+        recompressTimer->stop();
+        recompressQueue.clear();
+        return;
+    }
+    // every feed remembers the form it was converted to and is skipped quickly if it matches
+    setConvertedMode(-1);
+    recompressQueue = q->feeds();
+    recompressTimer->start(delay);
+}
+
+int Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::convertedMode() const
+{
+    return stateView.GetSize() > 0 ? pconvertedMode(stateView.GetAt(0)) : -1;
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::setConvertedMode(int mode)
+{
+    if (convertedMode() == mode) {
+        return;
+    }
+    c4_Row row;
+    pconvertedMode(row) = mode;
+    if (stateView.GetSize() == 0) {
+        stateView.Add(row);
+    } else {
+        stateView.SetAt(0, row);
+    }
+    q->markDirty();
+}
+
+void Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::scheduleCompaction(int delay)
+{
+    if (!compactQueue.isEmpty()) {
+        compactTimer->start(delay);
+    } else if (compactedFeeds > 0) {
+        qCDebug(AKREGATOR_MK4_LOG) << "Compacted" << compactedFeeds << "feed archives, reclaimed" << compactReclaimed << "bytes";
+    }
+}
+
+Akregator::Backend::StorageMK4Impl::StorageMK4Impl(Layout layout) : d(new StorageMK4ImplPrivate)
 {
     d->q = this;
+    d->layout = layout;
+    d->commitTimer = new QTimer(this);
+    d->commitTimer->setSingleShot(true);
+    connect(d->commitTimer, &QTimer::timeout, this, &StorageMK4Impl::slotCommit);
+    d->recompressTimer = new QTimer(this);
+    d->recompressTimer->setSingleShot(true);
+    connect(d->recompressTimer, &QTimer::timeout, this, &StorageMK4Impl::slotRecompress);
+    d->compactTimer = new QTimer(this);
+    d->compactTimer->setSingleShot(true);
+    connect(d->compactTimer, &QTimer::timeout, this, &StorageMK4Impl::slotCompact);
     setArchivePath(QString());
 }
 
 Akregator::Backend::FeedStorageMK4Impl *Akregator::Backend::StorageMK4Impl::StorageMK4ImplPrivate::createFeedStorage(const QString &url)
 {
     if (!feeds.contains(url)) {
-        Akregator::Backend::FeedStorageMK4Impl *fs = new Akregator::Backend::FeedStorageMK4Impl(url, q);
-        feeds[url] = fs;
         c4_Row findrow;
         purl(findrow) = url.toLatin1();
         int findidx = archiveView.Find(findrow);
@@ -84,9 +329,15 @@ Akregator::Backend::FeedStorageMK4Impl *Akregator::Backend::StorageMK4Impl::Stor
             punread(findrow) = 0;
             ptotalCount(findrow) = 0;
             plastFetch(findrow) = 0;
+            if (layout == StorageMK4Impl::SingleFile) {
+                ptable(findrow) = nextTable++;
+            }
             archiveView.Add(findrow);
             modified = true;
         }
+        // the index row must exist before, it tells the feed storage its table
+        Akregator::Backend::FeedStorageMK4Impl *fs = new Akregator::Backend::FeedStorageMK4Impl(url, q);
+        feeds[url] = fs;
         fs->convertOldArchive();
     }
     return feeds[url];
@@ -116,6 +367,26 @@ QString Akregator::Backend::StorageMK4Impl::archivePath() const
     return d->archivePath;
 }
 
+c4_Storage *Akregator::Backend::StorageMK4Impl::sharedStorage() const
+{
+    return d->layout == SingleFile ? d->storage : nullptr;
+}
+
+int Akregator::Backend::StorageMK4Impl::tableFor(const FeedKey &key) const
+{
+    int findidx = d->findFeed(key);
+
+    return findidx != -1 ? d->ptable(d->archiveView.GetAt(findidx)) : -1;
+}
+
+c4_RowRef Akregator::Backend::StorageMK4Impl::feedTables(int table)
+{
+    if (table >= d->feedTablesView.GetSize()) {
+        d->feedTablesView.SetSize(table + 1);
+    }
+    return d->feedTablesView[table];
+}
+
 QString Akregator::Backend::StorageMK4Impl::defaultArchivePath()
 {
     const QString ret = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/akregator/Archive");
@@ -136,16 +407,31 @@ void Akregator::Backend::StorageMK4Impl::initialize(const QStringList &)
 
 bool Akregator::Backend::StorageMK4Impl::open(bool autoCommit)
 {
+    if (d->layout == SingleFile) {
+        d->autoCommit = autoCommit;
+        d->openSingleFile();
+        d->startRecompression(RecompressStartDelay);
+        return true;
+    }
+
     QString filePath = d->archivePath + QLatin1String("/archiveindex.mk4");
     d->storage = new c4_Storage(filePath.toLocal8Bit(), true);
-    d->archiveView = d->storage->GetAs("archive[url:S,unread:I,totalCount:I,lastFetch:I]");
+    d->archiveView = d->storage->GetAs("archive[url:S,unread:I,totalCount:I,lastFetch:I,etag:S,lastModified:S,contentDigest:B]");
     c4_View hash = d->storage->GetAs("archiveHash[_H:I,_R:I]");
     d->archiveView = d->archiveView.Hash(hash, 1); // hash on url
+    d->stateView = d->storage->GetAs("storageState[convertedMode:I]");
     d->autoCommit = autoCommit;
 
     filePath = d->archivePath + QLatin1String("/feedlistbackup.mk4");
     d->feedListStorage = new c4_Storage(filePath.toLocal8Bit(), true);
     d->feedListView = d->feedListStorage->GetAs("archive[feedList:S,tagSet:S]");
+    d->startRecompression(RecompressStartDelay);
+
+    // the single file is shared by all open feed storages and not compacted
+    d->compactQueue = feeds();
+    d->compactedFeeds = 0;
+    d->compactReclaimed = 0;
+    d->compactTimer->start(CompactStartDelay);
     return true;
 }
 
@@ -162,30 +448,53 @@ bool Akregator::Backend::StorageMK4Impl::close()
         it.value()->close();
         delete it.value();
     }
+    d->feeds.clear();
+    d->dirtyFeeds.clear();
+    d->openFeeds.clear();
+    d->recompressTimer->stop();
+    d->recompressQueue.clear();
+    d->recompressStarted = false;
+    d->compactTimer->stop();
+    d->compactQueue.clear();
     if (d->autoCommit) {
         d->storage->Commit();
     }
 
+    d->stateView = c4_View();
+    d->feedTablesView = c4_View();
     delete d->storage;
     d->storage = 0;
 
-    d->feedListStorage->Commit();
-    delete d->feedListStorage;
-    d->feedListStorage = 0;
+    if (d->feedListStorage) {
+        d->feedListStorage->Commit();
+        delete d->feedListStorage;
+        d->feedListStorage = 0;
+    }
 
     return true;
 }
 
 bool Akregator::Backend::StorageMK4Impl::commit()
 {
-    QMap<QString, FeedStorageMK4Impl *>::Iterator it;
-    QMap<QString, FeedStorageMK4Impl *>::Iterator end(d->feeds.end());
-    for (it = d->feeds.begin(); it != end; ++it) {
-        it.value()->commit();
+    QElapsedTimer timer;
+    timer.start();
+
+    const int files = d->dirtyFeeds.count();
+    for (FeedStorageMK4Impl *fs : qAsConst(d->dirtyFeeds)) {
+        fs->commit();
     }
+    d->dirtyFeeds.clear();
+
+    const qint64 bytes = d->pendingBytes;
+    d->pendingBytes = 0;
+    d->commitTimer->stop();
+    d->modified = false;
 
     if (d->storage) {
         d->storage->Commit();
+        qCDebug(AKREGATOR_MK4_LOG) << "Committed" << files << "feed archives," << bytes << "bytes of article data in" << timer.elapsed() << "ms";
+        // picks up a change of the compression setting
+        d->startRecompression(RecompressStartDelay);
         return true;
     }
 
@@ -199,6 +508,8 @@ bool Akregator::Backend::StorageMK4Impl::rollback()
     for (it = d->feeds.begin(); it != end; ++it) {
         it.value()->rollback();
     }
+    d->dirtyFeeds.clear();
+    d->pendingBytes = 0;
 
     if (d->storage) {
         d->storage->Rollback();
@@ -209,82 +520,189 @@ bool Akregator::Backend::StorageMK4Impl::rollback()
 
 int Akregator::Backend::StorageMK4Impl::unreadFor(const QString &url) const
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
+    return unreadFor(FeedKey(url));
+}
+
+void Akregator::Backend::StorageMK4Impl::setUnreadFor(const QString &url, int unread)
+{
+    setUnreadFor(FeedKey(url), unread);
+}
+
+int Akregator::Backend::StorageMK4Impl::totalCountFor(const QString &url) const
+{
+    return totalCountFor(FeedKey(url));
+}
 
+void Akregator::Backend::StorageMK4Impl::setTotalCountFor(const QString &url, int total)
+{
+    setTotalCountFor(FeedKey(url), total);
+}
+
+int Akregator::Backend::StorageMK4Impl::lastFetchFor(const QString &url) const
+{
+    return lastFetchFor(FeedKey(url));
+}
+
+void Akregator::Backend::StorageMK4Impl::setLastFetchFor(const QString &url, int lastFetch)
+{
+    setLastFetchFor(FeedKey(url), lastFetch);
+}
+
+int Akregator::Backend::StorageMK4Impl::unreadFor(const FeedKey &key) const
+{
+    int findidx = d->findFeed(key);
     return findidx != -1 ? d->punread(d->archiveView.GetAt(findidx)) : 0;
 }
 
-void Akregator::Backend::StorageMK4Impl::setUnreadFor(const QString &url, int unread)
+void Akregator::Backend::StorageMK4Impl::setUnreadFor(const FeedKey &key, int unread)
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
+    int findidx = d->findFeed(key);
     if (findidx == -1) {
         return;
     }
-    findrow = d->archiveView.GetAt(findidx);
-    d->punread(findrow) = unread;
-    d->archiveView.SetAt(findidx, findrow);
+    c4_Row row = d->archiveView.GetAt(findidx);
+    d->punread(row) = unread;
+    d->archiveView.SetAt(findidx, row);
     markDirty();
 }
 
-int Akregator::Backend::StorageMK4Impl::totalCountFor(const QString &url) const
+int Akregator::Backend::StorageMK4Impl::totalCountFor(const FeedKey &key) const
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
-
+    int findidx = d->findFeed(key);
     return findidx != -1 ? d->ptotalCount(d->archiveView.GetAt(findidx)) : 0;
 }
 
-void Akregator::Backend::StorageMK4Impl::setTotalCountFor(const QString &url, int total)
+void Akregator::Backend::StorageMK4Impl::setTotalCountFor(const FeedKey &key, int total)
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
+    int findidx = d->findFeed(key);
     if (findidx == -1) {
         return;
     }
-    findrow = d->archiveView.GetAt(findidx);
-    d->ptotalCount(findrow) = total;
-    d->archiveView.SetAt(findidx, findrow);
+    c4_Row row = d->archiveView.GetAt(findidx);
+    d->ptotalCount(row) = total;
+    d->archiveView.SetAt(findidx, row);
     markDirty();
 }
 
-int Akregator::Backend::StorageMK4Impl::lastFetchFor(const QString &url) const
+int Akregator::Backend::StorageMK4Impl::lastFetchFor(const FeedKey &key) const
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
-
+    int findidx = d->findFeed(key);
     return findidx != -1 ? d->plastFetch(d->archiveView.GetAt(findidx)) : 0;
 }
 
-void Akregator::Backend::StorageMK4Impl::setLastFetchFor(const QString &url, int lastFetch)
+void Akregator::Backend::StorageMK4Impl::setLastFetchFor(const FeedKey &key, int lastFetch)
 {
-    c4_Row findrow;
-    d->purl(findrow) = url.toLatin1();
-    int findidx = d->archiveView.Find(findrow);
+    int findidx = d->findFeed(key);
+    if (findidx == -1) {
+        return;
+    }
+    c4_Row row = d->archiveView.GetAt(findidx);
+    d->plastFetch(row) = lastFetch;
+    d->archiveView.SetAt(findidx, row);
+    markDirty();
+}
+
+void Akregator::Backend::StorageMK4Impl::httpValidatorsFor(const QString &url, QString &etag, QString &lastModified) const
+{
+    httpValidatorsFor(FeedKey(url), etag, lastModified);
+}
+
+void Akregator::Backend::StorageMK4Impl::setHttpValidatorsFor(const QString &url, const QString &etag, const QString &lastModified)
+{
+    setHttpValidatorsFor(FeedKey(url), etag, lastModified);
+}
+
+QByteArray Akregator::Backend::StorageMK4Impl::contentDigestFor(const QString &url) const
+{
+    return contentDigestFor(FeedKey(url));
+}
+
+void Akregator::Backend::StorageMK4Impl::setContentDigestFor(const QString &url, const QByteArray &digest)
+{
+    setContentDigestFor(FeedKey(url), digest);
+}
+
+void Akregator::Backend::StorageMK4Impl::httpValidatorsFor(const FeedKey &key, QString &etag, QString &lastModified) const
+{
+    int findidx = d->findFeed(key);
+    if (findidx == -1) {
+        etag.clear();
+        lastModified.clear();
+        return;
+    }
+    const c4_RowRef row = d->archiveView.GetAt(findidx);
+    etag = QString::fromLatin1(d->petag(row));
+    lastModified = QString::fromLatin1(d->plastModified(row));
+}
+
+void Akregator::Backend::StorageMK4Impl::setHttpValidatorsFor(const FeedKey &key, const QString &etag, const QString &lastModified)
+{
+    int findidx = d->findFeed(key);
+    if (findidx == -1) {
+        return;
+    }
+    c4_Row row = d->archiveView.GetAt(findidx);
+    d->petag(row) = !etag.isEmpty() ? etag.toLatin1() : "";
+    d->plastModified(row) = !lastModified.isEmpty() ? lastModified.toLatin1() : "";
+    d->archiveView.SetAt(findidx, row);
+    markDirty();
+}
+
+QByteArray Akregator::Backend::StorageMK4Impl::contentDigestFor(const FeedKey &key) const
+{
+    int findidx = d->findFeed(key);
+    if (findidx == -1) {
+        return QByteArray();
+    }
+    const c4_Bytes digest = d->pcontentDigest(d->archiveView.GetAt(findidx));
+    return QByteArray(reinterpret_cast<const char *>(digest.Contents()), digest.Size());
+}
+
+void Akregator::Backend::StorageMK4Impl::setContentDigestFor(const FeedKey &key, const QByteArray &digest)
+{
+    int findidx = d->findFeed(key);
     if (findidx == -1) {
         return;
     }
-    findrow = d->archiveView.GetAt(findidx);
-    d->plastFetch(findrow) = lastFetch;
-    d->archiveView.SetAt(findidx, findrow);
+    c4_Row row = d->archiveView.GetAt(findidx);
+    d->pcontentDigest(row) = c4_Bytes(digest.constData(), digest.size());
+    d->archiveView.SetAt(findidx, row);
     markDirty();
 }
 
 void Akregator::Backend::StorageMK4Impl::markDirty()
 {
-    if (!d->modified) {
-        d->modified = true;
-        // commit changes after 3 seconds
-        QTimer::singleShot(3000, this, &StorageMK4Impl::slotCommit);
+    d->lastActivity.start();
+    d->scheduleCommit();
+}
+
+void Akregator::Backend::StorageMK4Impl::markDirty(FeedStorageMK4Impl *feedStorage, int bytes)
+{
+    d->lastActivity.start();
+    d->pendingBytes += bytes;
+    d->dirtyFeeds.insert(feedStorage);
+    d->scheduleCommit();
+}
+
+quint64 Akregator::Backend::StorageMK4Impl::nextUse()
+{
+    return ++d->useCounter;
+}
+
+void Akregator::Backend::StorageMK4Impl::archiveOpened(FeedStorageMK4Impl *feedStorage)
+{
+    d->openFeeds.insert(feedStorage);
+    const int limit = Settings::maxOpenArchives();
+    if (limit > 0 && d->openFeeds.count() > limit) {
+        d->releaseArchives(feedStorage, limit);
     }
 }
 
+void Akregator::Backend::StorageMK4Impl::archiveReleased(FeedStorageMK4Impl *feedStorage)
+{
+    d->openFeeds.remove(feedStorage);
+}
+
 void Akregator::Backend::StorageMK4Impl::slotCommit()
 {
     if (d->modified) {
@@ -293,6 +711,52 @@ void Akregator::Backend::StorageMK4Impl::slotCommit()
     d->modified = false;
 }
 
+bool Akregator::Backend::StorageMK4Impl::compressArticles() const
+{
+    return Settings::compressArchivedArticles();
+}
+
+void Akregator::Backend::StorageMK4Impl::slotRecompress()
+{
+    int budget = RecompressBatchSize;
+    while (budget > 0 && !d->recompressQueue.isEmpty()) {
+        FeedStorageMK4Impl *fs = d->createFeedStorage(d->recompressQueue.first());
+        if (!fs->recompressBodies(d->recompressMode, budget)) {
+            break;
+        }
+        d->recompressQueue.removeFirst();
+        --budget; // visiting a feed may mean opening its file
+    }
+
+    if (!d->recompressQueue.isEmpty()) {
+        d->recompressTimer->start(RecompressInterval);
+    } else {
+        d->setConvertedMode(d->recompressMode);
+        qCDebug(AKREGATOR_MK4_LOG) << "Converted archived articles to" << (d->recompressMode ? "compressed" : "plain") << "storage";
+    }
+}
+
+void Akregator::Backend::StorageMK4Impl::slotCompact()
+{
+    // fetches and article changes write to the archives, do not compete with them
+    if (d->lastActivity.isValid() && d->lastActivity.elapsed() < CompactIdleTime) {
+        d->compactTimer->start(static_cast<int>(CompactIdleTime - d->lastActivity.elapsed()));
+        return;
+    }
+    if (d->compactQueue.isEmpty()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 reclaimed = d->createFeedStorage(d->compactQueue.takeFirst())->compact(CompactMaxSize);
+    if (reclaimed >= 0) {
+        ++d->compactedFeeds;
+        d->compactReclaimed += reclaimed;
+    }
+    d->scheduleCompaction(static_cast<int>(qMax<qint64>(CompactInterval, timer.elapsed() * CompactPauseFactor)));
+}
+
 QStringList Akregator::Backend::StorageMK4Impl::feeds() const
 {
     // TODO: cache list
@@ -28,8 +28,12 @@
 
 #include "storage.h"
 
+class c4_RowRef;
+class c4_Storage;
+
 namespace Akregator {
 namespace Backend {
+class FeedStorageMK4Impl;
 /**
  * Metakit implementation of Storage interface
  */
@@ -38,7 +42,12 @@ class StorageMK4Impl : public Storage
     Q_OBJECT
 public:
 
-    StorageMK4Impl();
+    enum Layout {
+        FilePerFeed, /**< an index file plus one metakit file per feed */
+        SingleFile   /**< all feeds as tables of one metakit file, indexed by feed URL */
+    };
+
+    explicit StorageMK4Impl(Layout layout = FilePerFeed);
     StorageMK4Impl(const StorageMK4Impl &);
     StorageMK4Impl &operator =(const StorageMK4Impl &);
     ~StorageMK4Impl();
@@ -55,6 +64,15 @@ public:
     /** returns the path to the metakit archives */
     QString archivePath() const;
 
+    /** returns the storage holding all feed tables, or @c nullptr if every feed has a file of its own */
+    c4_Storage *sharedStorage() const;
+
+    /** returns the number of the table holding the articles of @p url in the shared storage */
+    int tableFor(const FeedKey &key) const;
+
+    /** returns the row of the shared storage holding the views of table number @p table, adding it if needed */
+    c4_RowRef feedTables(int table);
+
     void initialize(const QStringList &params) override;
     /**
      * Open storage and prepare it for work.
@@ -93,6 +111,20 @@ public:
     void setTotalCountFor(const QString &url, int total) override;
     int lastFetchFor(const QString &url) const override;
     void setLastFetchFor(const QString &url, int lastFetch) override;
+    int unreadFor(const FeedKey &key) const override;
+    void setUnreadFor(const FeedKey &key, int unread) override;
+    int totalCountFor(const FeedKey &key) const override;
+    void setTotalCountFor(const FeedKey &key, int total) override;
+    int lastFetchFor(const FeedKey &key) const override;
+    void setLastFetchFor(const FeedKey &key, int lastFetch) override;
+    void httpValidatorsFor(const QString &url, QString &etag, QString &lastModified) const override;
+    void setHttpValidatorsFor(const QString &url, const QString &etag, const QString &lastModified) override;
+    QByteArray contentDigestFor(const QString &url) const override;
+    void setContentDigestFor(const QString &url, const QByteArray &digest) override;
+    void httpValidatorsFor(const FeedKey &key, QString &etag, QString &lastModified) const override;
+    void setHttpValidatorsFor(const FeedKey &key, const QString &etag, const QString &lastModified) override;
+    QByteArray contentDigestFor(const FeedKey &key) const override;
+    void setContentDigestFor(const FeedKey &key, const QByteArray &digest) override;
 
     QStringList feeds() const override;
 
@@ -111,9 +143,26 @@ public:
     void clear() override;
 
     void markDirty();
+    /** records that @p feedStorage was modified, @p bytes being the size of the data written.
+        Every call restarts the commit delay, up to the maximum delay after the first change */
+    void markDirty(FeedStorageMK4Impl *feedStorage, int bytes = 0);
+
+    /** returns an increasing counter value used to order archive accesses */
+    quint64 nextUse();
+    /** records that the metakit file of @p feedStorage was opened, closing least recently used archives beyond the configured limit */
+    void archiveOpened(FeedStorageMK4Impl *feedStorage);
+    /** records that the metakit file of @p feedStorage was closed */
+    void archiveReleased(FeedStorageMK4Impl *feedStorage);
+
+    /** returns whether article descriptions and contents are to be stored compressed */
+    bool compressArticles() const;
 
 protected Q_SLOTS:
     void slotCommit();
+    /** converts the next batch of article bodies to the configured storage form */
+    void slotRecompress();
+    /** starts compacting the next feed archive once the storage has been idle for a while */
+    void slotCompact();
 
 private:
     class StorageMK4ImplPrivate;
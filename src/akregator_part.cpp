@@ -32,6 +32,8 @@
 #include "actionmanagerimpl.h"
 #include "article.h"
 #include "fetchqueue.h"
+#include "feedparser.h"
+#include "feedretriever.h"
 #include "feedlist.h"
 #include "framemanager.h"
 #include "kernel.h"
@@ -40,6 +42,7 @@
 #include "notificationmanager.h"
 #include "plugin.h"
 #include "pluginmanager.h"
+#include "searchindex.h"
 #include "storage.h"
 #include "storagefactory.h"
 #include "storagefactoryregistry.h"
@@ -223,6 +226,7 @@ Part::Part(QWidget *parentWidget, QObject *parent, const QVariantList &)
 
     m_storage->open(true);
     Kernel::self()->setStorage(m_storage);
+    Kernel::self()->setSearchIndex(new SearchIndex(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/akregator/Archive/searchindex")));
 
     m_actionManager = new ActionManagerImpl(this);
     ActionManager::setInstance(m_actionManager);
@@ -266,6 +270,7 @@ Part::Part(QWidget *parentWidget, QObject *parent, const QVariantList &)
     }
 
     Syndication::FileRetriever::setUserAgent(useragent);
+    FeedRetriever::setUserAgent(useragent);
 
     loadPlugins(QStringLiteral("extension"));   // FIXME: also unload them!
     if (mCentralWidget->previousSessionCrashed()) {
@@ -316,6 +321,8 @@ void Part::slotOnShutdown()
     autoSaveProperties();
     m_shuttingDown = true;
     m_autosaveTimer->stop();
+    // parse jobs must not outlive the application, nor hand results to feeds being destroyed
+    Kernel::self()->feedParser()->shutdown();
     if (m_mainWidget) {
         saveSettings();
         m_mainWidget->slotOnShutdown();
@@ -325,6 +332,11 @@ void Part::slotOnShutdown()
     TrayIcon::setInstance(nullptr);
     delete m_storage;
     m_storage = nullptr;
+    if (SearchIndex *searchIndex = Kernel::self()->searchIndex()) {
+        Kernel::self()->setSearchIndex(nullptr);
+        searchIndex->save();
+        delete searchIndex;
+    }
     //delete m_actionManager;
 }
 
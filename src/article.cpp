@@ -25,6 +25,8 @@
 #include "article.h"
 #include "feed.h"
 #include "feedstorage.h"
+#include "kernel.h"
+#include "searchindex.h"
 #include "shared.h"
 #include "storage.h"
 #include "utils.h"
@@ -79,6 +81,7 @@ namespace Akregator {
 struct Article::Private : public Shared {
     Private();
     Private(const QString &guid, Feed *feed, Backend::FeedStorage *archive);
+    Private(const QString &guid, Feed *feed, Backend::FeedStorage *archive, int status, uint hash, uint pubDate);
     Private(const ItemPtr &article, Feed *feed, Backend::FeedStorage *archive);
 
     /** The status of the article is stored in an int, the bits having the
@@ -105,6 +108,16 @@ struct Article::Private : public Shared {
     uint hash;
     QDateTime pubDate;
     mutable QSharedPointer<const Enclosure> enclosure;
+    /** the guid prepared for repeated archive lookups, see storageKey() */
+    mutable Backend::GuidKey key;
+
+    const Backend::GuidKey &storageKey() const
+    {
+        if (key.isNull()) {
+            key = Backend::GuidKey(guid);
+        }
+        return key;
+    }
 };
 
 namespace {
@@ -174,6 +187,16 @@ Article::Private::Private(const QString &guid_, Feed *feed_, Backend::FeedStorag
 {
 }
 
+Article::Private::Private(const QString &guid_, Feed *feed_, Backend::FeedStorage *archive_, int status_, uint hash_, uint pubDate_)
+    : feed(feed_)
+    , guid(guid_)
+    , archive(archive_)
+    , status(status_)
+    , hash(hash_)
+    , pubDate(QDateTime::fromTime_t(pubDate_))
+{
+}
+
 Article::Private::Private(const ItemPtr &article, Feed *feed_, Backend::FeedStorage *archive_)
     : feed(feed_)
     , archive(archive_)
@@ -181,76 +204,115 @@ Article::Private::Private(const ItemPtr &article, Feed *feed_, Backend::FeedStor
     , hash(0)
 {
     Q_ASSERT(archive);
+    guid = article->id();
+
+    // read and write the archive row at most once each instead of once per field
+    Backend::ArticleRecord record;
+    const bool write = Article::mergeItem(article, archive, storageKey(), record);
+    hash = record.hash;
+    if (write) {
+        pubDate.setTime_t(record.pubDate);
+        archive->writeArticle(storageKey(), record);
+    }
+}
+
+bool Article::mergeItem(const ItemPtr &article, Backend::FeedStorage *archive, const Backend::GuidKey &key, Backend::ArticleRecord &record)
+{
+    const Backend::ArticleRecord item = recordFromItem(article);
+    // the first lookup resolves the row, the following ones only verify it
+    const bool stored = archive->contains(key);
+    return mergeRecord(key, item, archive, stored, stored ? archive->hash(key) : 0, record);
+}
+
+Backend::ArticleRecord Article::recordFromItem(const ItemPtr &article)
+{
     const QList<PersonPtr> authorList = article->authors();
 
     QString author;
 
     const PersonPtr firstAuthor = !authorList.isEmpty() ? authorList.first() : PersonPtr();
 
-    hash = Utils::calcHash(article->title() + article->description() + article->content() + article->link() + author);
-
-    guid = article->id();
-
-    if (!archive->contains(guid)) {
-        archive->addEntry(guid);
+    Backend::ArticleRecord record;
+    record.hash = Utils::calcHash(article->title() + article->description() + article->content() + article->link() + author);
+    QString title = article->title();
+    if (title.isEmpty()) {
+        title = buildTitle(article->description());
+    }
+    record.title = title;
+    record.content = article->content();
+    record.description = article->description();
+    record.link = article->link();
+    //record.comments = article.comments();
+    //record.commentsLink = article.commentsLink().url();
+    record.guidIsPermaLink = false;
+    record.guidIsHash = article->id().startsWith(QLatin1String("hash:"));
+    const time_t datePublished = article->datePublished();
+    if (datePublished > 0) {
+        record.pubDate = datePublished;
+    } else {
+        record.pubDate = QDateTime::currentDateTime().toTime_t();
+    }
+    if (firstAuthor) {
+        record.authorName = firstAuthor->name();
+        record.authorUri = firstAuthor->uri();
+        record.authorEMail = firstAuthor->email();
+    }
 
-        archive->setHash(guid, hash);
-        QString title = article->title();
-        if (title.isEmpty()) {
-            title = buildTitle(article->description());
-        }
-        archive->setTitle(guid, title);
-        archive->setContent(guid, article->content());
-        archive->setDescription(guid, article->description());
-        archive->setLink(guid, article->link());
-        //archive->setComments(guid, article.comments());
-        //archive->setCommentsLink(guid, article.commentsLink().url());
-        archive->setGuidIsPermaLink(guid, false);
-        archive->setGuidIsHash(guid, guid.startsWith(QLatin1String("hash:")));
-        const time_t datePublished = article->datePublished();
-        if (datePublished > 0) {
-            pubDate.setTime_t(datePublished);
-        } else {
-            pubDate = QDateTime::currentDateTime();
-        }
-        archive->setPubDate(guid, pubDate.toTime_t());
-        if (firstAuthor) {
-            archive->setAuthorName(guid, firstAuthor->name());
-            archive->setAuthorUri(guid, firstAuthor->uri());
-            archive->setAuthorEMail(guid, firstAuthor->email());
-        }
-        const QList<EnclosurePtr> encs = article->enclosures();
-        if (!encs.isEmpty()) {
-            archive->setEnclosure(guid, encs[0]->url(), encs[0]->type(), encs[0]->length());
+    const QList<EnclosurePtr> encs = article->enclosures();
+    if (!encs.isEmpty()) {
+        record.hasEnclosure = true;
+        record.enclosureUrl = encs[0]->url();
+        record.enclosureType = encs[0]->type();
+        record.enclosureLength = encs[0]->length();
+    }
+    return record;
+}
+
+bool Article::mergeRecord(const Backend::GuidKey &key, const Backend::ArticleRecord &item, Backend::FeedStorage *archive, bool stored, uint storedHash, Backend::ArticleRecord &record)
+{
+    bool write = false;
+
+    if (!stored) {
+        record = item;
+        write = true;
+    } else if (item.hash != storedHash) { //article is in archive, was it modified?
+        // if yes, update
+        archive->readArticle(key, record);
+        record.hash = item.hash;
+        record.title = item.title;
+        record.description = item.description;
+        record.content = item.content;
+        record.link = item.link;
+        if (!item.authorName.isEmpty() || !item.authorUri.isEmpty() || !item.authorEMail.isEmpty()) {
+            record.authorName = item.authorName;
+            record.authorUri = item.authorUri;
+            record.authorEMail = item.authorEMail;
         }
+        //record.commentsLink = article.commentsLink();
+        write = true;
     } else {
-        // always update comments count, as it's not used for hash calculation
-        //archive->setComments(guid, article.comments());
-        if (hash != archive->hash(guid)) { //article is in archive, was it modified?
-            // if yes, update
-            pubDate.setTime_t(archive->pubDate(guid));
-            archive->setHash(guid, hash);
-            QString title = article->title();
-            if (title.isEmpty()) {
-                title = buildTitle(article->description());
-            }
-            archive->setTitle(guid, title);
-            archive->setDescription(guid, article->description());
-            archive->setContent(guid, article->content());
-            archive->setLink(guid, article->link());
-            if (firstAuthor) {
-                archive->setAuthorName(guid, firstAuthor->name());
-                archive->setAuthorUri(guid, firstAuthor->uri());
-                archive->setAuthorEMail(guid, firstAuthor->email());
+        record.hash = item.hash;
+        if (item.hasEnclosure) {
+            // unchanged article: only rewrite the row if the enclosure differs
+            bool hasEnc;
+            QString url;
+            QString type;
+            int length;
+            archive->enclosure(key, hasEnc, url, type, length);
+            if (!hasEnc || url != item.enclosureUrl || type != item.enclosureType || length != item.enclosureLength) {
+                archive->readArticle(key, record);
+                write = true;
             }
-            //archive->setCommentsLink(guid, article.commentsLink());
         }
     }
 
-    const QList<EnclosurePtr> encs = article->enclosures();
-    if (!encs.isEmpty()) {
-        archive->setEnclosure(guid, encs[0]->url(), encs[0]->type(), encs[0]->length());
+    if (write && item.hasEnclosure) {
+        record.hasEnclosure = true;
+        record.enclosureUrl = item.enclosureUrl;
+        record.enclosureType = item.enclosureType;
+        record.enclosureLength = item.enclosureLength;
     }
+    return write;
 }
 
 Article::Article() : d(new Private)
@@ -269,6 +331,47 @@ Article::Article(const ItemPtr &article, Backend::FeedStorage *archive) : d(new
 {
 }
 
+Article::Article(const QString &guid, Feed *feed, Backend::ArticleRecord &record, int status)
+{
+    int flags = record.status & Private::Keep;
+    if (status == Read) {
+        flags |= Private::Read;
+    } else if (status == New) {
+        flags |= Private::New;
+    }
+    record.status = flags;
+    d = new Private(guid, feed, feed->storage()->archiveFor(feed->xmlUrl()), flags, record.hash, record.pubDate);
+}
+
+Article::Article(const QString &guid, Feed *feed, Backend::FeedStorage *archive, int status, uint hash, uint pubDate) : d(new Private(guid, feed, archive, status, hash, pubDate))
+{
+}
+
+bool Article::isDeletedStatus(int status)
+{
+    return (status & Private::Deleted) != 0;
+}
+
+bool Article::isReadStatus(int status)
+{
+    return (status & Private::Read) != 0;
+}
+
+bool Article::isKeepStatus(int status)
+{
+    return (status & Private::Keep) != 0;
+}
+
+bool Article::isNewStatus(int status)
+{
+    return (status & Private::New) != 0;
+}
+
+int Article::unreadStatus(int status)
+{
+    return status & ~(Private::Read | Private::New);
+}
+
 bool Article::isNull() const
 {
     return d->archive == nullptr; // TODO: use proper null state
@@ -288,10 +391,13 @@ void Article::setDeleted()
 
     setStatus(Read);
     d->status = Private::Deleted | Private::Read;
-    d->archive->setStatus(d->guid, d->status);
+    d->archive->setStatus(d->storageKey(), d->status);
     d->archive->setDeleted(d->guid);
 
     if (d->feed) {
+        if (SearchIndex *index = Kernel::self()->searchIndex()) {
+            index->removeArticle(d->feed->xmlUrl(), d->guid);
+        }
         d->feed->setArticleDeleted(*this);
     }
 }
@@ -383,7 +489,7 @@ void Article::setStatus(int stat)
             break;
         }
         if (d->archive) {
-            d->archive->setStatus(d->guid, d->status);
+            d->archive->setStatus(d->storageKey(), d->status);
         }
         if (d->feed) {
             d->feed->setArticleChanged(*this, oldStatus, stat != Read);
@@ -395,7 +501,7 @@ QString Article::title() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->title(d->guid);
+        str = d->archive->title(d->storageKey());
     }
     return str;
 }
@@ -404,7 +510,7 @@ QString Article::authorName() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->authorName(d->guid);
+        str = d->archive->authorName(d->storageKey());
     }
     return str;
 }
@@ -413,7 +519,7 @@ QString Article::authorEMail() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->authorEMail(d->guid);
+        str = d->archive->authorEMail(d->storageKey());
     }
     return str;
 }
@@ -422,7 +528,7 @@ QString Article::authorUri() const
 {
     QString str;
     if (d->archive) {
-        str = d->archive->authorUri(d->guid);
+        str = d->archive->authorUri(d->storageKey());
     }
     return str;
 }
@@ -474,17 +580,17 @@ QString Article::authorAsHtml() const
 
 QUrl Article::link() const
 {
-    return QUrl(d->archive->link(d->guid));
+    return QUrl(d->archive->link(d->storageKey()));
 }
 
 QString Article::description() const
 {
-    return d->archive->description(d->guid);
+    return d->archive->description(d->storageKey());
 }
 
 QString Article::content(ContentOption opt) const
 {
-    const QString cnt = d->archive->content(d->guid);
+    const QString cnt = d->archive->content(d->storageKey());
     return opt == ContentAndOnlyContent ? cnt : (!cnt.isEmpty() ? cnt : description());
 }
 
@@ -495,22 +601,22 @@ QString Article::guid() const
 
 QUrl Article::commentsLink() const
 {
-    return QUrl(d->archive->commentsLink(d->guid));
+    return QUrl(d->archive->commentsLink(d->storageKey()));
 }
 
 int Article::comments() const
 {
-    return d->archive->comments(d->guid);
+    return d->archive->comments(d->storageKey());
 }
 
 bool Article::guidIsPermaLink() const
 {
-    return d->archive->guidIsPermaLink(d->guid);
+    return d->archive->guidIsPermaLink(d->storageKey());
 }
 
 bool Article::guidIsHash() const
 {
-    return d->archive->guidIsHash(d->guid);
+    return d->archive->guidIsHash(d->storageKey());
 }
 
 uint Article::hash() const
@@ -526,7 +632,7 @@ bool Article::keep() const
 void Article::setKeep(bool keep)
 {
     d->status = keep ? (d->status | Private::Keep) : (d->status & ~Private::Keep);
-    d->archive->setStatus(d->guid, d->status);
+    d->archive->setStatus(d->storageKey(), d->status);
     if (d->feed) {
         d->feed->setArticleChanged(*this);
     }
@@ -549,7 +655,7 @@ QSharedPointer<const Enclosure> Article::enclosure() const
         QString type;
         int length;
         bool hasEnc;
-        d->archive->enclosure(d->guid, hasEnc, url, type, length);
+        d->archive->enclosure(d->storageKey(), hasEnc, url, type, length);
         if (hasEnc) {
             d->enclosure.reset(new EnclosureImpl(url, type, static_cast<uint>(length)));
         } else {
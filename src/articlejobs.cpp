@@ -31,8 +31,10 @@
 #include "akregator_debug.h"
 #include <KLocalizedString>
 
+#include <QElapsedTimer>
 #include <QTimer>
 
+#include <algorithm>
 #include <vector>
 
 #include <cassert>
@@ -181,18 +183,81 @@ ArticleListJob::ArticleListJob(TreeNode *p) : KJob(p)
 
 void ArticleListJob::start()
 {
-    QTimer::singleShot(20, this, &ArticleListJob::doList);
+    QTimer::singleShot(0, this, &ArticleListJob::doList);
+}
+
+bool ArticleListJob::doKill()
+{
+    m_killed = true;
+    return true;
 }
 
 void ArticleListJob::doList()
 {
-    if (m_node) {
-        m_articles = m_node->articles();
-    } else {
+    // keep the event loop responsive: every call lists at most this many articles, or for about this long
+    static const int chunkSize = 500;
+    static const qint64 timeBudget = 25;
+
+    if (m_killed) {
+        return;
+    }
+    if (!m_node) {
         setError(ListingFailed);
         setErrorText(i18n("The feed to be listed was already removed."));
+        emitResult();
+        return;
+    }
+    if (!m_started) {
+        m_started = true;
+        const QVector<Feed *> feeds = m_node->feeds();
+        m_feeds.reserve(feeds.count());
+        for (Feed *const feed : feeds) {
+            m_feeds.append(feed);
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<Article> chunk;
+    while (chunk.count() < chunkSize && !timer.hasExpired(timeBudget)) {
+        if (m_pendingPos >= m_pending.count()) {
+            if (m_feeds.isEmpty()) {
+                break;
+            }
+            const QPointer<Feed> feed = m_feeds.takeFirst();
+            if (!feed) {
+                continue;
+            }
+            m_pending = feed->articlesByDate();
+            m_pendingPos = 0;
+        }
+        const int end = std::min(m_pending.count(), m_pendingPos + chunkSize - chunk.count());
+        for (; m_pendingPos < end; ++m_pendingPos) {
+            const Article &article = m_pending.at(m_pendingPos);
+            if (!article.isDeleted()) {
+                chunk.append(article);
+            }
+        }
+    }
+    if (m_pendingPos >= m_pending.count()) {
+        m_pending.clear();
+        m_pendingPos = 0;
+    }
+
+    if (!chunk.isEmpty()) {
+        m_articles += chunk;
+        const QPointer<ArticleListJob> guard(this);
+        Q_EMIT articlesListed(this, chunk);
+        if (!guard || m_killed) {
+            return;
+        }
+    }
+
+    if (m_pending.isEmpty() && m_feeds.isEmpty()) {
+        emitResult();
+    } else {
+        QTimer::singleShot(0, this, &ArticleListJob::doList);
     }
-    emitResult();
 }
 
 TreeNode *ArticleListJob::node() const
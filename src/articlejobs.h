@@ -37,6 +37,7 @@
 //transitional job classes
 namespace Akregator {
 class Article;
+class Feed;
 class FeedList;
 class TreeNode;
 
@@ -106,6 +107,7 @@ class AKREGATOR_EXPORT ArticleListJob : public KJob
 public:
     explicit ArticleListJob(TreeNode *parent = nullptr);
 
+    /** returns the articles listed so far, all of them once the job finished */
     QVector<Article> articles() const;
     TreeNode *node() const;
 
@@ -115,12 +117,27 @@ public:
         ListingFailed = KJob::UserDefinedError
     };
 
+Q_SIGNALS:
+    /** emitted for every chunk of listed articles, sorted newest first within each feed. Deleted articles are skipped. */
+    void articlesListed(Akregator::ArticleListJob *job, const QVector<Akregator::Article> &articles);
+
+protected:
+    bool doKill() override;
+
 private Q_SLOTS:
+    /** lists the next chunk of articles and reschedules itself until all feeds are listed */
     void doList();
 
 private:
     const QPointer<TreeNode> m_node;
     QVector<Article> m_articles;
+    /** feeds not listed yet */
+    QVector<QPointer<Feed> > m_feeds;
+    /** articles of the feed currently listed, and the first one not emitted yet */
+    QVector<Article> m_pending;
+    int m_pendingPos = 0;
+    bool m_started = false;
+    bool m_killed = false;
 };
 } // namespace akregator
 
@@ -26,6 +26,9 @@
  */
 #include "articlematcher.h"
 #include "article.h"
+#include "feed.h"
+#include "kernel.h"
+#include "searchindex.h"
 #include "types.h"
 #include <KConfig>
 #include <kconfiggroup.h>
@@ -33,10 +36,71 @@
 #include <krandom.h>
 #include <qurl.h>
 
-#include <QRegExp>
 
 namespace Akregator {
 namespace Filters {
+/** Fetches the text subjects of an article at most once, so that criteria sharing a subject do not load it again */
+class SubjectCache
+{
+public:
+    explicit SubjectCache(const Article &article)
+        : m_article(article)
+    {
+    }
+
+    const QString &text(Criterion::Subject subject)
+    {
+        switch (subject) {
+        case Criterion::Title:
+            return fetch(Criterion::Title, m_title);
+        case Criterion::Description:
+            return fetch(Criterion::Description, m_description);
+        case Criterion::Link:
+            return fetch(Criterion::Link, m_link);
+        case Criterion::Author:
+            return fetch(Criterion::Author, m_author);
+        default:
+            break;
+        }
+        return m_empty;
+    }
+
+private:
+    const QString &fetch(Criterion::Subject subject, QString &value)
+    {
+        const int bit = 1 << subject;
+        if (!(m_fetched & bit)) {
+            switch (subject) {
+            case Criterion::Title:
+                value = m_article.title();
+                break;
+            case Criterion::Description:
+                value = m_article.description();
+                break;
+            case Criterion::Link:
+                // ### Maybe use prettyUrl here?
+                value = m_article.link().url();
+                break;
+            case Criterion::Author:
+                value = m_article.authorName();
+                break;
+            default:
+                break;
+            }
+            m_fetched |= bit;
+        }
+        return value;
+    }
+
+    const Article &m_article;
+    int m_fetched = 0;
+    QString m_title;
+    QString m_description;
+    QString m_link;
+    QString m_author;
+    const QString m_empty;
+};
+
 AbstractMatcher::AbstractMatcher()
 {
 }
@@ -116,14 +180,22 @@ Criterion::Predicate Criterion::stringToPredicate(const QString &predStr)
 }
 
 Criterion::Criterion()
+    : m_subject(Description)
+    , m_predicate(Contains)
+    , m_objectInt(0)
+    , m_useSearchIndex(false)
 {
+    compile();
 }
 
 Criterion::Criterion(Subject subject, Predicate predicate, const QVariant &object)
     : m_subject(subject)
     , m_predicate(predicate)
     , m_object(object)
+    , m_objectInt(0)
+    , m_useSearchIndex(false)
 {
+    compile();
 }
 
 void Criterion::writeConfig(KConfigGroup *config) const
@@ -146,58 +218,78 @@ void Criterion::readConfig(KConfigGroup *config)
     if (type != QVariant::Invalid) {
         m_object = config->readEntry(QStringLiteral("objectValue"), QVariant(type));
     }
+    compile();
+}
+
+void Criterion::compile()
+{
+    const Predicate predicateType = static_cast<Predicate>(m_predicate & ~Negation);
+
+    m_objectString = m_object.toString();
+    m_matcher = CaseInsensitiveMatcher(predicateType == Contains ? m_objectString : QString());
+    m_regExp = QRegularExpression(predicateType == Matches ? m_objectString : QString());
+    if (predicateType == Matches) {
+        m_regExp.optimize();
+    }
+
+    // integer subjects compare without converting each article's value to a string
+    m_objectInt = 0;
+    if (m_subject == Status) {
+        m_objectInt = m_object.toInt();
+    } else if (m_subject == KeepFlag) {
+        // the boolean subject used to be compared as "true" or "false", anything else never matches
+        if (m_objectString == QLatin1String("true")) {
+            m_objectInt = 1;
+        } else if (m_objectString != QLatin1String("false")) {
+            m_objectInt = -1;
+        }
+    }
+
+    m_useSearchIndex = (predicateType == Contains || predicateType == Equals) && (m_subject == Title || m_subject == Description || m_subject == Author);
 }
 
 bool Criterion::satisfiedBy(const Article &article) const
+{
+    SubjectCache subjects(article);
+    return satisfiedBy(article, subjects);
+}
+
+bool Criterion::satisfiedBy(const Article &article, SubjectCache &subjects) const
 {
     if (article.isNull()) {
         return false;
     }
 
-    QVariant concreteSubject;
+    const Predicate predicateType = static_cast<Predicate>(m_predicate & ~Negation);
 
-    switch (m_subject) {
-    case Title:
-        concreteSubject = QVariant(article.title());
-        break;
-    case Description:
-        concreteSubject = QVariant(article.description());
-        break;
-    case Link:
-        // ### Maybe use prettyUrl here?
-        concreteSubject = QVariant(article.link().url());
-        break;
-    case Status:
-        concreteSubject = QVariant(article.status());
-        break;
-    case KeepFlag:
-        concreteSubject = QVariant(article.keep());
-        break;
-    case Author:
-        concreteSubject = QVariant(article.authorName());
+    // the search index can rule out articles without loading their text; regular expressions always need the full scan
+    if (m_useSearchIndex) {
+        const SearchIndex *index = Kernel::self()->searchIndex();
+        const Feed *feed = article.feed();
+        if (index && feed && index->mayContain(feed->xmlUrl(), article.guid(), m_objectString) == SearchIndex::No) {
+            return (m_predicate & Negation) != 0;
+        }
     }
 
     bool satisfied = false;
 
-    const Predicate predicateType = static_cast<Predicate>(m_predicate & ~Negation);
-    QString subjectType = QLatin1String(concreteSubject.typeName());
-
-    switch (predicateType) {
-    case Contains:
-        satisfied = concreteSubject.toString().indexOf(m_object.toString(), 0, Qt::CaseInsensitive) != -1;
-        break;
-    case Equals:
-        if (subjectType == QLatin1String("int")) {
-            satisfied = concreteSubject.toInt() == m_object.toInt();
+    switch (m_subject) {
+    case Status:
+        if (predicateType == Equals) {
+            satisfied = article.status() == m_objectInt;
         } else {
-            satisfied = concreteSubject.toString() == m_object.toString();
+            satisfied = matchesText(predicateType, QString::number(article.status()));
         }
         break;
-    case Matches:
-        satisfied = QRegExp(m_object.toString()).indexIn(concreteSubject.toString()) != -1;
+    case KeepFlag:
+        if (predicateType == Equals) {
+            satisfied = int(article.keep()) == m_objectInt;
+        } else {
+            satisfied = matchesText(predicateType, article.keep() ? QStringLiteral("true") : QStringLiteral("false"));
+        }
         break;
     default:
-        qCDebug(AKREGATOR_LOG) << "Internal inconsistency; predicateType should never be Negation";
+        satisfied = matchesText(predicateType, subjects.text(m_subject));
         break;
     }
 
@@ -208,6 +300,22 @@ bool Criterion::satisfiedBy(const Article &article) const
     return satisfied;
 }
 
+bool Criterion::matchesText(Predicate predicateType, const QString &text) const
+{
+    switch (predicateType) {
+    case Contains:
+        return m_matcher.indexIn(text) != -1;
+    case Equals:
+        return text == m_objectString;
+    case Matches:
+        return m_regExp.isValid() && m_regExp.match(text).hasMatch();
+    default:
+        qCDebug(AKREGATOR_LOG) << "Internal inconsistency; predicateType should never be Negation";
+        break;
+    }
+    return false;
+}
+
 Criterion::Subject Criterion::subject() const
 {
     return m_subject;
@@ -304,9 +412,10 @@ bool ArticleMatcher::anyCriterionMatches(const Article &a) const
     if (m_criteria.isEmpty()) {
         return true;
     }
+    SubjectCache subjects(a);
     const int criteriaSize(m_criteria.size());
     for (int index = 0; index < criteriaSize; ++index) {
-        if (m_criteria.at(index).satisfiedBy(a)) {
+        if (m_criteria.at(index).satisfiedBy(a, subjects)) {
             return true;
         }
     }
@@ -318,9 +427,10 @@ bool ArticleMatcher::allCriteriaMatch(const Article &a) const
     if (m_criteria.isEmpty()) {
         return true;
     }
+    SubjectCache subjects(a);
     const int criteriaSize(m_criteria.size());
     for (int index = 0; index < criteriaSize; ++index) {
-        if (!m_criteria.at(index).satisfiedBy(a)) {
+        if (!m_criteria.at(index).satisfiedBy(a, subjects)) {
             return false;
         }
     }
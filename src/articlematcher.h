@@ -29,8 +29,10 @@
 #define AKREGATOR_ARTICLEMATCHER_H
 
 #include "akregatorpart_export.h"
+#include "caseinsensitivematcher.h"
 #include <QVector>
 #include <QString>
+#include <QRegularExpression>
 #include <QVariant>
 
 class KConfigGroup;
@@ -41,6 +43,7 @@ class Article;
 namespace Filters {
 class AbstractMatcher;
 class Criterion;
+class SubjectCache;
 
 /** Abstract base class for matchers, a matcher just takes an article and checks whether the article matches some criterion or not.
  *  @author Frank Osterfeld
@@ -144,9 +147,23 @@ public:
     }
 
 private:
+    friend class ArticleMatcher;
+
+    /** evaluates the criterion, taking the text subjects from @p subjects shared by all criteria of a matcher */
+    bool satisfiedBy(const Article &article, SubjectCache &subjects) const;
+    bool matchesText(Predicate predicateType, const QString &text) const;
+    /** prepares the evaluation plan below from subject, predicate and object */
+    void compile();
+
     Subject m_subject;
     Predicate m_predicate;
     QVariant m_object;
+
+    QString m_objectString;
+    CaseInsensitiveMatcher m_matcher;
+    QRegularExpression m_regExp;
+    int m_objectInt;
+    bool m_useSearchIndex;
 };
 } // namespace Filters
 } // namespace Akregator
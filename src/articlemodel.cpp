@@ -31,7 +31,10 @@
 
 #include <Syndication/Tools>
 
+#include <QHash>
 #include <QMimeData>
+#include <QPair>
+#include <QSet>
 #include <QString>
 #include <QVector>
 
@@ -42,6 +45,7 @@
 
 #include <QLocale>
 #include <cassert>
+#include <algorithm>
 #include <cmath>
 
 using namespace Akregator;
@@ -54,6 +58,18 @@ public:
     Private(const QVector<Article> &articles, ArticleModel *qq);
     QVector<Article> articles;
     QVector<QString> titleCache;
+    /** articles of different feeds may share a guid */
+    typedef QPair<const Feed *, QString> ArticleKey;
+    static ArticleKey keyOf(const Article &article)
+    {
+        return ArticleKey(article.feed(), article.guid());
+    }
+    /** row of the first article with a given feed and guid */
+    QHash<ArticleKey, int> rowByKey;
+
+    /** sorted, duplicate-free rows of the articles in @p list that are in the model */
+    QVector<int> rowsOf(const QVector<Article> &list) const;
+    void indexRows(int from);
 
     void articlesAdded(const QVector<Article> &);
     void articlesRemoved(const QVector<Article> &);
@@ -80,6 +96,34 @@ ArticleModel::Private::Private(const QVector<Article> &articles_, ArticleModel *
     for (int i = 0; i < articlesCount; ++i) {
         titleCache[i] = stripHtml(articles[i].title());
     }
+    indexRows(0);
+}
+
+void ArticleModel::Private::indexRows(int from)
+{
+    rowByKey.reserve(articles.count());
+    const int articlesCount(articles.count());
+    for (int row = from; row < articlesCount; ++row) {
+        const ArticleKey key = keyOf(articles[row]);
+        if (!rowByKey.contains(key)) {
+            rowByKey.insert(key, row);
+        }
+    }
+}
+
+QVector<int> ArticleModel::Private::rowsOf(const QVector<Article> &list) const
+{
+    QVector<int> rows;
+    rows.reserve(list.count());
+    for (const Article &i : list) {
+        const int row = rowByKey.value(keyOf(i), -1);
+        if (row >= 0) {
+            rows.append(row);
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
 }
 
 ArticleModel::ArticleModel(const QVector<Article> &articles, QObject *parent) : QAbstractTableModel(parent)
@@ -182,6 +226,7 @@ void ArticleModel::clear()
     beginResetModel();
     d->articles.clear();
     d->titleCache.clear();
+    d->rowByKey.clear();
     endResetModel();
 }
 
@@ -202,54 +247,85 @@ void ArticleModel::articlesUpdated(TreeNode *, const QVector<Article> &l)
 
 void ArticleModel::Private::articlesAdded(const QVector<Article> &list)
 {
-    if (list.isEmpty()) { //assert?
+    // articles added while a list job runs may be delivered by both the job and the node
+    QVector<Article> added;
+    added.reserve(list.count());
+    QSet<ArticleKey> addedKeys;
+    for (const Article &i : list) {
+        const ArticleKey key = keyOf(i);
+        if (!rowByKey.contains(key) && !addedKeys.contains(key)) {
+            addedKeys.insert(key);
+            added.append(i);
+        }
+    }
+
+    if (added.isEmpty()) { //assert?
         return;
     }
     const int first = articles.count();
-    q->beginInsertRows(QModelIndex(), first, first + list.size() - 1);
+    q->beginInsertRows(QModelIndex(), first, first + added.size() - 1);
 
     const int oldSize = articles.size();
-    articles << list;
+    articles << added;
 
     const int newArticlesCount(articles.count());
     titleCache.resize(newArticlesCount);
     for (int i = oldSize; i < newArticlesCount; ++i) {
         titleCache[i] = stripHtml(articles[i].title());
     }
+    indexRows(oldSize);
     q->endInsertRows();
 }
 
 void ArticleModel::Private::articlesRemoved(const QVector<Article> &list)
 {
-    //might want to avoid indexOf() in case of performance problems
-    for (const Article &i : list) {
-        const int row = articles.indexOf(i);
-        Q_ASSERT(row != -1);
-        q->removeRow(row, QModelIndex());
+    const QVector<int> rows = rowsOf(list);
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    // remove contiguous ranges back to front, so the rows of the remaining ranges stay valid
+    int i = rows.count() - 1;
+    while (i >= 0) {
+        const int last = rows.at(i);
+        int first = last;
+        while (i > 0 && rows.at(i - 1) == first - 1) {
+            --i;
+            --first;
+        }
+        --i;
+
+        q->beginRemoveRows(QModelIndex(), first, last);
+        articles.remove(first, last - first + 1);
+        titleCache.remove(first, last - first + 1);
+        q->endRemoveRows();
     }
+
+    rowByKey.clear();
+    indexRows(0);
 }
 
 void ArticleModel::Private::articlesUpdated(const QVector<Article> &list)
 {
-    int rmin = 0;
-    int rmax = 0;
-
-    const int numberOfArticles(articles.count());
-    if (numberOfArticles > 0) {
-        rmin = numberOfArticles - 1;
-        //might want to avoid indexOf() in case of performance problems
-        for (const Article &i : list) {
-            const int row = articles.indexOf(i);
-            //TODO: figure out how why the Article might not be found in
-            //TODO: the articles list because we should need this conditional.
-            if (row >= 0) {
-                titleCache[row] = stripHtml(articles[row].title());
-                rmin = std::min(row, rmin);
-                rmax = std::max(row, rmax);
-            }
+    //TODO: figure out how why the Article might not be found in
+    //TODO: the articles list because we should need this conditional.
+    const QVector<int> rows = rowsOf(list);
+    for (int row : rows) {
+        titleCache[row] = stripHtml(articles[row].title());
+    }
+
+    // one signal per contiguous span, instead of one span covering everything in between
+    int i = 0;
+    while (i < rows.count()) {
+        const int first = rows.at(i);
+        int last = first;
+        while (i + 1 < rows.count() && rows.at(i + 1) == last + 1) {
+            ++i;
+            ++last;
         }
+        ++i;
+        Q_EMIT q->dataChanged(q->index(first, 0), q->index(last, ColumnCount - 1));
     }
-    Q_EMIT q->dataChanged(q->index(rmin, 0), q->index(rmax, ColumnCount - 1));
 }
 
 bool ArticleModel::rowMatches(int row, const QSharedPointer<const Filters::AbstractMatcher> &matcher) const
@@ -62,9 +62,87 @@
 #include <QStandardPaths>
 #include <defaultcombinedviewformatter.h>
 
+#include <QCryptographicHash>
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+
+#include <algorithm>
+
 using namespace Akregator;
 using namespace Akregator::Filters;
 
+namespace {
+/** number of articles added to the combined view page at a time */
+const int MaterializeBatchSize = 20;
+/** more articles are added while the end of the page is less than that many viewport heights away */
+const int MaterializeViewportHeights = 3;
+
+QString jsString(const QString &str)
+{
+    QString result;
+    result.reserve(str.size() + str.size() / 8 + 2);
+    result += QLatin1Char('\'');
+    for (const QChar c : str) {
+        switch (c.unicode()) {
+        case '\\':
+            result += QLatin1String("\\\\");
+            break;
+        case '\'':
+            result += QLatin1String("\\'");
+            break;
+        case '\n':
+            result += QLatin1String("\\n");
+            break;
+        case '\r':
+            result += QLatin1String("\\r");
+            break;
+        case 0x2028:
+            result += QLatin1String("\\u2028");
+            break;
+        case 0x2029:
+            result += QLatin1String("\\u2029");
+            break;
+        default:
+            result += c;
+        }
+    }
+    result += QLatin1Char('\'');
+    return result;
+}
+
+QString articleKey(const Article &article)
+{
+    return (article.feed() ? article.feed()->xmlUrl() : QString()) + QLatin1Char('\n') + article.guid();
+}
+
+QString articleElementId(const Article &article)
+{
+    return QLatin1String("article-") + QString::fromLatin1(QCryptographicHash::hash(articleKey(article).toUtf8(), QCryptographicHash::Md5).toHex());
+}
+
+bool isSameArticle(const Article &a, const Article &b)
+{
+    return a.feed() == b.feed() && a.guid() == b.guid();
+}
+
+/** returns the index of @p article in @p articles, which are sorted unless the publication date of an article changed */
+int indexOfArticle(const QVector<Article> &articles, const Article &article)
+{
+    const auto range = std::equal_range(articles.constBegin(), articles.constEnd(), article);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (isSameArticle(*it, article)) {
+            return it - articles.constBegin();
+        }
+    }
+    for (int i = 0; i < articles.count(); ++i) {
+        if (isSameArticle(articles.at(i), article)) {
+            return i;
+        }
+    }
+    return -1;
+}
+}
+
 ArticleViewerWidget::ArticleViewerWidget(const QString &grantleeDirectory, KActionCollection *ac, QWidget *parent)
     : QWidget(parent)
     , m_imageDir(QUrl::fromLocalFile(QString(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/akregator/Media/"))))
@@ -79,6 +157,12 @@ ArticleViewerWidget::ArticleViewerWidget(const QString &grantleeDirectory, KActi
     m_articleHtmlWriter = new Akregator::ArticleHtmlWebEngineWriter(m_articleViewerWidgetNg->articleViewerNg(), this);
     connect(m_articleViewerWidgetNg->articleViewerNg(), &ArticleViewerWebEngine::signalOpenUrlRequest, this, &ArticleViewerWidget::signalOpenUrlRequest);
     connect(m_articleViewerWidgetNg->articleViewerNg(), &ArticleViewerWebEngine::showStatusBarMessage, this, &ArticleViewerWidget::showStatusBarMessage);
+    connect(m_articleViewerWidgetNg->articleViewerNg(), &ArticleViewerWebEngine::loadFinished, this, &ArticleViewerWidget::slotLoadFinished);
+    connect(m_articleViewerWidgetNg->articleViewerNg()->page(), &QWebEnginePage::scrollPositionChanged, this, &ArticleViewerWidget::slotMaterializeArticles);
+    connect(m_articleViewerWidgetNg->articleViewerNg()->page(), &QWebEnginePage::contentsSizeChanged, this, &ArticleViewerWidget::slotMaterializeArticles);
+
+    // the cost of a fragment is its length
+    m_fragmentCache.setMaxCost(4 * 1024 * 1024);
 }
 
 ArticleViewerWidget::~ArticleViewerWidget()
@@ -118,11 +202,13 @@ void ArticleViewerWidget::slotSelectionChanged()
 
 void ArticleViewerWidget::slotPrint()
 {
+    materializeArticles(m_combinedArticles.count());
     m_articleViewerWidgetNg->slotPrint();
 }
 
 void ArticleViewerWidget::slotPrintPreview()
 {
+    materializeArticles(m_combinedArticles.count());
     m_articleViewerWidgetNg->slotPrintPreview();
 }
 
@@ -130,7 +216,7 @@ void ArticleViewerWidget::connectToNode(TreeNode *node)
 {
     if (node) {
         if (m_viewMode == CombinedView) {
-            connect(node, &TreeNode::signalChanged, this, &ArticleViewerWidget::slotUpdateCombinedView);
+            // changed articles are patched into the page, a changed unread count doesn't need a new page
             connect(node, &TreeNode::signalArticlesAdded, this, &ArticleViewerWidget::slotArticlesAdded);
             connect(node, &TreeNode::signalArticlesRemoved, this, &ArticleViewerWidget::slotArticlesRemoved);
             connect(node, &TreeNode::signalArticlesUpdated, this, &ArticleViewerWidget::slotArticlesUpdated);
@@ -229,6 +315,19 @@ void ArticleViewerWidget::setFilters(const std::vector< QSharedPointer<const Abs
     slotUpdateCombinedView();
 }
 
+bool ArticleViewerWidget::acceptsArticle(const Article &article) const
+{
+    if (article.isDeleted()) {
+        return false;
+    }
+    for (const QSharedPointer<const Filters::AbstractMatcher> &matcher : m_filters) {
+        if (!matcher->matches(article)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void ArticleViewerWidget::slotUpdateCombinedView()
 {
     if (m_viewMode != CombinedView) {
@@ -240,62 +339,257 @@ void ArticleViewerWidget::slotUpdateCombinedView()
     }
 
     m_articleViewerWidgetNg->saveCurrentPosition();
-    QString text;
 
-    int num = 0;
     QTime spent;
     spent.start();
 
-    const std::vector< QSharedPointer<const AbstractMatcher> >::const_iterator filterEnd = m_filters.cend();
-
-    QVector<Article> articles;
+    m_combinedArticles.clear();
     for (const Article &i : qAsConst(m_articles)) {
-        if (i.isDeleted()) {
-            continue;
+        if (acceptsArticle(i)) {
+            m_combinedArticles << i;
         }
+    }
 
-        auto func = [i](const QSharedPointer<const Filters::AbstractMatcher> &matcher) -> bool {
-                        return !matcher->matches(i);
-                    };
-        if (std::find_if(m_filters.cbegin(), filterEnd, func) != filterEnd) {
-            continue;
-        }
-        articles << i;
-        ++num;
+    // the page starts empty, the articles are added as fragments once it is loaded, see slotMaterializeArticles()
+    m_materializedCount = 0;
+    m_pendingScript.clear();
+    ++m_pageGeneration;
+    QString text = combinedViewFormatter()->formatArticles(QVector<Article>(), ArticleFormatter::NoIcon);
+    const QString container = QStringLiteral("<div id=\"akregator-articles\" data-generation=\"%1\"></div>\n").arg(m_pageGeneration);
+    const int bodyEnd = text.lastIndexOf(QLatin1String("</body>"), -1, Qt::CaseInsensitive);
+    if (bodyEnd == -1) {
+        text += container;
+    } else {
+        text.insert(bodyEnd, container);
     }
-    text = combinedViewFormatter()->formatArticles(articles, ArticleFormatter::NoIcon);
 
-    qCDebug(AKREGATOR_LOG) << "Combined view rendering: (" << num << " articles):" << "generating HTML:" << spent.elapsed() << "ms";
+    qCDebug(AKREGATOR_LOG) << "Combined view rendering: (" << m_combinedArticles.count() << " articles):" << "generating HTML:" << spent.elapsed() << "ms";
+    m_pageLoading = true;
+    m_pageOutdated = false;
     renderContent(text);
     qCDebug(AKREGATOR_LOG) << "HTML rendering:" << spent.elapsed() << "ms";
 }
 
-void ArticleViewerWidget::slotArticlesUpdated(TreeNode * /*node*/, const QVector<Article> & /*list*/)
+void ArticleViewerWidget::slotLoadFinished()
 {
-    if (m_viewMode == CombinedView) {
-        //TODO
+    if (!m_pageLoading) {
+        return;
+    }
+    m_pageLoading = false;
+    if (m_viewMode != CombinedView) {
+        return;
+    }
+    if (m_pageOutdated) {
         slotUpdateCombinedView();
+    } else {
+        slotMaterializeArticles();
+    }
+}
+
+void ArticleViewerWidget::slotMaterializeArticles()
+{
+    if (m_viewMode != CombinedView || m_pageLoading || m_materializedCount >= m_combinedArticles.count()) {
+        return;
+    }
+
+    ArticleViewerWebEngine *view = m_articleViewerWidgetNg->articleViewerNg();
+    const qreal viewportHeight = view->height() / view->zoomFactor();
+    if (view->page()->scrollPosition().y() + MaterializeViewportHeights * viewportHeight < view->page()->contentsSize().height()) {
+        return;
+    }
+    materializeArticles(MaterializeBatchSize);
+}
+
+void ArticleViewerWidget::materializeArticles(int count)
+{
+    if (m_viewMode != CombinedView || m_pageLoading) {
+        return;
+    }
+
+    const QVector<Article> articles = m_combinedArticles.mid(m_materializedCount, count);
+    if (articles.isEmpty()) {
+        return;
+    }
+    const QStringList fragments = articleFragments(articles);
+    for (int i = 0; i < articles.count(); ++i) {
+        m_pendingScript += QStringLiteral("c.appendChild(make(%1, %2));\n").arg(jsString(articleElementId(articles.at(i))), jsString(fragments.at(i)));
     }
+    m_materializedCount += articles.count();
+    runPendingScript();
+}
+
+QStringList ArticleViewerWidget::articleFragments(const QVector<Article> &articles)
+{
+    QStringList fragments;
+    fragments.reserve(articles.count());
+    QStringList keys;
+    keys.reserve(articles.count());
+    QVector<Article> missing;
+    QVector<int> missingIndexes;
+    for (const Article &article : articles) {
+        const QString key = articleKey(article) + QLatin1Char('\n') + QString::number(article.hash()) + QLatin1Char(':')
+                            + QString::number(article.status()) + QLatin1Char(':') + QString::number(article.keep());
+        if (const QString *fragment = m_fragmentCache.object(key)) {
+            fragments.append(*fragment);
+        } else {
+            missing.append(article);
+            missingIndexes.append(fragments.count());
+            fragments.append(QString());
+        }
+        keys.append(key);
+    }
+
+    if (!missing.isEmpty()) {
+        const QStringList rendered = combinedViewFormatter()->formatArticleFragments(missing, ArticleFormatter::NoIcon);
+        for (int i = 0; i < rendered.count() && i < missingIndexes.count(); ++i) {
+            const int index = missingIndexes.at(i);
+            fragments[index] = rendered.at(i);
+            m_fragmentCache.insert(keys.at(index), new QString(rendered.at(i)), qMax(1, rendered.at(i).size()));
+        }
+    }
+    return fragments;
+}
+
+void ArticleViewerWidget::insertCombinedArticle(const Article &article)
+{
+    const int index = std::upper_bound(m_combinedArticles.begin(), m_combinedArticles.end(), article) - m_combinedArticles.begin();
+    const bool allMaterialized = m_materializedCount == m_combinedArticles.count();
+    m_combinedArticles.insert(index, article);
+
+    if (m_pageLoading || (index >= m_materializedCount && !allMaterialized)) {
+        // beyond the materialized part, added when scrolled to
+        return;
+    }
+
+    const QString fragment = articleFragments(QVector<Article>() << article).first();
+    if (index < m_materializedCount) {
+        m_pendingScript += QStringLiteral("c.insertBefore(make(%1, %2), document.getElementById(%3));\n")
+                           .arg(jsString(articleElementId(article)), jsString(fragment), jsString(articleElementId(m_combinedArticles.at(index + 1))));
+    } else {
+        m_pendingScript += QStringLiteral("c.appendChild(make(%1, %2));\n").arg(jsString(articleElementId(article)), jsString(fragment));
+    }
+    ++m_materializedCount;
+}
+
+void ArticleViewerWidget::removeCombinedArticleAt(int index)
+{
+    if (index < m_materializedCount) {
+        m_pendingScript += QStringLiteral("remove(%1);\n").arg(jsString(articleElementId(m_combinedArticles.at(index))));
+        --m_materializedCount;
+    }
+    m_combinedArticles.remove(index);
+}
+
+void ArticleViewerWidget::replaceCombinedArticleAt(int index, const Article &article)
+{
+    m_combinedArticles[index] = article;
+    if (index < m_materializedCount) {
+        const QString fragment = articleFragments(QVector<Article>() << article).first();
+        m_pendingScript += QStringLiteral("replace(%1, %2);\n").arg(jsString(articleElementId(article)), jsString(fragment));
+    }
+}
+
+void ArticleViewerWidget::runPendingScript()
+{
+    if (m_pendingScript.isEmpty()) {
+        return;
+    }
+
+    // the script runs in an isolated world, as JavaScript is disabled for the page. It refuses to patch any other page
+    const QString script = QStringLiteral("(function() {\n"
+                                          "var c = document.getElementById('akregator-articles');\n"
+                                          "if (!c || c.getAttribute('data-generation') !== '%1') { return false; }\n"
+                                          "function make(id, html) { var e = document.createElement('div'); e.className = 'akregator-article'; e.id = id; e.innerHTML = html; return e; }\n"
+                                          "function remove(id) { var e = document.getElementById(id); if (e) { c.removeChild(e); } }\n"
+                                          "function replace(id, html) { var e = document.getElementById(id); if (e) { c.replaceChild(make(id, html), e); } }\n")
+                           .arg(m_pageGeneration)
+                           + m_pendingScript
+                           + QLatin1String("return true;\n})()");
+    m_pendingScript.clear();
+
+    const QPointer<ArticleViewerWidget> that(this);
+    const int generation = m_pageGeneration;
+    m_articleViewerWidgetNg->articleViewerNg()->page()->runJavaScript(script, QWebEngineScript::ApplicationWorld, [that, generation](const QVariant &result) {
+        if (!that || result.toBool() || generation != that->m_pageGeneration || that->m_viewMode != CombinedView) {
+            return;
+        }
+        // the page was replaced meanwhile, the changes are lost
+        that->m_pageOutdated = true;
+        if (!that->m_pageLoading) {
+            that->slotUpdateCombinedView();
+        }
+    });
+}
+
+void ArticleViewerWidget::slotArticlesUpdated(TreeNode * /*node*/, const QVector<Article> &list)
+{
+    if (m_viewMode != CombinedView) {
+        return;
+    }
+
+    for (const Article &article : list) {
+        // an updated article may be a new object, possibly with a different date
+        const int articleIndex = indexOfArticle(m_articles, article);
+        if (articleIndex != -1) {
+            m_articles.remove(articleIndex);
+        }
+        m_articles.insert(std::upper_bound(m_articles.begin(), m_articles.end(), article) - m_articles.begin(), article);
+
+        const int index = indexOfArticle(m_combinedArticles, article);
+        if (index == -1) {
+            if (acceptsArticle(article)) {
+                insertCombinedArticle(article);
+            }
+        } else if (!acceptsArticle(article)) {
+            removeCombinedArticleAt(index);
+        } else if ((index == 0 || !(article < m_combinedArticles.at(index - 1)))
+                   && (index == m_combinedArticles.count() - 1 || !(m_combinedArticles.at(index + 1) < article))) {
+            replaceCombinedArticleAt(index, article);
+        } else {
+            removeCombinedArticleAt(index);
+            insertCombinedArticle(article);
+        }
+    }
+    runPendingScript();
 }
 
 void ArticleViewerWidget::slotArticlesAdded(TreeNode * /*node*/, const QVector<Article> &list)
 {
-    if (m_viewMode == CombinedView) {
-        //TODO sort list, then merge
-        m_articles << list;
-        std::sort(m_articles.begin(), m_articles.end());
-        slotUpdateCombinedView();
+    if (m_viewMode != CombinedView) {
+        return;
     }
+
+    QVector<Article> added = list;
+    std::sort(added.begin(), added.end());
+    const int oldCount = m_articles.count();
+    m_articles << added;
+    std::inplace_merge(m_articles.begin(), m_articles.begin() + oldCount, m_articles.end());
+
+    for (const Article &article : qAsConst(added)) {
+        if (acceptsArticle(article)) {
+            insertCombinedArticle(article);
+        }
+    }
+    runPendingScript();
 }
 
 void ArticleViewerWidget::slotArticlesRemoved(TreeNode * /*node*/, const QVector<Article> &list)
 {
-    Q_UNUSED(list)
+    if (m_viewMode != CombinedView) {
+        return;
+    }
 
-    if (m_viewMode == CombinedView) {
-        //TODO
-        slotUpdateCombinedView();
+    for (const Article &article : list) {
+        const int articleIndex = indexOfArticle(m_articles, article);
+        if (articleIndex != -1) {
+            m_articles.remove(articleIndex);
+        }
+        const int index = indexOfArticle(m_combinedArticles, article);
+        if (index != -1) {
+            removeCombinedArticleAt(index);
+        }
     }
+    runPendingScript();
 }
 
 void ArticleViewerWidget::slotClear()
@@ -304,6 +598,10 @@ void ArticleViewerWidget::slotClear()
     m_node = nullptr;
     m_article = Article();
     m_articles.clear();
+    m_combinedArticles.clear();
+    m_materializedCount = 0;
+    m_pendingScript.clear();
+    m_pageLoading = false;
 
     renderContent(QString());
 }
@@ -354,7 +652,10 @@ void ArticleViewerWidget::slotArticlesListed(KJob *job)
     }
 
     m_articles = m_listJob->articles();
-    std::sort(m_articles.begin(), m_articles.end());
+    // the articles of a single feed come ordered by date already, only folders need merging
+    if (!std::is_sorted(m_articles.constBegin(), m_articles.constEnd())) {
+        std::sort(m_articles.begin(), m_articles.end());
+    }
 
     if (node && !m_articles.isEmpty()) {
         m_link = m_articles.first().link();
@@ -379,6 +680,7 @@ void ArticleViewerWidget::updateAfterConfigChanged()
         }
         break;
     case CombinedView:
+        m_fragmentCache.clear();
         slotUpdateCombinedView();
         break;
     case SummaryView:
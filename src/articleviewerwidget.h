@@ -31,6 +31,7 @@
 
 #include <QPointer>
 
+#include <QCache>
 #include <QSharedPointer>
 #include <vector>
 #include <QUrl>
@@ -122,6 +123,11 @@ protected Q_SLOTS:
     void slotArticlesAdded(Akregator::TreeNode *node, const QVector<Akregator::Article> &list);
     void slotArticlesRemoved(Akregator::TreeNode *node, const QVector<Akregator::Article> &list);
 
+private Q_SLOTS:
+    void slotLoadFinished();
+    /** materializes further articles of the combined view when the end of the page comes near the viewport */
+    void slotMaterializeArticles();
+
     // from ArticleViewer
 private:
     QSharedPointer<ArticleFormatter> combinedViewFormatter();
@@ -144,6 +150,21 @@ private:
 
     void setArticleActionsEnabled(bool enabled);
 
+    /** whether @p article is shown in the combined view with the current filters */
+    bool acceptsArticle(const Article &article) const;
+
+    /** returns the HTML of each of @p articles in the combined view, rendering only those not cached */
+    QStringList articleFragments(const QVector<Article> &articles);
+
+    /** the combined view patches the page instead of reloading it. These update m_combinedArticles and
+        queue the DOM changes, runPendingScript() sends them to the page */
+    void insertCombinedArticle(const Article &article);
+    void removeCombinedArticleAt(int index);
+    void replaceCombinedArticleAt(int index, const Article &article);
+    /** adds the next @p count articles of m_combinedArticles to the page */
+    void materializeArticles(int count);
+    void runPendingScript();
+
 private:
     QString m_currentText;
     QUrl m_imageDir;
@@ -151,6 +172,17 @@ private:
     QPointer<ArticleListJob> m_listJob;
     Article m_article;
     QVector<Article> m_articles;
+    /** the articles of m_articles passing the filters, newest first. Only the first m_materializedCount are in the page */
+    QVector<Article> m_combinedArticles;
+    int m_materializedCount = 0;
+    /** whether the combined view page is being loaded, DOM changes made meanwhile would get lost */
+    bool m_pageLoading = false;
+    bool m_pageOutdated = false;
+    /** identifies the combined view page, so that changes meant for a previous page are not applied */
+    int m_pageGeneration = 0;
+    QString m_pendingScript;
+    /** rendered article fragments by feed, guid, hash and status */
+    QCache<QString, QString> m_fragmentCache;
     QUrl m_link;
     std::vector<QSharedPointer<const Filters::AbstractMatcher> > m_filters;
     enum ViewMode {
@@ -0,0 +1,245 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "articleingestbenchmark.h"
+#include "dummystorage/storagedummyimpl.h"
+#include "feedstorage.h"
+#include "storagemk4impl.h"
+
+#include <QHash>
+#include <QScopedPointer>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace Akregator::Backend;
+
+namespace {
+/** articles of one fetch, a busy feed sends that many */
+const int ArticleCount = 500;
+
+enum Api {
+    FieldSetters,
+    WriteArticle,
+    ApplyChanges
+};
+
+struct StorageCloser
+{
+    static void cleanup(Storage *storage)
+    {
+        if (storage) {
+            storage->close();
+            delete storage;
+        }
+    }
+};
+
+typedef QScopedPointer<Storage, StorageCloser> StoragePointer;
+
+void addRows()
+{
+    QTest::addColumn<QString>("backend");
+    QTest::addColumn<int>("api");
+    const QString backends[] = { QStringLiteral("dummy"), QStringLiteral("metakit") };
+    for (const QString &backend : backends) {
+        QTest::newRow(qPrintable(backend + QLatin1String(", field setters"))) << backend << int(FieldSetters);
+        QTest::newRow(qPrintable(backend + QLatin1String(", writeArticle"))) << backend << int(WriteArticle);
+        QTest::newRow(qPrintable(backend + QLatin1String(", applyChanges"))) << backend << int(ApplyChanges);
+    }
+}
+
+Storage *createStorage(const QString &backend, const QString &path)
+{
+    Storage *storage = nullptr;
+    if (backend == QLatin1String("dummy")) {
+        storage = new StorageDummyImpl;
+    } else {
+        StorageMK4Impl *mk4Storage = new StorageMK4Impl;
+        mk4Storage->setArchivePath(path);
+        storage = mk4Storage;
+    }
+    storage->open(false);
+    return storage;
+}
+
+QString guid(int number)
+{
+    return QStringLiteral("http://localhost/article%1").arg(number);
+}
+
+/** an article as a parsed item yields it, @p version changes every field an update may touch */
+ArticleRecord record(int number, int version)
+{
+    ArticleRecord record;
+    record.title = QStringLiteral("Article %1, version %2").arg(number).arg(version);
+    record.description = QStringLiteral("Version %1 of a description that is about as long as most feeds send them. ").arg(version).repeated(4);
+    record.link = QStringLiteral("http://localhost/article%1.html").arg(number);
+    record.commentsLink = QStringLiteral("http://localhost/article%1/comments").arg(number);
+    record.authorName = QStringLiteral("Konqi");
+    record.authorEMail = QStringLiteral("konqi@kde.org");
+    record.hash = number * 16 + version;
+    record.pubDate = 1500000000 + number;
+    record.comments = version;
+    record.guidIsPermaLink = true;
+    return record;
+}
+
+/** writes the articles field by field, like the ingest did before the record API */
+void writeFields(FeedStorage *archive, const QHash<QString, ArticleRecord> &records)
+{
+    for (auto it = records.constBegin(), end = records.constEnd(); it != end; ++it) {
+        const QString &guid = it.key();
+        const ArticleRecord &record = it.value();
+        if (!archive->contains(guid)) {
+            archive->addEntry(guid);
+        }
+        archive->setHash(guid, record.hash);
+        archive->setTitle(guid, record.title);
+        archive->setDescription(guid, record.description);
+        archive->setContent(guid, record.content);
+        archive->setLink(guid, record.link);
+        archive->setCommentsLink(guid, record.commentsLink);
+        archive->setComments(guid, record.comments);
+        archive->setGuidIsHash(guid, record.guidIsHash);
+        archive->setGuidIsPermaLink(guid, record.guidIsPermaLink);
+        archive->setPubDate(guid, record.pubDate);
+        archive->setStatus(guid, record.status);
+        archive->setAuthorName(guid, record.authorName);
+        archive->setAuthorUri(guid, record.authorUri);
+        archive->setAuthorEMail(guid, record.authorEMail);
+        if (record.hasEnclosure) {
+            archive->setEnclosure(guid, record.enclosureUrl, record.enclosureType, record.enclosureLength);
+        } else {
+            archive->removeEnclosure(guid);
+        }
+    }
+    archive->setUnread(records.count());
+}
+
+void ingest(FeedStorage *archive, int api, const QHash<QString, ArticleRecord> &records)
+{
+    switch (api) {
+    case FieldSetters:
+        writeFields(archive, records);
+        break;
+    case WriteArticle:
+        for (auto it = records.constBegin(), end = records.constEnd(); it != end; ++it) {
+            archive->writeArticle(it.key(), it.value());
+        }
+        archive->setUnread(records.count());
+        break;
+    case ApplyChanges:
+        archive->applyChanges(records, QStringList(), records.count());
+        break;
+    }
+}
+
+QHash<QString, ArticleRecord> records(int version)
+{
+    QHash<QString, ArticleRecord> records;
+    records.reserve(ArticleCount);
+    for (int i = 0; i < ArticleCount; ++i) {
+        records.insert(guid(i), record(i, version));
+    }
+    return records;
+}
+}
+
+ArticleIngestBenchmark::ArticleIngestBenchmark(QObject *parent)
+    : QObject(parent)
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+ArticleIngestBenchmark::~ArticleIngestBenchmark()
+{
+}
+
+void ArticleIngestBenchmark::init()
+{
+    mDir = new QTemporaryDir;
+    QVERIFY(mDir->isValid());
+}
+
+void ArticleIngestBenchmark::cleanup()
+{
+    delete mDir;
+    mDir = nullptr;
+}
+
+void ArticleIngestBenchmark::ingestNew_data()
+{
+    addRows();
+}
+
+void ArticleIngestBenchmark::ingestNew()
+{
+    QFETCH(QString, backend);
+    QFETCH(int, api);
+    StoragePointer storage(createStorage(backend, mDir->path()));
+    const QHash<QString, ArticleRecord> fetched = records(0);
+
+    // the first fetch of a feed, every iteration writes to an empty archive of its own
+    int feed = 0;
+    QBENCHMARK {
+        FeedStorage *archive = storage->archiveFor(QStringLiteral("http://localhost/feed%1.xml").arg(feed++));
+        ingest(archive, api, fetched);
+        storage->commit();
+    }
+
+    ArticleRecord stored;
+    QVERIFY(storage->archiveFor(QStringLiteral("http://localhost/feed0.xml"))->readArticle(guid(ArticleCount - 1), stored));
+    QCOMPARE(stored.title, fetched.value(guid(ArticleCount - 1)).title);
+}
+
+void ArticleIngestBenchmark::ingestChanged_data()
+{
+    addRows();
+}
+
+void ArticleIngestBenchmark::ingestChanged()
+{
+    QFETCH(QString, backend);
+    QFETCH(int, api);
+    StoragePointer storage(createStorage(backend, mDir->path()));
+    FeedStorage *archive = storage->archiveFor(QStringLiteral("http://localhost/feed.xml"));
+    const QHash<QString, ArticleRecord> versions[] = { records(0), records(1) };
+    archive->applyChanges(versions[0], QStringList(), ArticleCount);
+    storage->commit();
+
+    // a fetch updating every article of the feed, the iterations alternate between two versions so that each one changes the stored data
+    int version = 0;
+    QBENCHMARK {
+        version = 1 - version;
+        ingest(archive, api, versions[version]);
+        storage->commit();
+    }
+
+    ArticleRecord stored;
+    QVERIFY(archive->readArticle(guid(0), stored));
+    QCOMPARE(stored.title, versions[version].value(guid(0)).title);
+}
+
+QTEST_GUILESS_MAIN(ArticleIngestBenchmark)
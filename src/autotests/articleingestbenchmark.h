@@ -0,0 +1,52 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef ARTICLEINGESTBENCHMARK_H
+#define ARTICLEINGESTBENCHMARK_H
+
+#include <QObject>
+
+class QTemporaryDir;
+
+/** compares writing fetched articles field by field with writing them as records, on the dummy and the metakit storage */
+class ArticleIngestBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ArticleIngestBenchmark(QObject *parent = nullptr);
+    ~ArticleIngestBenchmark();
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void ingestNew_data();
+    void ingestNew();
+    void ingestChanged_data();
+    void ingestChanged();
+
+private:
+    QTemporaryDir *mDir = nullptr;
+};
+
+#endif // ARTICLEINGESTBENCHMARK_H
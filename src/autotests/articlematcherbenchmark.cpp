@@ -0,0 +1,268 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "articlematcherbenchmark.h"
+#include "articlematcher.h"
+#include "dummystorage/storagedummyimpl.h"
+#include "types.h"
+
+#include <Syndication/Syndication>
+
+#include <QRegExp>
+#include <QTest>
+
+using namespace Akregator;
+using namespace Akregator::Filters;
+
+namespace {
+const int ArticleCount = 100000;
+/** articles parsed at once, a single document with all of them would take too much memory */
+const int ArticlesPerDocument = 1000;
+
+enum Scenario {
+    TitleContains,
+    DescriptionContains,
+    TitleMatches,
+    StatusEquals,
+    KeepEquals,
+    TitleAndDescription,
+    TitleOrNotAuthor
+};
+
+void addScenarioRows()
+{
+    QTest::addColumn<int>("scenario");
+    QTest::newRow("title contains") << int(TitleContains);
+    QTest::newRow("description contains") << int(DescriptionContains);
+    QTest::newRow("title matches") << int(TitleMatches);
+    QTest::newRow("status equals") << int(StatusEquals);
+    QTest::newRow("keep equals") << int(KeepEquals);
+    QTest::newRow("title and description contain") << int(TitleAndDescription);
+    QTest::newRow("title contains or author does not") << int(TitleOrNotAuthor);
+}
+
+/** the criteria of a quick search or filter, as the search bar creates them */
+QVector<Criterion> criteriaFor(int scenario, ArticleMatcher::Association &association)
+{
+    association = ArticleMatcher::LogicalAnd;
+    switch (scenario) {
+    case TitleContains:
+        return { Criterion(Criterion::Title, Criterion::Contains, QStringLiteral("KDE")) };
+    case DescriptionContains:
+        return { Criterion(Criterion::Description, Criterion::Contains, QStringLiteral("release")) };
+    case TitleMatches:
+        return { Criterion(Criterion::Title, Criterion::Matches, QStringLiteral("Article [0-9]+7 ")) };
+    case StatusEquals:
+        return { Criterion(Criterion::Status, Criterion::Equals, int(New)) };
+    case KeepEquals:
+        return { Criterion(Criterion::KeepFlag, Criterion::Equals, QStringLiteral("true")) };
+    case TitleAndDescription:
+        return { Criterion(Criterion::Title, Criterion::Contains, QStringLiteral("article")),
+                 Criterion(Criterion::Description, Criterion::Contains, QStringLiteral("plasma")) };
+    case TitleOrNotAuthor:
+        association = ArticleMatcher::LogicalOr;
+        return { Criterion(Criterion::Title, Criterion::Contains, QStringLiteral("KDE")),
+                 Criterion(Criterion::Author, Criterion::Predicate(Criterion::Contains | Criterion::Negation), QStringLiteral("Konqi")) };
+    }
+    return QVector<Criterion>();
+}
+
+/** evaluates a criterion like ArticleMatcher did before the criteria were compiled */
+bool satisfiedByReference(const Criterion &criterion, const Article &article)
+{
+    QVariant concreteSubject;
+    switch (criterion.subject()) {
+    case Criterion::Title:
+        concreteSubject = QVariant(article.title());
+        break;
+    case Criterion::Description:
+        concreteSubject = QVariant(article.description());
+        break;
+    case Criterion::Link:
+        concreteSubject = QVariant(article.link().url());
+        break;
+    case Criterion::Status:
+        concreteSubject = QVariant(article.status());
+        break;
+    case Criterion::KeepFlag:
+        concreteSubject = QVariant(article.keep());
+        break;
+    case Criterion::Author:
+        concreteSubject = QVariant(article.authorName());
+        break;
+    }
+
+    bool satisfied = false;
+    const Criterion::Predicate predicateType = static_cast<Criterion::Predicate>(criterion.predicate() & ~Criterion::Negation);
+    const QString subjectType = QLatin1String(concreteSubject.typeName());
+    switch (predicateType) {
+    case Criterion::Contains:
+        satisfied = concreteSubject.toString().indexOf(criterion.object().toString(), 0, Qt::CaseInsensitive) != -1;
+        break;
+    case Criterion::Equals:
+        if (subjectType == QLatin1String("int")) {
+            satisfied = concreteSubject.toInt() == criterion.object().toInt();
+        } else {
+            satisfied = concreteSubject.toString() == criterion.object().toString();
+        }
+        break;
+    case Criterion::Matches:
+        satisfied = QRegExp(criterion.object().toString()).indexIn(concreteSubject.toString()) != -1;
+        break;
+    default:
+        break;
+    }
+    if (criterion.predicate() & Criterion::Negation) {
+        satisfied = !satisfied;
+    }
+    return satisfied;
+}
+
+bool matchesReference(const QVector<Criterion> &criteria, ArticleMatcher::Association association, const Article &article)
+{
+    for (const Criterion &criterion : criteria) {
+        const bool satisfied = satisfiedByReference(criterion, article);
+        if (association == ArticleMatcher::LogicalOr && satisfied) {
+            return true;
+        }
+        if (association == ArticleMatcher::LogicalAnd && !satisfied) {
+            return false;
+        }
+    }
+    return association == ArticleMatcher::LogicalAnd;
+}
+
+QByteArray rssDocument(int first, int count)
+{
+    static const char *const topics[] = { "KDE", "Plasma", "Akregator", "release", "kernel", "desktop" };
+    QByteArray rss = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><rss version=\"2.0\"><channel><title>Benchmark</title>";
+    for (int i = first; i < first + count; ++i) {
+        const QByteArray number = QByteArray::number(i);
+        const char *const topic = topics[i % 6];
+        const char *const otherTopic = topics[(i / 6) % 6];
+        rss += "<item><guid>article-" + number + "</guid>"
+               "<title>Article " + number + " about " + topic + "</title>"
+               "<author>" + (i % 3 ? "konqi@kde.org (Konqi)" : "katie@kde.org (Katie)") + "</author>"
+               "<description>";
+        for (int sentence = 0; sentence < 8; ++sentence) {
+            rss += "This sentence talks about ";
+            rss += sentence % 2 ? topic : otherTopic;
+            rss += " and fills the description like a real article would. ";
+        }
+        rss += "</description></item>";
+    }
+    rss += "</channel></rss>";
+    return rss;
+}
+}
+
+ArticleMatcherBenchmark::ArticleMatcherBenchmark(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ArticleMatcherBenchmark::~ArticleMatcherBenchmark()
+{
+}
+
+void ArticleMatcherBenchmark::initTestCase()
+{
+    const QString url = QStringLiteral("http://localhost/benchmark.xml");
+    mStorage = new Backend::StorageDummyImpl;
+    Backend::FeedStorage *archive = mStorage->archiveFor(url);
+
+    mArticles.reserve(ArticleCount);
+    for (int first = 0; first < ArticleCount; first += ArticlesPerDocument) {
+        const Syndication::DocumentSource source(rssDocument(first, ArticlesPerDocument), url);
+        const Syndication::FeedPtr feed = Syndication::parserCollection()->parse(source);
+        QVERIFY(feed);
+        const QList<Syndication::ItemPtr> items = feed->items();
+        for (const Syndication::ItemPtr &item : items) {
+            mArticles.append(Article(item, archive));
+        }
+    }
+    QCOMPARE(mArticles.count(), ArticleCount);
+}
+
+void ArticleMatcherBenchmark::cleanupTestCase()
+{
+    mArticles.clear();
+    delete mStorage;
+    mStorage = nullptr;
+}
+
+void ArticleMatcherBenchmark::compiled_data()
+{
+    addScenarioRows();
+}
+
+void ArticleMatcherBenchmark::compiled()
+{
+    QFETCH(int, scenario);
+    ArticleMatcher::Association association;
+    const QVector<Criterion> criteria = criteriaFor(scenario, association);
+    const ArticleMatcher matcher(criteria, association);
+
+    int count = 0;
+    QBENCHMARK {
+        count = 0;
+        for (const Article &article : qAsConst(mArticles)) {
+            if (matcher.matches(article)) {
+                ++count;
+            }
+        }
+    }
+
+    int expected = 0;
+    for (const Article &article : qAsConst(mArticles)) {
+        if (matchesReference(criteria, association, article)) {
+            ++expected;
+        }
+    }
+    QCOMPARE(count, expected);
+}
+
+void ArticleMatcherBenchmark::uncompiled_data()
+{
+    addScenarioRows();
+}
+
+void ArticleMatcherBenchmark::uncompiled()
+{
+    QFETCH(int, scenario);
+    ArticleMatcher::Association association;
+    const QVector<Criterion> criteria = criteriaFor(scenario, association);
+
+    QBENCHMARK {
+        int count = 0;
+        for (const Article &article : qAsConst(mArticles)) {
+            if (matchesReference(criteria, association, article)) {
+                ++count;
+            }
+        }
+        Q_UNUSED(count);
+    }
+}
+
+QTEST_GUILESS_MAIN(ArticleMatcherBenchmark)
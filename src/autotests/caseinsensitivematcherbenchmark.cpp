@@ -0,0 +1,142 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "caseinsensitivematcherbenchmark.h"
+#include "caseinsensitivematcher.h"
+
+#include <QTest>
+#include <QVector>
+
+using namespace Akregator::Filters;
+
+Q_DECLARE_METATYPE(Akregator::Filters::CaseInsensitiveMatcher::Scanner)
+
+namespace {
+/** a description of about 32 KB, like the long articles of news sites */
+QString description(bool german)
+{
+    const QString sentence = german ? QStringLiteral("Über die Änderungen an der Straße wurde lange gestritten. ")
+                             : QStringLiteral("The quick brown fox jumps over the lazy dog, again and again. ");
+    QString text;
+    while (text.size() < 32 * 1024) {
+        text += sentence;
+    }
+    return text;
+}
+
+struct TextCase {
+    const char *name;
+    QString text;
+    QString needle;
+};
+
+QVector<TextCase> textCases()
+{
+    // mostly the needle is missing, as for most articles while typing a search
+    const QString english = description(false);
+    return {
+        { "english, rare first letter", english, QStringLiteral("Akregator") },
+        { "english, frequent first letter", english, QStringLiteral("Thunderbird") },
+        { "german, umlaut needle", description(true), QStringLiteral("Ärgernis") },
+        { "english, match at the end", english + QStringLiteral("AKREGATOR"), QStringLiteral("akregator") },
+    };
+}
+}
+
+CaseInsensitiveMatcherBenchmark::CaseInsensitiveMatcherBenchmark(QObject *parent)
+    : QObject(parent)
+{
+}
+
+CaseInsensitiveMatcherBenchmark::~CaseInsensitiveMatcherBenchmark()
+{
+}
+
+void CaseInsensitiveMatcherBenchmark::cleanup()
+{
+    CaseInsensitiveMatcher::setScanner(CaseInsensitiveMatcher::DefaultScanner);
+}
+
+void CaseInsensitiveMatcherBenchmark::indexOf_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("needle");
+    const QVector<TextCase> cases = textCases();
+    for (const TextCase &textCase : cases) {
+        QTest::newRow(textCase.name) << textCase.text << textCase.needle;
+    }
+}
+
+void CaseInsensitiveMatcherBenchmark::indexOf()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, needle);
+    int pos = 0;
+    QBENCHMARK {
+        pos = text.indexOf(needle, 0, Qt::CaseInsensitive);
+    }
+    QCOMPARE(pos, CaseInsensitiveMatcher(needle).indexIn(text));
+}
+
+void CaseInsensitiveMatcherBenchmark::matcher_data()
+{
+    QTest::addColumn<CaseInsensitiveMatcher::Scanner>("scanner");
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("needle");
+
+    const struct {
+        const char *name;
+        CaseInsensitiveMatcher::Scanner scanner;
+    } scanners[] = {
+        { "scalar", CaseInsensitiveMatcher::ScalarScanner },
+        { "sse2", CaseInsensitiveMatcher::Sse2Scanner },
+        { "avx2", CaseInsensitiveMatcher::Avx2Scanner },
+    };
+    const QVector<TextCase> cases = textCases();
+    for (const auto &scanner : scanners) {
+        for (const TextCase &textCase : cases) {
+            const QByteArray name = QByteArray(scanner.name) + ", " + textCase.name;
+            QTest::newRow(name.constData()) << scanner.scanner << textCase.text << textCase.needle;
+        }
+    }
+}
+
+void CaseInsensitiveMatcherBenchmark::matcher()
+{
+    QFETCH(CaseInsensitiveMatcher::Scanner, scanner);
+    QFETCH(QString, text);
+    QFETCH(QString, needle);
+    if (!CaseInsensitiveMatcher::setScanner(scanner)) {
+        QSKIP("The CPU does not support this scanner");
+    }
+
+    const CaseInsensitiveMatcher matcher(needle);
+    int pos = 0;
+    QBENCHMARK {
+        pos = matcher.indexIn(text);
+    }
+    QCOMPARE(pos, text.indexOf(needle, 0, Qt::CaseInsensitive));
+}
+
+QTEST_GUILESS_MAIN(CaseInsensitiveMatcherBenchmark)
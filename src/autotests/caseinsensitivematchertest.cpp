@@ -0,0 +1,155 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "caseinsensitivematchertest.h"
+#include "caseinsensitivematcher.h"
+
+#include <QDebug>
+#include <QTest>
+
+#include <random>
+
+using namespace Akregator::Filters;
+
+Q_DECLARE_METATYPE(Akregator::Filters::CaseInsensitiveMatcher::Scanner)
+
+namespace {
+void addScannerRows()
+{
+    QTest::addColumn<CaseInsensitiveMatcher::Scanner>("scanner");
+    QTest::newRow("scalar") << CaseInsensitiveMatcher::ScalarScanner;
+    QTest::newRow("sse2") << CaseInsensitiveMatcher::Sse2Scanner;
+    QTest::newRow("avx2") << CaseInsensitiveMatcher::Avx2Scanner;
+}
+
+/** compares the matcher with QString::indexOf() for every start position, including negative ones */
+bool matchesLikeIndexOf(const QString &text, const QString &needle)
+{
+    const CaseInsensitiveMatcher matcher(needle);
+    for (int from = -text.size(); from <= text.size() + 1; ++from) {
+        const int expected = text.indexOf(needle, from, Qt::CaseInsensitive);
+        const int actual = matcher.indexIn(text, from);
+        if (actual != expected) {
+            qWarning() << "needle" << needle << "from" << from << "found at" << actual << "instead of" << expected << "in" << text;
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+CaseInsensitiveMatcherTest::CaseInsensitiveMatcherTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+CaseInsensitiveMatcherTest::~CaseInsensitiveMatcherTest()
+{
+}
+
+void CaseInsensitiveMatcherTest::cleanup()
+{
+    CaseInsensitiveMatcher::setScanner(CaseInsensitiveMatcher::DefaultScanner);
+}
+
+void CaseInsensitiveMatcherTest::shouldMatchLikeIndexOf_data()
+{
+    addScannerRows();
+}
+
+void CaseInsensitiveMatcherTest::shouldMatchLikeIndexOf()
+{
+    QFETCH(CaseInsensitiveMatcher::Scanner, scanner);
+    if (!CaseInsensitiveMatcher::setScanner(scanner)) {
+        QSKIP("The CPU does not support this scanner");
+    }
+
+    const QString deseretUpper = QString::fromUtf16(u"\U00010400");
+    const QString deseretLower = QString::fromUtf16(u"\U00010428");
+    const QStringList needles = {
+        QString(),
+        QStringLiteral("a"),
+        QStringLiteral("Feed"),
+        QStringLiteral("AKREGATOR"),
+        QStringLiteral("@"),
+        QStringLiteral("[z"),
+        QStringLiteral("Ärger"),
+        QStringLiteral("grüße"),
+        QStringLiteral("Αθ"),
+        deseretUpper,
+        QStringLiteral("x") + deseretLower,
+    };
+
+    // put each needle at every position of texts longer than both vector widths, so matches cross the chunk borders
+    const QString filler = QStringLiteral("The quick brown fox jumps over the lazy dog ");
+    for (const QString &needle : needles) {
+        for (int pos = 0; pos <= 40; ++pos) {
+            QString text = filler.left(pos);
+            text += needle.toUpper();
+            text += filler;
+            QVERIFY(matchesLikeIndexOf(text, needle));
+            QVERIFY(matchesLikeIndexOf(text.toLower(), needle));
+            QVERIFY(matchesLikeIndexOf(filler.left(pos), needle));
+        }
+    }
+
+    // non-ASCII characters are candidates as well, and a lone surrogate must not be folded with its neighbour
+    QVERIFY(matchesLikeIndexOf(QStringLiteral("äÄä ÄRGER"), QStringLiteral("ärger")));
+    QVERIFY(matchesLikeIndexOf(QStringLiteral("aaaa") + deseretUpper + QStringLiteral("aaaaaaaaaaaaaaaaaaaaa"), deseretLower));
+    QVERIFY(matchesLikeIndexOf(QString(QChar(0xdc28)) + QStringLiteral("abcdefghijklmnopq"), QString(QChar(0xdc28))));
+}
+
+void CaseInsensitiveMatcherTest::shouldMatchRandomTextLikeIndexOf_data()
+{
+    addScannerRows();
+}
+
+void CaseInsensitiveMatcherTest::shouldMatchRandomTextLikeIndexOf()
+{
+    QFETCH(CaseInsensitiveMatcher::Scanner, scanner);
+    if (!CaseInsensitiveMatcher::setScanner(scanner)) {
+        QSKIP("The CPU does not support this scanner");
+    }
+
+    // a small alphabet, so that there are many partial matches
+    const QString alphabet = QStringLiteral("aAbB äÄΣσ") + QString::fromUtf16(u"\U00010400\U00010428");
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> letter(0, alphabet.size() - 1);
+    std::uniform_int_distribution<int> textLength(0, 70);
+    for (int round = 0; round < 200; ++round) {
+        QString text;
+        const int length = textLength(random);
+        for (int i = 0; i < length; ++i) {
+            text += alphabet.at(letter(random));
+        }
+        std::uniform_int_distribution<int> start(0, text.size());
+        const int from = start(random);
+        std::uniform_int_distribution<int> needleLength(1, 4);
+        const QString needle = text.mid(from, needleLength(random));
+        QVERIFY(matchesLikeIndexOf(text, needle));
+        QVERIFY(matchesLikeIndexOf(text, needle.toUpper()));
+    }
+}
+
+QTEST_GUILESS_MAIN(CaseInsensitiveMatcherTest)
@@ -0,0 +1,150 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "feedretrievertest.h"
+#include "feedretriever.h"
+
+#include <QCryptographicHash>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTest>
+#include <QUrl>
+
+using namespace Akregator;
+
+namespace {
+const char Document[] = "<?xml version=\"1.0\"?><rss version=\"2.0\"><channel><title>Test</title></channel></rss>";
+const char Etag[] = "\"akregator-test\"";
+const char LastModified[] = "Wed, 21 Oct 2015 07:28:00 GMT";
+}
+
+FeedRetrieverTest::FeedRetrieverTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+FeedRetrieverTest::~FeedRetrieverTest()
+{
+}
+
+void FeedRetrieverTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+
+    // replies 304 if the request carries the ETag of the document, else 200 with the document
+    mServer = new QTcpServer(this);
+    QVERIFY(mServer->listen(QHostAddress::LocalHost));
+    connect(mServer, &QTcpServer::newConnection, this, [this]() {
+        QTcpSocket *socket = mServer->nextPendingConnection();
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            mRequest += socket->readAll();
+            if (!mRequest.contains("\r\n\r\n")) {
+                return;
+            }
+            QByteArray reply;
+            if (mRequest.contains(QByteArray("If-None-Match: ") + Etag)) {
+                reply = QByteArray("HTTP/1.1 304 Not Modified\r\n"
+                                   "ETag: ") + Etag + "\r\n"
+                        "Connection: close\r\n"
+                        "\r\n";
+            } else {
+                const QByteArray body(Document);
+                reply = QByteArray("HTTP/1.1 200 OK\r\n"
+                                   "Content-Type: application/rss+xml\r\n"
+                                   "ETag: ") + Etag + "\r\n"
+                        "Last-Modified: " + LastModified + "\r\n"
+                        "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                        "Connection: close\r\n"
+                        "\r\n" + body;
+            }
+            socket->write(reply);
+            socket->disconnectFromHost();
+        });
+    });
+}
+
+void FeedRetrieverTest::init()
+{
+    mRequest.clear();
+}
+
+void FeedRetrieverTest::shouldReceiveDocumentAndValidators()
+{
+    FeedRetriever retriever(QString(), QString(), QByteArray());
+    QSignalSpy validatorsSpy(&retriever, &FeedRetriever::validatorsReceived);
+    QSignalSpy dataSpy(&retriever, &FeedRetriever::dataRetrieved);
+    retriever.retrieveData(QUrl(QStringLiteral("http://127.0.0.1:%1/feed.xml").arg(mServer->serverPort())));
+    QVERIFY(dataSpy.wait(10000));
+
+    QVERIFY(!mRequest.contains("If-None-Match"));
+    QCOMPARE(retriever.errorCode(), 0);
+    QCOMPARE(dataSpy.count(), 1);
+    QCOMPARE(dataSpy.at(0).at(0).toByteArray(), QByteArray(Document));
+    QVERIFY(dataSpy.at(0).at(1).toBool());
+
+    QCOMPARE(validatorsSpy.count(), 1);
+    QCOMPARE(validatorsSpy.at(0).at(0).toString(), QString::fromLatin1(Etag));
+    QCOMPARE(validatorsSpy.at(0).at(1).toString(), QString::fromLatin1(LastModified));
+    QVERIFY(!validatorsSpy.at(0).at(2).toByteArray().isEmpty());
+}
+
+void FeedRetrieverTest::shouldSendValidatorsAndReportNotModified()
+{
+    FeedRetriever retriever(QString::fromLatin1(Etag), QString::fromLatin1(LastModified), QByteArray());
+    QSignalSpy dataSpy(&retriever, &FeedRetriever::dataRetrieved);
+    retriever.retrieveData(QUrl(QStringLiteral("http://127.0.0.1:%1/feed.xml").arg(mServer->serverPort())));
+    QVERIFY(dataSpy.wait(10000));
+
+    QVERIFY(mRequest.contains(QByteArray("If-None-Match: ") + Etag));
+    QVERIFY(mRequest.contains(QByteArray("If-Modified-Since: ") + LastModified));
+    QCOMPARE(retriever.errorCode(), static_cast<int>(FeedRetriever::NotModified));
+    QCOMPARE(dataSpy.count(), 1);
+    QVERIFY(dataSpy.at(0).at(0).toByteArray().isEmpty());
+    QVERIFY(!dataSpy.at(0).at(1).toBool());
+}
+
+void FeedRetrieverTest::shouldReportUnchangedDocumentWithValidators()
+{
+    // without validators the server sends the document again, but it is the one fetched before
+    const QByteArray digest = QCryptographicHash::hash(QByteArray(Document), QCryptographicHash::Md5);
+    FeedRetriever retriever(QString(), QString(), digest);
+    QSignalSpy validatorsSpy(&retriever, &FeedRetriever::validatorsReceived);
+    QSignalSpy dataSpy(&retriever, &FeedRetriever::dataRetrieved);
+    retriever.retrieveData(QUrl(QStringLiteral("http://127.0.0.1:%1/feed.xml").arg(mServer->serverPort())));
+    QVERIFY(dataSpy.wait(10000));
+
+    QCOMPARE(retriever.errorCode(), static_cast<int>(FeedRetriever::Unchanged));
+    QCOMPARE(dataSpy.count(), 1);
+    QVERIFY(!dataSpy.at(0).at(1).toBool());
+
+    QCOMPARE(validatorsSpy.count(), 1);
+    QCOMPARE(validatorsSpy.at(0).at(0).toString(), QString::fromLatin1(Etag));
+    QCOMPARE(validatorsSpy.at(0).at(1).toString(), QString::fromLatin1(LastModified));
+    QCOMPARE(validatorsSpy.at(0).at(2).toByteArray(), digest);
+}
+
+QTEST_GUILESS_MAIN(FeedRetrieverTest)
@@ -0,0 +1,237 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "caseinsensitivematcher.h"
+
+#include <QtAlgorithms>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define AKREGATOR_MATCHER_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace Akregator::Filters;
+
+namespace {
+inline ushort asciiFold(ushort c)
+{
+    return (c >= 'A' && c <= 'Z') ? ushort(c + ('a' - 'A')) : c;
+}
+
+/** folds the character at @p pos like QString does, looking at the preceding high surrogate for characters outside the BMP */
+inline ushort foldAt(const ushort *text, int pos)
+{
+    const ushort c = text[pos];
+    if (c < 0x80) {
+        return asciiFold(c);
+    }
+    if (QChar::isLowSurrogate(c) && pos > 0 && QChar::isHighSurrogate(text[pos - 1])) {
+        return QChar::lowSurrogate(QChar::toCaseFolded(QChar::surrogateToUcs4(text[pos - 1], c)));
+    }
+    return ushort(QChar::toCaseFolded(uint(c)));
+}
+
+/**
+ * returns the first position in [from, end) holding @p lower, @p upper or a non-ASCII character, or @p end.
+ * Only ASCII letters fold to other ASCII characters, so every match of a needle starting with an ASCII
+ * character starts at such a position.
+ */
+typedef int (*CandidateFinder)(const ushort *text, int from, int end, ushort lower, ushort upper);
+
+int findCandidateScalar(const ushort *text, int from, int end, ushort lower, ushort upper)
+{
+    for (; from < end; ++from) {
+        const ushort c = text[from];
+        if (c == lower || c == upper || c >= 0x80) {
+            break;
+        }
+    }
+    return from;
+}
+
+#ifdef AKREGATOR_MATCHER_X86
+int findCandidateSse2(const ushort *text, int from, int end, ushort lower, ushort upper)
+{
+    const __m128i lowerVec = _mm_set1_epi16(short(lower));
+    const __m128i upperVec = _mm_set1_epi16(short(upper));
+    const __m128i nonAsciiBits = _mm_set1_epi16(short(0xff80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; from + 8 <= end; from += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + from));
+        const __m128i equal = _mm_or_si128(_mm_cmpeq_epi16(chunk, lowerVec), _mm_cmpeq_epi16(chunk, upperVec));
+        const __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(chunk, nonAsciiBits), zero);
+        // two mask bits per character
+        const uint mask = uint(_mm_movemask_epi8(equal)) | (~uint(_mm_movemask_epi8(ascii)) & 0xffffu);
+        if (mask) {
+            return from + int(qCountTrailingZeroBits(mask) / 2);
+        }
+    }
+    return findCandidateScalar(text, from, end, lower, upper);
+}
+
+__attribute__((target("avx2")))
+int findCandidateAvx2(const ushort *text, int from, int end, ushort lower, ushort upper)
+{
+    const __m256i lowerVec = _mm256_set1_epi16(short(lower));
+    const __m256i upperVec = _mm256_set1_epi16(short(upper));
+    const __m256i nonAsciiBits = _mm256_set1_epi16(short(0xff80));
+    const __m256i zero = _mm256_setzero_si256();
+    for (; from + 16 <= end; from += 16) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + from));
+        const __m256i equal = _mm256_or_si256(_mm256_cmpeq_epi16(chunk, lowerVec), _mm256_cmpeq_epi16(chunk, upperVec));
+        const __m256i ascii = _mm256_cmpeq_epi16(_mm256_and_si256(chunk, nonAsciiBits), zero);
+        const uint mask = uint(_mm256_movemask_epi8(equal)) | ~uint(_mm256_movemask_epi8(ascii));
+        if (mask) {
+            return from + int(qCountTrailingZeroBits(mask) / 2);
+        }
+    }
+    return findCandidateSse2(text, from, end, lower, upper);
+}
+#endif
+
+CandidateFinder selectCandidateFinder()
+{
+#ifdef AKREGATOR_MATCHER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return findCandidateAvx2;
+    }
+    return findCandidateSse2;
+#else
+    return findCandidateScalar;
+#endif
+}
+
+CandidateFinder s_findCandidate = selectCandidateFinder();
+}
+
+CaseInsensitiveMatcher::CaseInsensitiveMatcher()
+    : m_lower(0)
+    , m_upper(0)
+    , m_asciiFirst(false)
+{
+}
+
+CaseInsensitiveMatcher::CaseInsensitiveMatcher(const QString &needle)
+    : m_needle(needle)
+    , m_lower(0)
+    , m_upper(0)
+    , m_asciiFirst(false)
+{
+    const int length = needle.size();
+    const ushort *units = needle.utf16();
+    m_folded.resize(length);
+    for (int i = 0; i < length; ++i) {
+        m_folded[i] = QChar(foldAt(units, i));
+    }
+
+    if (length > 0 && m_folded.at(0).unicode() < 0x80) {
+        m_asciiFirst = true;
+        m_lower = m_folded.at(0).unicode();
+        m_upper = (m_lower >= 'a' && m_lower <= 'z') ? ushort(m_lower - ('a' - 'A')) : m_lower;
+    }
+}
+
+QString CaseInsensitiveMatcher::needle() const
+{
+    return m_needle;
+}
+
+int CaseInsensitiveMatcher::indexIn(const QString &text, int from) const
+{
+    return indexIn(text.constData(), text.size(), from);
+}
+
+int CaseInsensitiveMatcher::indexIn(const QChar *text, int length, int from) const
+{
+    if (from < 0) {
+        from = qMax(from + length, 0);
+    }
+    const int needleLength = m_folded.size();
+    if (needleLength == 0) {
+        return from <= length ? from : -1;
+    }
+    if (from > length - needleLength) {
+        return -1;
+    }
+
+    const ushort *units = reinterpret_cast<const ushort *>(text);
+    const int end = length - needleLength + 1;
+
+    if (!m_asciiFirst) {
+        for (int pos = from; pos < end; ++pos) {
+            if (matchesAt(units, pos)) {
+                return pos;
+            }
+        }
+        return -1;
+    }
+
+    const CandidateFinder findCandidate = s_findCandidate;
+    for (int pos = findCandidate(units, from, end, m_lower, m_upper); pos < end; pos = findCandidate(units, pos + 1, end, m_lower, m_upper)) {
+        if (matchesAt(units, pos)) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+bool CaseInsensitiveMatcher::setScanner(Scanner scanner)
+{
+    switch (scanner) {
+    case DefaultScanner:
+        s_findCandidate = selectCandidateFinder();
+        return true;
+    case ScalarScanner:
+        s_findCandidate = findCandidateScalar;
+        return true;
+#ifdef AKREGATOR_MATCHER_X86
+    case Sse2Scanner:
+        s_findCandidate = findCandidateSse2;
+        return true;
+    case Avx2Scanner:
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            s_findCandidate = findCandidateAvx2;
+            return true;
+        }
+        break;
+#endif
+    default:
+        break;
+    }
+    return false;
+}
+
+bool CaseInsensitiveMatcher::matchesAt(const ushort *text, int pos) const
+{
+    const ushort *folded = m_folded.utf16();
+    const int needleLength = m_folded.size();
+    for (int i = 0; i < needleLength; ++i) {
+        if (foldAt(text, pos + i) != folded[i]) {
+            return false;
+        }
+    }
+    return true;
+}
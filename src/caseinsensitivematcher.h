@@ -0,0 +1,78 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_CASEINSENSITIVEMATCHER_H
+#define AKREGATOR_CASEINSENSITIVEMATCHER_H
+
+#include "akregatorpart_export.h"
+
+#include <QString>
+
+namespace Akregator {
+namespace Filters {
+/**
+ * Case-insensitive substring search over UTF-16 text, giving the same results as
+ * QString::indexOf(needle, from, Qt::CaseInsensitive).
+ *
+ * The needle is folded once. The text is scanned for candidate positions with SSE2 or AVX2,
+ * whichever the CPU supports, and only the candidates are compared character by character.
+ * Other platforms use a plain loop.
+ */
+class AKREGATORPART_EXPORT CaseInsensitiveMatcher
+{
+public:
+    enum Scanner {
+        DefaultScanner, /**< the fastest scanner the CPU supports */
+        ScalarScanner,
+        Sse2Scanner,
+        Avx2Scanner
+    };
+
+    CaseInsensitiveMatcher();
+    explicit CaseInsensitiveMatcher(const QString &needle);
+
+    QString needle() const;
+
+    /** returns the position of the first match at or after @p from, or -1 */
+    int indexIn(const QString &text, int from = 0) const;
+    int indexIn(const QChar *text, int length, int from = 0) const;
+
+    /** makes all matchers scan with @p scanner, for tests and benchmarks. Returns false if the CPU does not support it. */
+    static bool setScanner(Scanner scanner);
+
+private:
+    bool matchesAt(const ushort *text, int pos) const;
+
+    QString m_needle;
+    /** the needle folded character by character */
+    QString m_folded;
+    /** the ASCII spellings of the first folded character, only used when m_asciiFirst is set */
+    ushort m_lower;
+    ushort m_upper;
+    bool m_asciiFirst;
+};
+} // namespace Filters
+} // namespace Akregator
+
+#endif // AKREGATOR_CASEINSENSITIVEMATCHER_H
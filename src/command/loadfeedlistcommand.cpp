@@ -38,6 +38,7 @@
 #include <QString>
 #include <QTimer>
 #include <QFileInfo>
+#include <QXmlStreamReader>
 
 #include <cassert>
 
@@ -54,6 +55,7 @@ public:
     }
 
     void handleDocument(const QDomDocument &doc);
+    void handleFeedList(const QSharedPointer<FeedList> &feedList, bool parsed);
     QString createBackup(const QString &path, bool *ok);
     void emitResult(const QSharedPointer<FeedList> &list);
     void doLoad();
@@ -72,7 +74,13 @@ void LoadFeedListCommand::Private::emitResult(const QSharedPointer<FeedList> &li
 void LoadFeedListCommand::Private::handleDocument(const QDomDocument &doc)
 {
     QSharedPointer<FeedList> feedList(new FeedList(storage));
-    if (!feedList->readFromOpml(doc)) {
+    handleFeedList(feedList, feedList->readFromOpml(doc));
+}
+
+void LoadFeedListCommand::Private::handleFeedList(const QSharedPointer<FeedList> &list, bool parsed)
+{
+    QSharedPointer<FeedList> feedList(list);
+    if (!parsed) {
         bool backupCreated;
         const QString backupFile = createBackup(fileName, &backupCreated);
         const QString msg
@@ -151,8 +159,6 @@ void LoadFeedListCommand::Private::doLoad()
 
     const QString listBackup = storage->restoreFeedList();
 
-    QDomDocument doc;
-
     if (!QFileInfo::exists(fileName)) {
         handleDocument(defaultFeedList);
         return;
@@ -172,10 +178,15 @@ void LoadFeedListCommand::Private::doLoad()
         return;
     }
 
-    QString errMsg;
-    int errLine = 0;
-    int errCol = 0;
-    if (!doc.setContent(&file, true, &errMsg, &errLine, &errCol)) {
+    // read the list without building a DOM tree, the feeds load their archives later
+    QXmlStreamReader reader(&file);
+    QSharedPointer<FeedList> feedList(new FeedList(storage));
+    const bool parsed = feedList->readFromOpml(reader);
+    if (reader.hasError()) {
+        feedList.reset();
+        const QString errMsg = reader.errorString();
+        const qint64 errLine = reader.lineNumber();
+        const qint64 errCol = reader.columnNumber();
         bool backupCreated = false;
         const QString backupFile = createBackup(fileName, &backupCreated);
         const QString title = i18nc("error message window caption", "XML Parsing Error");
@@ -203,7 +214,7 @@ void LoadFeedListCommand::Private::doLoad()
         return;
     }
 
-    handleDocument(doc);
+    handleFeedList(feedList, parsed);
 }
 
 #include "moc_loadfeedlistcommand.cpp"
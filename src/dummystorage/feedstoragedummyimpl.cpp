@@ -25,13 +25,14 @@
 #include "feedstoragedummyimpl.h"
 #include "storagedummyimpl.h"
 
-#include <feed.h>
-
 #include <QHash>
 #include <QList>
 #include <QMap>
 #include <QString>
 #include <QStringList>
+#include <QVector>
+
+#include <algorithm>
 
 namespace Akregator {
 namespace Backend {
@@ -116,6 +117,14 @@ void FeedStorageDummyImpl::close()
 {
 }
 
+void FeedStorageDummyImpl::pin()
+{
+}
+
+void FeedStorageDummyImpl::unpin()
+{
+}
+
 int FeedStorageDummyImpl::unread() const
 {
     return d->mainStorage->unreadFor(d->url);
@@ -146,6 +155,26 @@ void FeedStorageDummyImpl::setLastFetch(int lastFetch)
     d->mainStorage->setLastFetchFor(d->url, lastFetch);
 }
 
+void FeedStorageDummyImpl::httpValidators(QString &etag, QString &lastModified) const
+{
+    d->mainStorage->httpValidatorsFor(d->url, etag, lastModified);
+}
+
+void FeedStorageDummyImpl::setHttpValidators(const QString &etag, const QString &lastModified)
+{
+    d->mainStorage->setHttpValidatorsFor(d->url, etag, lastModified);
+}
+
+QByteArray FeedStorageDummyImpl::contentDigest() const
+{
+    return d->mainStorage->contentDigestFor(d->url);
+}
+
+void FeedStorageDummyImpl::setContentDigest(const QByteArray &digest)
+{
+    d->mainStorage->setContentDigestFor(d->url, digest);
+}
+
 QStringList FeedStorageDummyImpl::articles(const QString &tag) const
 {
     return tag.isNull() ? QStringList(d->entries.keys()) : d->taggedArticles.value(tag);
@@ -156,6 +185,50 @@ QStringList FeedStorageDummyImpl::articles(const Category &cat) const
     return d->categorizedArticles.value(cat);
 }
 
+ArticleHeaders FeedStorageDummyImpl::articleHeaders() const
+{
+    ArticleHeaders headers;
+    headers.guids.reserve(d->entries.count());
+    headers.status.reserve(d->entries.count());
+    headers.hash.reserve(d->entries.count());
+    headers.pubDate.reserve(d->entries.count());
+    for (auto it = d->entries.constBegin(), end = d->entries.constEnd(); it != end; ++it) {
+        headers.guids.append(it.key());
+        headers.status.append(it.value().status);
+        headers.hash.append(it.value().hash);
+        headers.pubDate.append(it.value().pubDate);
+    }
+    return headers;
+}
+
+ArticleHeaders FeedStorageDummyImpl::articleHeadersByDate(uint from, uint to, int limit) const
+{
+    QVector<QString> guids;
+    for (auto it = d->entries.constBegin(), end = d->entries.constEnd(); it != end; ++it) {
+        if (it.value().pubDate >= from && it.value().pubDate < to) {
+            guids.append(it.key());
+        }
+    }
+    std::sort(guids.begin(), guids.end(), [this](const QString &lhs, const QString &rhs) {
+        const uint lhsDate = d->entries.value(lhs).pubDate;
+        const uint rhsDate = d->entries.value(rhs).pubDate;
+        return lhsDate > rhsDate || (lhsDate == rhsDate && lhs < rhs);
+    });
+    if (limit >= 0 && guids.count() > limit) {
+        guids.resize(limit);
+    }
+
+    ArticleHeaders headers;
+    for (const QString &guid : qAsConst(guids)) {
+        const FeedStorageDummyImplPrivate::Entry &entry = d->entries[guid];
+        headers.guids.append(guid);
+        headers.status.append(entry.status);
+        headers.hash.append(entry.hash);
+        headers.pubDate.append(entry.pubDate);
+    }
+    return headers;
+}
+
 void FeedStorageDummyImpl::addEntry(const QString &guid)
 {
     if (!d->entries.contains(guid)) {
@@ -180,6 +253,75 @@ void FeedStorageDummyImpl::deleteArticle(const QString &guid)
     d->entries.remove(guid);
 }
 
+bool FeedStorageDummyImpl::readArticle(const QString &guid, ArticleRecord &record) const
+{
+    const auto it = d->entries.constFind(guid);
+    if (it == d->entries.constEnd()) {
+        return false;
+    }
+
+    const FeedStorageDummyImplPrivate::Entry &entry = it.value();
+    record.title = entry.title;
+    record.description = entry.description;
+    record.content = entry.content;
+    record.link = entry.link;
+    record.commentsLink = entry.commentsLink;
+    record.authorName = entry.authorName;
+    record.authorUri = entry.authorUri;
+    record.authorEMail = entry.authorEMail;
+    record.enclosureUrl = entry.enclosureUrl;
+    record.enclosureType = entry.enclosureType;
+    record.hash = entry.hash;
+    record.pubDate = entry.pubDate;
+    record.status = entry.status;
+    record.comments = entry.comments;
+    record.enclosureLength = entry.enclosureLength;
+    record.guidIsHash = entry.guidIsHash;
+    record.guidIsPermaLink = entry.guidIsPermaLink;
+    record.hasEnclosure = entry.hasEnclosure;
+    return true;
+}
+
+void FeedStorageDummyImpl::writeArticle(const QString &guid, const ArticleRecord &record)
+{
+    auto it = d->entries.find(guid);
+    if (it == d->entries.end()) {
+        it = d->entries.insert(guid, FeedStorageDummyImplPrivate::Entry());
+        setTotalCount(totalCount() + 1);
+    }
+
+    FeedStorageDummyImplPrivate::Entry &entry = it.value();
+    entry.title = record.title;
+    entry.description = record.description;
+    entry.content = record.content;
+    entry.link = record.link;
+    entry.commentsLink = record.commentsLink;
+    entry.authorName = record.authorName;
+    entry.authorUri = record.authorUri;
+    entry.authorEMail = record.authorEMail;
+    entry.enclosureUrl = record.enclosureUrl;
+    entry.enclosureType = record.enclosureType;
+    entry.hash = record.hash;
+    entry.pubDate = record.pubDate;
+    entry.status = record.status;
+    entry.comments = record.comments;
+    entry.enclosureLength = record.enclosureLength;
+    entry.guidIsHash = record.guidIsHash;
+    entry.guidIsPermaLink = record.guidIsPermaLink;
+    entry.hasEnclosure = record.hasEnclosure;
+}
+
+void FeedStorageDummyImpl::applyChanges(const QHash<QString, ArticleRecord> &records, const QStringList &deleted, int unread)
+{
+    for (auto it = records.constBegin(), end = records.constEnd(); it != end; ++it) {
+        writeArticle(it.key(), it.value());
+    }
+    for (const QString &guid : deleted) {
+        deleteArticle(guid);
+    }
+    setUnread(unread);
+}
+
 int FeedStorageDummyImpl::comments(const QString &guid) const
 {
     return contains(guid) ? d->entries[guid].comments : 0;
@@ -454,21 +596,12 @@ void FeedStorageDummyImpl::add(FeedStorage *source)
 
 void FeedStorageDummyImpl::copyArticle(const QString &guid, FeedStorage *source)
 {
-    if (!contains(guid)) {
-        addEntry(guid);
-    }
-
-    setComments(guid, source->comments(guid));
-    setCommentsLink(guid, source->commentsLink(guid));
-    setDescription(guid, source->description(guid));
-    setContent(guid, source->content(guid));
-    setGuidIsHash(guid, source->guidIsHash(guid));
-    setGuidIsPermaLink(guid, source->guidIsPermaLink(guid));
-    setHash(guid, source->hash(guid));
-    setLink(guid, source->link(guid));
-    setPubDate(guid, source->pubDate(guid));
-    setStatus(guid, source->status(guid));
-    setTitle(guid, source->title(guid));
+    ArticleRecord record;
+    if (!source->readArticle(guid, record)) {
+        return;
+    }
+    writeArticle(guid, record);
+
     QStringList tags = source->tags(guid);
 
     for (QStringList::ConstIterator it = tags.constBegin(); it != tags.constEnd(); ++it) {
@@ -520,5 +653,95 @@ void FeedStorageDummyImpl::enclosure(const QString &guid, bool &hasEnclosure, QS
         length = -1;
     }
 }
+
+int FeedStorageDummyImpl::status(const GuidKey &key) const
+{
+    return status(key.toString());
+}
+
+QString FeedStorageDummyImpl::title(const GuidKey &key) const
+{
+    return title(key.toString());
+}
+
+QString FeedStorageDummyImpl::description(const GuidKey &key) const
+{
+    return description(key.toString());
+}
+
+QString FeedStorageDummyImpl::content(const GuidKey &key) const
+{
+    return content(key.toString());
+}
+
+QString FeedStorageDummyImpl::link(const GuidKey &key) const
+{
+    return link(key.toString());
+}
+
+QString FeedStorageDummyImpl::commentsLink(const GuidKey &key) const
+{
+    return commentsLink(key.toString());
+}
+
+int FeedStorageDummyImpl::comments(const GuidKey &key) const
+{
+    return comments(key.toString());
+}
+
+bool FeedStorageDummyImpl::guidIsHash(const GuidKey &key) const
+{
+    return guidIsHash(key.toString());
+}
+
+bool FeedStorageDummyImpl::guidIsPermaLink(const GuidKey &key) const
+{
+    return guidIsPermaLink(key.toString());
+}
+
+QString FeedStorageDummyImpl::authorName(const GuidKey &key) const
+{
+    return authorName(key.toString());
+}
+
+QString FeedStorageDummyImpl::authorUri(const GuidKey &key) const
+{
+    return authorUri(key.toString());
+}
+
+QString FeedStorageDummyImpl::authorEMail(const GuidKey &key) const
+{
+    return authorEMail(key.toString());
+}
+
+void FeedStorageDummyImpl::setStatus(const GuidKey &key, int status)
+{
+    setStatus(key.toString(), status);
+}
+
+void FeedStorageDummyImpl::enclosure(const GuidKey &key, bool &hasEnclosure, QString &url, QString &type, int &length) const
+{
+    enclosure(key.toString(), hasEnclosure, url, type, length);
+}
+
+bool FeedStorageDummyImpl::contains(const GuidKey &key) const
+{
+    return contains(key.toString());
+}
+
+uint FeedStorageDummyImpl::hash(const GuidKey &key) const
+{
+    return hash(key.toString());
+}
+
+bool FeedStorageDummyImpl::readArticle(const GuidKey &key, ArticleRecord &record) const
+{
+    return readArticle(key.toString(), record);
+}
+
+void FeedStorageDummyImpl::writeArticle(const GuidKey &key, const ArticleRecord &record)
+{
+    writeArticle(key.toString(), record);
+}
 } // namespace Backend
 } // namespace Akregator
@@ -44,14 +44,23 @@ public:
     int totalCount() const override;
     int lastFetch() const override;
     void setLastFetch(int lastFetch) override;
+    void httpValidators(QString &etag, QString &lastModified) const override;
+    void setHttpValidators(const QString &etag, const QString &lastModified) override;
+    QByteArray contentDigest() const override;
+    void setContentDigest(const QByteArray &digest) override;
 
     QStringList articles(const QString &tag = QString()) const override;
 
     QStringList articles(const Category &cat) const override;
+    ArticleHeaders articleHeaders() const override;
+    ArticleHeaders articleHeadersByDate(uint from, uint to, int limit = -1) const override;
 
     bool contains(const QString &guid) const override;
     void addEntry(const QString &guid) override;
     void deleteArticle(const QString &guid) override;
+    bool readArticle(const QString &guid, ArticleRecord &record) const override;
+    void writeArticle(const QString &guid, const ArticleRecord &record) override;
+    void applyChanges(const QHash<QString, ArticleRecord> &records, const QStringList &deleted, int unread) override;
     int comments(const QString &guid) const override;
     QString commentsLink(const QString &guid) const override;
     void setCommentsLink(const QString &guid, const QString &commentsLink) override;
@@ -83,6 +92,25 @@ public:
     void removeEnclosure(const QString &guid) override;
     void enclosure(const QString &guid, bool &hasEnclosure, QString &url, QString &type, int &length) const override;
 
+    bool contains(const GuidKey &key) const override;
+    uint hash(const GuidKey &key) const override;
+    bool readArticle(const GuidKey &key, ArticleRecord &record) const override;
+    void writeArticle(const GuidKey &key, const ArticleRecord &record) override;
+    int status(const GuidKey &key) const override;
+    void setStatus(const GuidKey &key, int status) override;
+    QString title(const GuidKey &key) const override;
+    QString description(const GuidKey &key) const override;
+    QString content(const GuidKey &key) const override;
+    QString link(const GuidKey &key) const override;
+    QString commentsLink(const GuidKey &key) const override;
+    int comments(const GuidKey &key) const override;
+    bool guidIsHash(const GuidKey &key) const override;
+    bool guidIsPermaLink(const GuidKey &key) const override;
+    QString authorName(const GuidKey &key) const override;
+    QString authorUri(const GuidKey &key) const override;
+    QString authorEMail(const GuidKey &key) const override;
+    void enclosure(const GuidKey &key, bool &hasEnclosure, QString &url, QString &type, int &length) const override;
+
     void addCategory(const QString &guid, const Category &category) override;
     QList<Category> categories(const QString &guid = QString()) const override;
 
@@ -97,6 +125,8 @@ public:
     void close() override;
     void commit() override;
     void rollback() override;
+    void pin() override;
+    void unpin() override;
 
     void convertOldArchive() override;
 private:
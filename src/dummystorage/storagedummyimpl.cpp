@@ -39,6 +39,9 @@ public:
         int unread;
         int totalCount;
         int lastFetch;
+        QString etag;
+        QString lastModified;
+        QByteArray contentDigest;
         FeedStorage *feedStorage;
     };
 
@@ -142,6 +145,85 @@ void StorageDummyImpl::setLastFetchFor(const QString &url, int lastFetch)
     }
 }
 
+int StorageDummyImpl::unreadFor(const FeedKey &key) const
+{
+    return unreadFor(key.toString());
+}
+
+void StorageDummyImpl::setUnreadFor(const FeedKey &key, int unread)
+{
+    setUnreadFor(key.toString(), unread);
+}
+
+int StorageDummyImpl::totalCountFor(const FeedKey &key) const
+{
+    return totalCountFor(key.toString());
+}
+
+void StorageDummyImpl::setTotalCountFor(const FeedKey &key, int total)
+{
+    setTotalCountFor(key.toString(), total);
+}
+
+int StorageDummyImpl::lastFetchFor(const FeedKey &key) const
+{
+    return lastFetchFor(key.toString());
+}
+
+void StorageDummyImpl::setLastFetchFor(const FeedKey &key, int lastFetch)
+{
+    setLastFetchFor(key.toString(), lastFetch);
+}
+
+void StorageDummyImpl::httpValidatorsFor(const QString &url, QString &etag, QString &lastModified) const
+{
+    const StorageDummyImplPrivate::Entry entry = d->feeds.value(url);
+    etag = entry.etag;
+    lastModified = entry.lastModified;
+}
+
+void StorageDummyImpl::setHttpValidatorsFor(const QString &url, const QString &etag, const QString &lastModified)
+{
+    if (!d->feeds.contains(url)) {
+        d->addEntry(url, 0, 0, 0);
+    }
+    d->feeds[url].etag = etag;
+    d->feeds[url].lastModified = lastModified;
+}
+
+QByteArray StorageDummyImpl::contentDigestFor(const QString &url) const
+{
+    return d->feeds.value(url).contentDigest;
+}
+
+void StorageDummyImpl::setContentDigestFor(const QString &url, const QByteArray &digest)
+{
+    if (!d->feeds.contains(url)) {
+        d->addEntry(url, 0, 0, 0);
+    }
+    d->feeds[url].contentDigest = digest;
+}
+
+void StorageDummyImpl::httpValidatorsFor(const FeedKey &key, QString &etag, QString &lastModified) const
+{
+    httpValidatorsFor(key.toString(), etag, lastModified);
+}
+
+void StorageDummyImpl::setHttpValidatorsFor(const FeedKey &key, const QString &etag, const QString &lastModified)
+{
+    setHttpValidatorsFor(key.toString(), etag, lastModified);
+}
+
+QByteArray StorageDummyImpl::contentDigestFor(const FeedKey &key) const
+{
+    return contentDigestFor(key.toString());
+}
+
+void StorageDummyImpl::setContentDigestFor(const FeedKey &key, const QByteArray &digest)
+{
+    setContentDigestFor(key.toString(), digest);
+}
+
 void StorageDummyImpl::slotCommit()
 {
 }
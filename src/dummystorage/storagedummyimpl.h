@@ -79,6 +79,20 @@ public:
     void setTotalCountFor(const QString &url, int total) override;
     int lastFetchFor(const QString &url) const override;
     void setLastFetchFor(const QString &url, int lastFetch) override;
+    int unreadFor(const FeedKey &key) const override;
+    void setUnreadFor(const FeedKey &key, int unread) override;
+    int totalCountFor(const FeedKey &key) const override;
+    void setTotalCountFor(const FeedKey &key, int total) override;
+    int lastFetchFor(const FeedKey &key) const override;
+    void setLastFetchFor(const FeedKey &key, int lastFetch) override;
+    void httpValidatorsFor(const QString &url, QString &etag, QString &lastModified) const override;
+    void setHttpValidatorsFor(const QString &url, const QString &etag, const QString &lastModified) override;
+    QByteArray contentDigestFor(const QString &url) const override;
+    void setContentDigestFor(const QString &url, const QByteArray &digest) override;
+    void httpValidatorsFor(const FeedKey &key, QString &etag, QString &lastModified) const override;
+    void setHttpValidatorsFor(const FeedKey &key, const QString &etag, const QString &lastModified) override;
+    QByteArray contentDigestFor(const FeedKey &key) const override;
+    void setContentDigestFor(const FeedKey &key, const QByteArray &digest) override;
     QStringList feeds() const override;
 
     void storeFeedList(const QString &opmlStr) override;
@@ -28,10 +28,14 @@
 #include "akregatorconfig.h"
 #include "article.h"
 #include "articlejobs.h"
+#include "feedparser.h"
+#include "feedretriever.h"
 #include "feedstorage.h"
 #include "fetchqueue.h"
 #include "folder.h"
+#include "kernel.h"
 #include "notificationmanager.h"
+#include "searchindex.h"
 #include "storage.h"
 #include "treenodevisitor.h"
 #include "types.h"
@@ -50,16 +54,19 @@
 #include <QDateTime>
 #include <QDomDocument>
 #include <QDomElement>
+#include <QElapsedTimer>
+#include <QXmlStreamAttributes>
 #include <QHash>
 #include <QList>
 #include <QPixmap>
 #include <QTimer>
 
+#include <algorithm>
+#include <limits>
 #include <memory>
 #include <QStandardPaths>
 #include <KIO/FavIconRequestJob>
 
-using Syndication::ItemPtr;
 using namespace Akregator;
 
 template<typename Key, typename Value, template<typename, typename> class Container>
@@ -93,7 +100,12 @@ public:
     Syndication::ErrorCode fetchErrorCode;
     int fetchTries;
     bool followDiscovery = false;
-    Syndication::Loader *loader = nullptr;
+    /** the running download, if any */
+    FeedRetriever *retriever = nullptr;
+    /** the FeedParser job of the downloaded document, or 0 */
+    quint64 parseTicket = 0;
+    QElapsedTimer fetchTimer;
+    qint64 downloadTime = 0;
     bool articlesLoaded = false;
     Backend::FeedStorage *archive = nullptr;
 
@@ -101,9 +113,25 @@ public:
     QString htmlUrl;
     QString description;
 
+    /** HTTP validators and document digest received with the running fetch, stored once the document was parsed */
+    QString fetchedEtag;
+    QString fetchedLastModified;
+    QByteArray fetchedDigest;
+    int unchangedFetchCount = 0;
+    /** whether the archive was pinned via setArchivePinned() */
+    bool archivePinned = false;
+
+    /** header columns of the archived articles, serving counts and limits until the articles are loaded */
+    mutable Backend::ArticleHeaders headers;
+    mutable bool headersLoaded = false;
+    const Backend::ArticleHeaders &loadHeaders() const;
+
     /** list of feed articles */
     QHash<QString, Article> articles;
 
+    /** guids of loaded articles still to be added to the search index, see slotIndexArticles() */
+    QStringList unindexedGuids;
+
     /** list of deleted articles. This contains **/
     QVector<Article> deletedArticles;
 
@@ -123,6 +151,15 @@ public:
     }
 };
 
+const Backend::ArticleHeaders &Akregator::Feed::Private::loadHeaders() const
+{
+    if (!headersLoaded && archive) {
+        headers = archive->articleHeaders();
+        headersLoaded = true;
+    }
+    return headers;
+}
+
 QString Akregator::Feed::archiveModeToString(ArchiveMode mode)
 {
     switch (mode) {
@@ -142,29 +179,45 @@ QString Akregator::Feed::archiveModeToString(ArchiveMode mode)
 
 Akregator::Feed *Akregator::Feed::fromOPML(QDomElement e, Backend::Storage *storage)
 {
-    if (!e.hasAttribute(QStringLiteral("xmlUrl")) && !e.hasAttribute(QStringLiteral("xmlurl")) && !e.hasAttribute(QStringLiteral("xmlURL"))) {
+    QXmlStreamAttributes attributes;
+    const QDomNamedNodeMap map = e.attributes();
+    const int count = map.count();
+    for (int i = 0; i < count; ++i) {
+        const QDomAttr attr = map.item(i).toAttr();
+        attributes.append(attr.name(), attr.value());
+    }
+    return fromOPML(attributes, storage);
+}
+
+Akregator::Feed *Akregator::Feed::fromOPML(const QXmlStreamAttributes &attributes, Backend::Storage *storage)
+{
+    if (!attributes.hasAttribute(QStringLiteral("xmlUrl")) && !attributes.hasAttribute(QStringLiteral("xmlurl")) && !attributes.hasAttribute(QStringLiteral("xmlURL"))) {
         return nullptr;
     }
 
-    QString title = e.hasAttribute(QStringLiteral("text")) ? e.attribute(QStringLiteral("text")) : e.attribute(QStringLiteral("title"));
+    const auto attribute = [&attributes](const QString &name) -> QString {
+        return attributes.value(name).toString();
+    };
 
-    QString xmlUrl = e.hasAttribute(QStringLiteral("xmlUrl")) ? e.attribute(QStringLiteral("xmlUrl")) : e.attribute(QStringLiteral("xmlurl"));
+    QString title = attributes.hasAttribute(QStringLiteral("text")) ? attribute(QStringLiteral("text")) : attribute(QStringLiteral("title"));
+
+    QString xmlUrl = attributes.hasAttribute(QStringLiteral("xmlUrl")) ? attribute(QStringLiteral("xmlUrl")) : attribute(QStringLiteral("xmlurl"));
     if (xmlUrl.isEmpty()) {
-        xmlUrl = e.attribute(QStringLiteral("xmlURL"));
+        xmlUrl = attribute(QStringLiteral("xmlURL"));
     }
 
-    bool useCustomFetchInterval = e.attribute(QStringLiteral("useCustomFetchInterval")) == QLatin1String("true");
+    bool useCustomFetchInterval = attribute(QStringLiteral("useCustomFetchInterval")) == QLatin1String("true");
 
-    QString htmlUrl = e.attribute(QStringLiteral("htmlUrl"));
-    QString description = e.attribute(QStringLiteral("description"));
-    int fetchInterval = e.attribute(QStringLiteral("fetchInterval")).toInt();
-    ArchiveMode archiveMode = stringToArchiveMode(e.attribute(QStringLiteral("archiveMode")));
-    int maxArticleAge = e.attribute(QStringLiteral("maxArticleAge")).toUInt();
-    int maxArticleNumber = e.attribute(QStringLiteral("maxArticleNumber")).toUInt();
-    bool markImmediatelyAsRead = e.attribute(QStringLiteral("markImmediatelyAsRead")) == QLatin1String("true");
-    bool useNotification = e.attribute(QStringLiteral("useNotification")) == QLatin1String("true");
-    bool loadLinkedWebsite = e.attribute(QStringLiteral("loadLinkedWebsite")) == QLatin1String("true");
-    uint id = e.attribute(QStringLiteral("id")).toUInt();
+    QString htmlUrl = attribute(QStringLiteral("htmlUrl"));
+    QString description = attribute(QStringLiteral("description"));
+    int fetchInterval = attribute(QStringLiteral("fetchInterval")).toInt();
+    ArchiveMode archiveMode = stringToArchiveMode(attribute(QStringLiteral("archiveMode")));
+    int maxArticleAge = attribute(QStringLiteral("maxArticleAge")).toUInt();
+    int maxArticleNumber = attribute(QStringLiteral("maxArticleNumber")).toUInt();
+    bool markImmediatelyAsRead = attribute(QStringLiteral("markImmediatelyAsRead")) == QLatin1String("true");
+    bool useNotification = attribute(QStringLiteral("useNotification")) == QLatin1String("true");
+    bool loadLinkedWebsite = attribute(QStringLiteral("loadLinkedWebsite")) == QLatin1String("true");
+    uint id = attribute(QStringLiteral("id")).toUInt();
 
     Feed *const feed = new Feed(storage);
     feed->setTitle(title);
@@ -180,7 +233,10 @@ Akregator::Feed *Akregator::Feed::fromOPML(QDomElement e, Backend::Storage *stor
     feed->setMaxArticleNumber(maxArticleNumber);
     feed->setMarkImmediatelyAsRead(markImmediatelyAsRead);
     feed->setLoadLinkedWebsite(loadLinkedWebsite);
-    feed->loadArticles(); // TODO: make me fly: make this delayed
+    // the counters are in the storage index, the article headers are loaded later by loadArticleHeaders()
+    if (storage) {
+        feed->d->archive = storage->archiveFor(xmlUrl);
+    }
 
     return feed;
 }
@@ -220,6 +276,9 @@ QVector<Akregator::Feed *> Akregator::Feed::feeds()
 
 Article Akregator::Feed::findArticle(const QString &guid) const
 {
+    if (!d->articlesLoaded) {
+        const_cast<Feed *>(this)->loadArticles();
+    }
     return d->articles.value(guid);
 }
 
@@ -231,6 +290,31 @@ QVector<Article> Akregator::Feed::articles()
     return valuesToVector(d->articles);
 }
 
+QVector<Article> Akregator::Feed::articlesByDate()
+{
+    if (!d->articlesLoaded) {
+        loadArticles();
+    }
+
+    QVector<Article> articles;
+    if (d->archive) {
+        const Backend::ArticleHeaders headers = d->archive->articleHeadersByDate(0, std::numeric_limits<uint>::max());
+        articles.reserve(headers.guids.count());
+        for (const QString &guid : headers.guids) {
+            const auto it = d->articles.constFind(guid);
+            if (it != d->articles.constEnd()) {
+                articles.append(it.value());
+            }
+        }
+    }
+    if (articles.count() != d->articles.count()) {
+        // the archive does not know every article, e.g. one dated at the very end of time
+        articles = valuesToVector(d->articles);
+        std::sort(articles.begin(), articles.end());
+    }
+    return articles;
+}
+
 Backend::Storage *Akregator::Feed::storage()
 {
     return d->storage;
@@ -246,33 +330,93 @@ void Akregator::Feed::loadArticles()
         d->archive = d->storage->archiveFor(xmlUrl());
     }
 
-    QStringList list = d->archive->articles();
-    for (QStringList::ConstIterator it = list.constBegin(); it != list.constEnd(); ++it) {
-        Article mya(*it, this);
-        d->articles[mya.guid()] = mya;
+    const Backend::ArticleHeaders &headers = d->loadHeaders();
+    const int count = headers.guids.count();
+    d->articles.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const Article mya(headers.guids.at(i), this, d->archive, headers.status.at(i), headers.hash.at(i), headers.pubDate.at(i));
+        d->articles.insert(mya.guid(), mya);
         if (mya.isDeleted()) {
             d->deletedArticles.append(mya);
         }
     }
 
+    // from now on the article objects are authoritative
+    d->headers = Backend::ArticleHeaders();
+    d->headersLoaded = false;
+
+    SearchIndex *index = Kernel::self()->searchIndex();
+    if (index && !index->isFeedIndexed(xmlUrl())) {
+        // articles archived before the feed was indexed, afterwards appendArticles() keeps the index up to date
+        d->unindexedGuids = d->articles.keys();
+        QTimer::singleShot(0, this, &Feed::slotIndexArticles);
+    }
+
     d->articlesLoaded = true;
     enforceLimitArticleNumber();
     recalcUnreadCount();
 }
 
-void Akregator::Feed::recalcUnreadCount()
+void Akregator::Feed::slotIndexArticles()
 {
-    QVector<Article> tarticles = articles();
-    QVector<Article>::ConstIterator it;
-    QVector<Article>::ConstIterator en = tarticles.constEnd();
+    SearchIndex *index = Kernel::self()->searchIndex();
+    if (!index || !d->archive) {
+        d->unindexedGuids.clear();
+        return;
+    }
+
+    // reading the bodies takes a while for big archives, index in slices to keep the GUI responsive
+    QElapsedTimer timer;
+    timer.start();
+    Backend::ArticleRecord record;
+    while (!d->unindexedGuids.isEmpty() && timer.elapsed() < 20) {
+        const QString guid = d->unindexedGuids.takeLast();
+        const Article article = d->articles.value(guid);
+        // articles added meanwhile were indexed by appendArticles()
+        if (!article.isNull() && !article.isDeleted() && d->archive->readArticle(guid, record)) {
+            index->addArticle(xmlUrl(), guid, record.title, record.description, record.authorName);
+        }
+    }
+
+    if (d->unindexedGuids.isEmpty()) {
+        index->setFeedIndexed(xmlUrl());
+    } else {
+        QTimer::singleShot(0, this, &Feed::slotIndexArticles);
+    }
+}
 
+void Akregator::Feed::loadArticleHeaders()
+{
+    if (!d->archive && d->storage) {
+        d->archive = d->storage->archiveFor(xmlUrl());
+    }
+    if (d->articlesLoaded || !d->archive) {
+        // loadArticles() did the same already
+        return;
+    }
+
+    enforceLimitArticleNumber();
+    recalcUnreadCount();
+}
+
+void Akregator::Feed::recalcUnreadCount()
+{
     int oldUnread = d->archive->unread();
 
     int unread = 0;
 
-    for (it = tarticles.constBegin(); it != en; ++it) {
-        if (!(*it).isDeleted() && (*it).status() != Read) {
-            ++unread;
+    if (d->articlesLoaded) {
+        for (const Article &article : qAsConst(d->articles)) {
+            if (!article.isDeleted() && article.status() != Read) {
+                ++unread;
+            }
+        }
+    } else {
+        const Backend::ArticleHeaders &headers = d->loadHeaders();
+        for (int status : headers.status) {
+            if (!Article::isDeletedStatus(status) && !Article::isReadStatus(status)) {
+                ++unread;
+            }
         }
     }
 
@@ -314,7 +458,6 @@ Akregator::Feed::Private::Private(Backend::Storage *storage_, Akregator::Feed *q
     , fetchErrorCode(Syndication::Success)
     , fetchTries(0)
     , followDiscovery(false)
-    , loader(nullptr)
     , articlesLoaded(false)
     , archive(nullptr)
     , totalCount(-1)
@@ -331,6 +474,7 @@ Akregator::Feed::Feed(Backend::Storage *storage) : TreeNode()
 Akregator::Feed::~Feed()
 {
     slotAbortFetch();
+    setArchivePinned(false);
     emitSignalDestroyed();
     delete d;
     d = nullptr;
@@ -393,7 +537,7 @@ bool Akregator::Feed::markImmediatelyAsRead() const
 
 bool Akregator::Feed::isFetching() const
 {
-    return d->loader != nullptr;
+    return d->retriever || d->parseTicket != 0;
 }
 
 void Akregator::Feed::setMarkImmediatelyAsRead(bool enabled)
@@ -477,6 +621,24 @@ bool Akregator::Feed::isArticlesLoaded() const
     return d->articlesLoaded;
 }
 
+int Akregator::Feed::unchangedFetchCount() const
+{
+    return d->unchangedFetchCount;
+}
+
+void Akregator::Feed::setArchivePinned(bool pinned)
+{
+    if (!d->archive || pinned == d->archivePinned) {
+        return;
+    }
+    d->archivePinned = pinned;
+    if (pinned) {
+        d->archive->pin();
+    } else {
+        d->archive->unpin();
+    }
+}
+
 QDomElement Akregator::Feed::toOPML(QDomElement parent, QDomDocument document) const
 {
     QDomElement el = document.createElement(QStringLiteral("outline"));
@@ -535,7 +697,7 @@ void Akregator::Feed::slotAddToFetchQueue(FetchQueue *queue, bool intervalFetchO
         uint now = QDateTime::currentDateTimeUtc().toTime_t();
 
         if (interval > 0 && (now - lastFetch) >= static_cast<uint>(interval)) {
-            queue->addFeed(this);
+            queue->addFeed(this, lastFetch + interval);
         }
     }
 }
@@ -545,72 +707,107 @@ void Akregator::Feed::slotAddFeedIconListener()
     loadFavicon(QUrl(d->xmlUrl));
 }
 
-void Akregator::Feed::appendArticles(const Syndication::FeedPtr &feed)
+void Akregator::Feed::appendArticles(const QVector<ParsedItem> &items)
 {
     d->setTotalCountDirty();
     bool changed = false;
     const bool notify = useNotification() || Settings::useNotifications();
 
-    QList<ItemPtr> items = feed->items();
-    QList<ItemPtr>::ConstIterator it = items.constBegin();
-    QList<ItemPtr>::ConstIterator en = items.constEnd();
-
     int nudge = 0;
+    int unreadDelta = 0;
 
+    // collect all changes first and hand them to the archive in one go
+    QHash<QString, Backend::ArticleRecord> records;
     QVector<Article> deletedArticles = d->deletedArticles;
 
-    for (; it != en; ++it) {
-        if (!d->articles.contains((*it)->id())) { // article not in list
-            Article mya(*it, this);
-            mya.offsetPubDate(nudge);
+    for (const ParsedItem &item : items) {
+        const QString &guid = item.guid;
+        const auto oldIt = d->articles.constFind(guid);
+        // resolves the archive row once for the lookups below
+        const Backend::GuidKey key(guid);
+        if (oldIt == d->articles.constEnd()) { // article not in list
+            const bool stored = d->archive->contains(key);
+            if (item.change == ParsedItem::Unchanged && !stored) {
+                // removed from list and archive while the document was parsed, the fields were not passed along
+                continue;
+            }
+            Backend::ArticleRecord record;
+            if (item.change == ParsedItem::Unchanged || !Article::mergeRecord(key, item.record, d->archive, stored, stored ? d->archive->hash(key) : 0, record)) {
+                // stored and unchanged, but not in the list: keep the archived fields
+                d->archive->readArticle(key, record);
+            }
+            record.pubDate += nudge;
             nudge--;
-            appendArticle(mya);
+            Article mya(guid, this, record, markImmediatelyAsRead() ? Read : New);
+            records.insert(guid, record);
+            if (appendArticle(mya) && mya.status() != Read) {
+                ++unreadDelta;
+            }
             d->addedArticlesNotify.append(mya);
 
-            if (!mya.isDeleted() && !markImmediatelyAsRead()) {
-                mya.setStatus(New);
-            } else {
-                mya.setStatus(Read);
-            }
             if (notify) {
                 NotificationManager::self()->slotNotifyArticle(mya);
             }
             changed = true;
         } else { // article is in list
+            const Article old = oldIt.value();
+            if (old.isDeleted()) {
+                deletedArticles.removeAll(old);
+                continue;
+            }
             // if the article's guid is no hash but an ID, we have to check if the article was updated. That's done by comparing the hash values.
-            Article old = d->articles[(*it)->id()];
-            Article mya(*it, this);
-            if (!mya.guidIsHash() && mya.hash() != old.hash() && !old.isDeleted()) {
-                mya.setKeep(old.keep());
-                int oldstatus = old.status();
-                old.setStatus(Read);
-
-                d->articles.remove(old.guid());
-                appendArticle(mya);
-
-                mya.setStatus(oldstatus);
+            Backend::ArticleRecord record;
+            if (item.change == ParsedItem::Unchanged && item.record.hash != old.hash()) {
+                // changed while the document was parsed, the fields were not passed along
+                continue;
+            }
+            if (!Article::mergeRecord(key, item.record, d->archive, true, old.hash(), record)) {
+                continue;
+            }
+            if (!record.guidIsHash && record.hash != old.hash()) {
+                const int oldstatus = old.status();
+                Article mya(guid, this, record, oldstatus);
+                if (oldstatus != Read) {
+                    --unreadDelta;
+                }
+
+                d->articles.remove(guid);
+                if (appendArticle(mya) && oldstatus != Read) {
+                    ++unreadDelta;
+                }
 
                 d->updatedArticlesNotify.append(mya);
                 changed = true;
-            } else if (old.isDeleted()) {
-                deletedArticles.removeAll(mya);
             }
+            records.insert(guid, record);
         }
     }
 
-    QVector<Article>::ConstIterator dit = deletedArticles.constBegin();
-    QVector<Article>::ConstIterator dtmp;
-    QVector<Article>::ConstIterator den = deletedArticles.constEnd();
-
     // delete articles with delete flag set completely from archive, which aren't in the current feed source anymore
-    while (dit != den) {
-        dtmp = dit;
-        ++dit;
-        d->articles.remove((*dtmp).guid());
-        d->archive->deleteArticle((*dtmp).guid());
-        d->removedArticlesNotify.append(*dtmp);
+    QStringList deletedGuids;
+    deletedGuids.reserve(deletedArticles.count());
+    for (const Article &article : qAsConst(deletedArticles)) {
+        d->articles.remove(article.guid());
+        deletedGuids.append(article.guid());
+        d->removedArticlesNotify.append(article);
         changed = true;
-        d->deletedArticles.removeAll(*dtmp);
+        d->deletedArticles.removeAll(article);
+    }
+
+    if (!records.isEmpty() || !deletedGuids.isEmpty() || unreadDelta != 0) {
+        d->archive->applyChanges(records, deletedGuids, unread() + unreadDelta);
+        if (unreadDelta != 0) {
+            nodeModified();
+        }
+
+        if (SearchIndex *index = Kernel::self()->searchIndex()) {
+            for (auto it = records.constBegin(), end = records.constEnd(); it != end; ++it) {
+                index->addArticle(xmlUrl(), it.key(), it.value().title, it.value().description, it.value().authorName);
+            }
+            for (const QString &guid : qAsConst(deletedGuids)) {
+                index->removeArticle(xmlUrl(), guid);
+            }
+        }
     }
 
     if (changed) {
@@ -625,7 +822,17 @@ bool Akregator::Feed::usesExpiryByAge() const
 
 bool Akregator::Feed::isExpired(const Article &a) const
 {
-    QDateTime now = QDateTime::currentDateTime();
+    return isExpired(a.pubDate());
+}
+
+bool Akregator::Feed::isExpired(const QDateTime &pubDate) const
+{
+    const int age = expiryAge();
+    return age != -1 && pubDate.secsTo(QDateTime::currentDateTime()) > age;
+}
+
+int Akregator::Feed::expiryAge() const
+{
     int expiryAge = -1;
 // check whether the feed uses the global default and the default is limitArticleAge
     if (d->archiveMode == globalDefault && Settings::archiveMode() == Settings::EnumArchiveMode::limitArticleAge) {
@@ -634,20 +841,18 @@ bool Akregator::Feed::isExpired(const Article &a) const
     if (d->archiveMode == limitArticleAge) {
         expiryAge = d->maxArticleAge * 24 * 3600;
     }
-
-    return expiryAge != -1 && a.pubDate().secsTo(now) > expiryAge;
+    return expiryAge;
 }
 
-void Akregator::Feed::appendArticle(const Article &a)
+bool Akregator::Feed::appendArticle(const Article &a)
 {
     if ((a.keep() && Settings::doNotExpireImportantArticles()) || (!usesExpiryByAge() || !isExpired(a))) {   // if not expired
         if (!d->articles.contains(a.guid())) {
             d->articles[a.guid()] = a;
-            if (!a.isDeleted() && a.status() != Read) {
-                setUnread(unread() + 1);
-            }
+            return !a.isDeleted();
         }
     }
+    return false;
 }
 
 void Akregator::Feed::fetch(bool followDiscovery)
@@ -655,10 +860,26 @@ void Akregator::Feed::fetch(bool followDiscovery)
     d->followDiscovery = followDiscovery;
     d->fetchTries = 0;
 
+    if (!d->archive && d->storage) {
+        d->archive = d->storage->archiveFor(xmlUrl());
+    }
+
     // mark all new as unread
-    for (auto it = d->articles.begin(), end = d->articles.end(); it != end; ++it) {
-        if ((*it).status() == New) {
-            (*it).setStatus(Unread);
+    if (d->articlesLoaded) {
+        for (auto it = d->articles.begin(), end = d->articles.end(); it != end; ++it) {
+            if ((*it).status() == New) {
+                (*it).setStatus(Unread);
+            }
+        }
+    } else if (d->archive) {
+        // the articles are loaded only once the fetched document needs to be ingested, so a "not modified" reply costs a header scan at most
+        d->loadHeaders();
+        Backend::ArticleHeaders &headers = d->headers;
+        for (int i = 0; i < headers.guids.count(); ++i) {
+            if (Article::isNewStatus(headers.status.at(i))) {
+                headers.status[i] = Article::unreadStatus(headers.status.at(i));
+                d->archive->setStatus(headers.guids.at(i), headers.status.at(i));
+            }
         }
     }
 
@@ -669,19 +890,53 @@ void Akregator::Feed::fetch(bool followDiscovery)
 
 void Akregator::Feed::slotAbortFetch()
 {
-    if (d->loader) {
-        d->loader->abort();
+    if (!isFetching()) {
+        return;
+    }
+    if (d->retriever) {
+        d->retriever->disconnect(this);
+        d->retriever->abort();
+        d->retriever->deleteLater();
+        d->retriever = nullptr;
     }
+    if (d->parseTicket != 0) {
+        Kernel::self()->feedParser()->cancel(d->parseTicket);
+        d->parseTicket = 0;
+    }
+    fetchFailed(Syndication::Aborted);
 }
 
 void Akregator::Feed::tryFetch()
 {
     d->fetchErrorCode = Syndication::Success;
+    d->fetchedEtag.clear();
+    d->fetchedLastModified.clear();
+    d->fetchedDigest.clear();
+
+    // the stored validators belong to the subscribed URL, not to a discovered one
+    QString etag;
+    QString lastModified;
+    QByteArray digest;
+    if (d->archive && d->fetchTries == 0) {
+        d->archive->httpValidators(etag, lastModified);
+        digest = d->archive->contentDigest();
+    }
+
+    d->retriever = new FeedRetriever(etag, lastModified, digest);
+    connect(d->retriever, &FeedRetriever::validatorsReceived, this, [this](const QString &etag, const QString &lastModified, const QByteArray &digest) {
+        d->fetchedEtag = etag;
+        d->fetchedLastModified = lastModified;
+        d->fetchedDigest = digest;
+    });
+    connect(d->retriever, &FeedRetriever::dataRetrieved, this, &Feed::slotDataRetrieved);
+
+    // keep the archive open until the fetched articles are stored, see parseCompleted()
+    if (d->archive) {
+        d->archive->pin();
+    }
 
-    d->loader = Syndication::Loader::create(this, SLOT(fetchCompleted(Syndication::Loader *,
-                                                                      Syndication::FeedPtr,
-                                                                      Syndication::ErrorCode)));
-    d->loader->loadFrom(QUrl(d->xmlUrl));
+    d->fetchTimer.start();
+    d->retriever->retrieveData(QUrl(d->xmlUrl));
 }
 
 void Akregator::Feed::slotImageFetched(const QPixmap &image)
@@ -689,48 +944,115 @@ void Akregator::Feed::slotImageFetched(const QPixmap &image)
     setImage(image);
 }
 
-void Akregator::Feed::fetchCompleted(Syndication::Loader *l, Syndication::FeedPtr doc, Syndication::ErrorCode status)
+void Akregator::Feed::slotDataRetrieved(const QByteArray &data, bool success)
 {
-    // Note that loader instances delete themselves
-    d->loader = nullptr;
+    const int retrieverError = d->retriever->errorCode();
+    // the retriever's timeout timer must not fire after the download
+    d->retriever->deleteLater();
+    d->retriever = nullptr;
+    d->downloadTime = d->fetchTimer.restart();
 
-    // fetching wasn't successful:
-    if (status != Syndication::Success) {
-        if (status == Syndication::Aborted) {
+    if (!success) {
+        if (retrieverError == FeedRetriever::NotModified || retrieverError == FeedRetriever::Unchanged) {
+            if (d->archive) {
+                if (retrieverError == FeedRetriever::Unchanged && d->fetchTries == 0) {
+                    // the document is the same, but the server may have sent new validators with it
+                    d->archive->setHttpValidators(d->fetchedEtag, d->fetchedLastModified);
+                }
+                d->archive->unpin();
+            }
+            // nothing changed since the last fetch, so there is nothing to parse or ingest
+            ++d->unchangedFetchCount;
+            qCDebug(AKREGATOR_LOG) << "Feed unchanged, skipped parsing:" << d->xmlUrl << "download:" << d->downloadTime << "ms";
             d->fetchErrorCode = Syndication::Success;
-            Q_EMIT fetchAborted(this);
-        } else if (d->followDiscovery && (status == Syndication::InvalidXml) && (d->fetchTries < 3) && (l->discoveredFeedURL().isValid())) {
-            d->fetchTries++;
-            d->xmlUrl = l->discoveredFeedURL().url();
-            Q_EMIT fetchDiscovery(this);
-            tryFetch();
-        } else {
-            d->fetchErrorCode = status;
-            Q_EMIT fetchError(this);
+            markAsFetchedNow();
+            Q_EMIT fetched(this);
+            return;
         }
-        markAsFetchedNow();
+        qCDebug(AKREGATOR_LOG) << "Retriever error" << retrieverError << "for" << d->xmlUrl;
+        fetchFailed(Syndication::OtherRetrieverError);
+        return;
+    }
+
+    // the parser diffs the items against the article list as it is now
+    loadArticles();
+    QHash<QString, uint> knownHashes;
+    knownHashes.reserve(d->articles.size());
+    for (auto it = d->articles.constBegin(), end = d->articles.constEnd(); it != end; ++it) {
+        knownHashes.insert(it.key(), it.value().hash());
+    }
+
+    QString imageFileName;
+    if (d->imagePixmap.isNull()) {
+        imageFileName = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/akregator/Media/") + Utils::fileNameForUrl(d->xmlUrl) + QLatin1String(".png");
+    }
+
+    // the fetch counts as running until the result is ingested, so the fetch queue doesn't start more downloads than get parsed
+    d->parseTicket = Kernel::self()->feedParser()->parse(this, data, QUrl(d->xmlUrl), knownHashes, imageFileName);
+}
+
+void Akregator::Feed::fetchFailed(Syndication::ErrorCode status, const QUrl &discoveredFeedUrl)
+{
+    if (d->archive) {
+        d->archive->unpin();
+    }
+
+    if (status == Syndication::Aborted) {
+        d->fetchErrorCode = Syndication::Success;
+        Q_EMIT fetchAborted(this);
+    } else if (d->followDiscovery && (status == Syndication::InvalidXml) && (d->fetchTries < 3) && (discoveredFeedUrl.isValid())) {
+        d->fetchTries++;
+        d->xmlUrl = discoveredFeedUrl.url();
+        Q_EMIT fetchDiscovery(this);
+        tryFetch();
+    } else {
+        d->fetchErrorCode = status;
+        Q_EMIT fetchError(this);
+    }
+    markAsFetchedNow();
+}
+
+void Akregator::Feed::parseCompleted(const ParsedFeed &result)
+{
+    d->parseTicket = 0;
+
+    if (result.status != Syndication::Success) {
+        fetchFailed(result.status, result.discoveredFeedUrl);
         return;
     }
 
-    loadArticles(); // TODO: make me fly: make this delayed
+    QElapsedTimer ingestTimer;
+    ingestTimer.start();
+
+    loadArticles();
 
     loadFavicon(QUrl(xmlUrl()));
 
     d->fetchErrorCode = Syndication::Success;
 
-    if (d->imagePixmap.isNull()) {
-        const QString imageFileName = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QLatin1String("/akregator/Media/") + Utils::fileNameForUrl(d->xmlUrl) + QLatin1String(".png");
-        d->imagePixmap = QPixmap(imageFileName, "PNG");
+    if (d->imagePixmap.isNull() && !result.image.isNull()) {
+        d->imagePixmap = QPixmap::fromImage(result.image);
     }
 
     if (title().isEmpty()) {
-        setTitle(Syndication::htmlToPlainText(doc->title()));
+        setTitle(result.title);
     }
 
-    d->description = doc->description();
-    d->htmlUrl = doc->link();
+    d->description = result.description;
+    d->htmlUrl = result.link;
+
+    appendArticles(result.items);
+
+    if (d->archive) {
+        if (d->fetchTries == 0) {
+            d->archive->setHttpValidators(d->fetchedEtag, d->fetchedLastModified);
+            d->archive->setContentDigest(d->fetchedDigest);
+        }
+        d->archive->unpin();
+    }
 
-    appendArticles(doc);
+    qCDebug(AKREGATOR_LOG) << "Fetched" << d->xmlUrl << result.items.count() << "items, download:" << d->downloadTime << "ms, parse:" << result.parseTime
+                           << "ms, diff:" << result.diffTime << "ms, ingest:" << ingestTimer.elapsed() << "ms";
 
     markAsFetchedNow();
     Q_EMIT fetched(this);
@@ -764,10 +1086,28 @@ void Akregator::Feed::deleteExpiredArticles(ArticleDeleteJob *deleteJob)
     const QString feedUrl = xmlUrl();
     const bool useKeep = Settings::doNotExpireImportantArticles();
 
-    for (const Article &i : qAsConst(d->articles)) {
-        if ((!useKeep || !i.keep()) && isExpired(i)) {
-            const ArticleId aid = { feedUrl, i.guid() };
-            toDelete.append(aid);
+    if (!d->archive && d->storage) {
+        d->archive = d->storage->archiveFor(xmlUrl());
+    }
+    const int age = expiryAge();
+    const uint now = QDateTime::currentDateTime().toTime_t();
+    if (d->archive && age != -1 && now > static_cast<uint>(age)) {
+        // only the expired articles are read from the date index
+        const Backend::ArticleHeaders headers = d->archive->articleHeadersByDate(0, now - age);
+        for (int i = 0; i < headers.guids.count(); ++i) {
+            bool keep = Article::isKeepStatus(headers.status.at(i));
+            if (d->articlesLoaded) {
+                // the article objects are authoritative once loaded
+                const auto it = d->articles.constFind(headers.guids.at(i));
+                if (it == d->articles.constEnd()) {
+                    continue;
+                }
+                keep = it.value().keep();
+            }
+            if (!useKeep || !keep) {
+                const ArticleId aid = { feedUrl, headers.guids.at(i) };
+                toDelete.append(aid);
+            }
         }
     }
 
@@ -847,9 +1187,16 @@ void Akregator::Feed::setArticleChanged(Article &a, int oldStatus, bool process)
 int Akregator::Feed::totalCount() const
 {
     if (d->totalCount == -1) {
-        d->totalCount = std::count_if(d->articles.constBegin(), d->articles.constEnd(), [](const Article &art) -> bool {
-            return !art.isDeleted();
-        });
+        if (d->articlesLoaded) {
+            d->totalCount = std::count_if(d->articles.constBegin(), d->articles.constEnd(), [](const Article &art) -> bool {
+                return !art.isDeleted();
+            });
+        } else {
+            const Backend::ArticleHeaders &headers = d->loadHeaders();
+            d->totalCount = std::count_if(headers.status.constBegin(), headers.status.constEnd(), [](int status) -> bool {
+                return !Article::isDeletedStatus(status);
+            });
+        }
     }
     return d->totalCount;
 }
@@ -923,15 +1270,60 @@ void Akregator::Feed::enforceLimitArticleNumber()
         limit = maxArticleNumber();
     }
 
-    if (limit == -1 || limit >= d->articles.count() - d->deletedArticles.count()) {
+    if (limit == -1) {
+        return;
+    }
+
+    const bool useKeep = Settings::doNotExpireImportantArticles();
+
+    if (!d->articlesLoaded) {
+        // work on the header columns, only the articles to delete are created
+        const Backend::ArticleHeaders &headers = d->loadHeaders();
+        const int alive = std::count_if(headers.status.constBegin(), headers.status.constEnd(), [](int status) -> bool {
+            return !Article::isDeletedStatus(status);
+        });
+        if (limit >= alive) {
+            return;
+        }
+
+        // the date index lists the articles newest first, no need to sort them
+        const Backend::ArticleHeaders byDate = d->archive->articleHeadersByDate(0, std::numeric_limits<uint>::max());
+
+        int c = 0;
+        bool deleted = false;
+        for (int row = 0; row < byDate.guids.count(); ++row) {
+            const int status = byDate.status.at(row);
+            const bool keep = useKeep && Article::isKeepStatus(status);
+            if (c < limit) {
+                if (!Article::isDeletedStatus(status) && !keep) {
+                    ++c;
+                }
+            } else if (!keep && !Article::isDeletedStatus(status)) {
+                Article article(byDate.guids.at(row), nullptr, d->archive, status, byDate.hash.at(row), byDate.pubDate.at(row));
+                article.setDeleted();
+                // the article knows no feed to remove it from the search index
+                if (SearchIndex *index = Kernel::self()->searchIndex()) {
+                    index->removeArticle(xmlUrl(), byDate.guids.at(row));
+                }
+                deleted = true;
+            }
+        }
+        if (deleted) {
+            d->headersLoaded = false;
+            d->setTotalCountDirty();
+            // the total count is shown with the node
+            nodeModified();
+        }
+        return;
+    }
+
+    if (limit >= d->articles.count() - d->deletedArticles.count()) {
         return;
     }
 
-    QVector<Article> articles = valuesToVector(d->articles);
-    std::sort(articles.begin(), articles.end());
+    const QVector<Article> articles = articlesByDate();
 
     int c = 0;
-    const bool useKeep = Settings::doNotExpireImportantArticles();
 
     for (Article i : qAsConst(articles)) {
         if (c < limit) {
@@ -33,14 +33,19 @@
 
 #include <QIcon>
 
+class QDateTime;
 class QDomElement;
 class QString;
+class QXmlStreamAttributes;
 
 namespace Akregator {
 class Article;
 class FetchQueue;
 class TreeNodeVisitor;
 class ArticleDeleteJob;
+class FeedParser;
+class ParsedFeed;
+class ParsedItem;
 
 namespace Backend {
 class Storage;
@@ -51,6 +56,7 @@ class AKREGATOR_EXPORT Feed : public TreeNode
 {
     friend class ::Akregator::Article;
     friend class ::Akregator::Folder;
+    friend class ::Akregator::FeedParser;
     Q_OBJECT
 public:
     /** the archiving modes */
@@ -74,6 +80,8 @@ public:
 
     /** creates a Feed object from a description in OPML format */
     static Feed *fromOPML(QDomElement e, Akregator::Backend::Storage *storage);
+    /** creates a Feed object from the attributes of an OPML outline element. The article headers are not loaded yet, see loadArticleHeaders() */
+    static Feed *fromOPML(const QXmlStreamAttributes &attributes, Akregator::Backend::Storage *storage);
 
     /** default constructor */
     explicit Feed(Akregator::Backend::Storage *storage);
@@ -168,6 +176,9 @@ public:
         */
     Article findArticle(const QString &guid) const;
 
+    /** returns the articles of this feed, newest first, ordered by the date index of the archive instead of sorting them */
+    QVector<Article> articlesByDate();
+
     /** returns whether a fetch error has occurred */
     bool fetchErrorOccurred() const;
 
@@ -184,6 +195,16 @@ public:
     /** returns if the article archive of this feed is loaded */
     bool isArticlesLoaded() const;
 
+    /** returns how many fetches since startup were skipped because the server replied "not modified" or sent an identical document */
+    int unchangedFetchCount() const;
+
+    /** keeps the archive of this feed open while it is displayed, so it is not closed to save resources */
+    void setArchivePinned(bool pinned);
+
+    /** opens the archive and updates the unread count and article limit from the article headers, without loading the articles.
+        Does nothing once the articles are loaded. **/
+    void loadArticleHeaders();
+
     /** returns if this node is a feed group (@c false here) */
     bool isGroup() const override
     {
@@ -273,13 +294,19 @@ private:
         */
     void setArticleChanged(Article &a, int oldStatus = -1, bool process = true);
 
-    void appendArticles(const Syndication::FeedPtr &feed);
+    /** merges the items of a parsed document into the article list and archive */
+    void appendArticles(const QVector<ParsedItem> &items);
 
-    /** appends article @c a to the article list */
-    void appendArticle(const Article &a);
+    /** appends article @c a to the article list, unless it is expired.
+        @return @c true if the article was added and is not deleted. Updating the unread count is left to the caller.
+        */
+    bool appendArticle(const Article &a);
 
     /** checks whether article @c a is expired (considering custom and global archive mode settings) */
     bool isExpired(const Article &a) const;
+    bool isExpired(const QDateTime &pubDate) const;
+    /** returns the age in seconds after which articles of this feed expire, -1 if they do not expire */
+    int expiryAge() const;
 
     /** returns @c true if either this article uses @c limitArticleAge as custom setting or uses the global default, which is @c limitArticleAge */
     bool usesExpiryByAge() const;
@@ -289,10 +316,18 @@ private:
 
     void markAsFetchedNow();
 
+    /** ends the running fetch with @p status, which is not Syndication::Success */
+    void fetchFailed(Syndication::ErrorCode status, const QUrl &discoveredFeedUrl = QUrl());
+
+    /** called by FeedParser with the parsed document */
+    void parseCompleted(const ParsedFeed &result);
+
 private Q_SLOTS:
 
-    void fetchCompleted(Syndication::Loader *loader, Syndication::FeedPtr doc, Syndication::ErrorCode errorCode);
+    void slotDataRetrieved(const QByteArray &data, bool success);
     void slotImageFetched(const QPixmap &image);
+    /** adds a slice of the loaded articles to the search index, see loadArticles() */
+    void slotIndexArticles();
 
 private:
 
@@ -38,9 +38,12 @@
 #include <krandom.h>
 
 #include <qdom.h>
+#include <QElapsedTimer>
 #include <QHash>
+#include <QPointer>
 #include <QSet>
-#include <QTime>
+#include <QTimer>
+#include <QXmlStreamReader>
 
 #include <cassert>
 
@@ -60,6 +63,9 @@ public:
     RemoveNodeVisitor *removeNodeVisitor;
     QHash<QString, QList<Feed *> > urlMap;
     mutable int unreadCache;
+    /** feeds read from OPML whose article headers were not loaded yet, starting at nextHeadersToLoad */
+    QVector<QPointer<Feed> > headersToLoad;
+    int nextHeadersToLoad = 0;
 };
 
 class FeedList::AddNodeVisitor : public TreeNodeVisitor
@@ -267,8 +273,7 @@ bool FeedList::readFromOpml(const QDomDocument &doc)
 
     qCDebug(AKREGATOR_LOG) << "loading OPML feed" << root.tagName().toLower();
 
-    qCDebug(AKREGATOR_LOG) << "measuring startup time: START";
-    QTime spent;
+    QElapsedTimer spent;
     spent.start();
 
     if (root.tagName().toLower() != QLatin1String("opml")) {
@@ -294,6 +299,72 @@ bool FeedList::readFromOpml(const QDomDocument &doc)
         i = i.nextSibling();
     }
 
+    finishReadingOpml();
+
+    qCDebug(AKREGATOR_LOG) << "Feed list read in" << spent.elapsed() << "ms";
+    return true;
+}
+
+bool FeedList::readFromOpml(QXmlStreamReader &reader)
+{
+    QElapsedTimer spent;
+    spent.start();
+
+    if (!reader.readNextStartElement() || reader.name().compare(QLatin1String("opml"), Qt::CaseInsensitive) != 0) {
+        return false;
+    }
+
+    bool bodyFound = false;
+    while (reader.readNextStartElement()) {
+        if (reader.name().compare(QLatin1String("body"), Qt::CaseInsensitive) != 0) {
+            reader.skipCurrentElement();
+            continue;
+        }
+        bodyFound = true;
+        while (reader.readNextStartElement()) {
+            parseOutline(reader, allFeedsFolder());
+        }
+    }
+
+    if (reader.hasError()) {
+        return false;
+    }
+    if (!bodyFound) {
+        qCDebug(AKREGATOR_LOG) << "Failed to acquire body node, markup broken?";
+        return false;
+    }
+
+    finishReadingOpml();
+
+    qCDebug(AKREGATOR_LOG) << "Feed list read in" << spent.elapsed() << "ms";
+    return true;
+}
+
+void FeedList::parseOutline(QXmlStreamReader &reader, Folder *parent)
+{
+    const QXmlStreamAttributes attributes = reader.attributes();
+
+    if (attributes.hasAttribute(QStringLiteral("xmlUrl")) || attributes.hasAttribute(QStringLiteral("xmlurl")) || attributes.hasAttribute(QStringLiteral("xmlURL"))) {
+        Feed *feed = Feed::fromOPML(attributes, d->storage);
+        if (feed) {
+            if (!d->urlMap[feed->xmlUrl()].contains(feed)) {
+                d->urlMap[feed->xmlUrl()].append(feed);
+            }
+            parent->appendChild(feed);
+        }
+        reader.skipCurrentElement();
+    } else {
+        Folder *fg = Folder::fromOPML(attributes);
+        parent->appendChild(fg);
+
+        while (reader.readNextStartElement()) {
+            parseOutline(reader, fg);
+        }
+    }
+}
+
+void FeedList::finishReadingOpml()
+{
     for (TreeNode *i = allFeedsFolder()->firstChild(); i && i != allFeedsFolder(); i = i->next()) {
         if (i->id() == 0) {
             uint id = generateID();
@@ -302,9 +373,36 @@ bool FeedList::readFromOpml(const QDomDocument &doc)
         }
     }
 
-    qCDebug(AKREGATOR_LOG) << "measuring startup time: STOP," << spent.elapsed() << "ms";
-    qCDebug(AKREGATOR_LOG) << "Number of articles loaded:" << allFeedsFolder()->totalCount();
-    return true;
+    // let the subscription list show up first, the headers only refine the counts
+    const QVector<Feed *> feeds = allFeedsFolder()->feeds();
+    const bool idle = d->nextHeadersToLoad >= d->headersToLoad.count();
+    for (Feed *const feed : feeds) {
+        d->headersToLoad.append(feed);
+    }
+    if (idle) {
+        QTimer::singleShot(0, this, &FeedList::slotLoadArticleHeaders);
+    }
+}
+
+void FeedList::slotLoadArticleHeaders()
+{
+    static const qint64 timeBudget = 20;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (d->nextHeadersToLoad < d->headersToLoad.count() && !timer.hasExpired(timeBudget)) {
+        const QPointer<Feed> feed = d->headersToLoad.at(d->nextHeadersToLoad++);
+        if (feed) {
+            feed->loadArticleHeaders();
+        }
+    }
+
+    if (d->nextHeadersToLoad < d->headersToLoad.count()) {
+        QTimer::singleShot(0, this, &FeedList::slotLoadArticleHeaders);
+    } else {
+        d->headersToLoad.clear();
+        d->nextHeadersToLoad = 0;
+    }
 }
 
 FeedList::~FeedList()
@@ -35,6 +35,7 @@
 
 class QDomDocument;
 class QDomNode;
+class QXmlStreamReader;
 template<class T> class QList;
 template<class K, class T> class QHash;
 class QString;
@@ -123,6 +124,13 @@ public:
     */
     bool readFromOpml(const QDomDocument &doc);
 
+    /** reads an OPML document from a stream and appends the items to this list, without building a DOM tree.
+        The article headers of the feeds are loaded afterwards in the background.
+        @param reader the reader to parse from. Check it for XML errors when @c false is returned.
+        @return whether parsing was successful or not
+    */
+    bool readFromOpml(QXmlStreamReader &reader);
+
     /** exports the feed list as OPML. The root node ("All Feeds") is ignored! */
     QDomDocument toOpml() const;
 
@@ -176,9 +184,16 @@ private:
     void setRootNode(Folder *folder);
 
     void parseChildNodes(QDomNode &node, Folder *parent);
+    /** reads the outline element the reader is positioned at, including its children */
+    void parseOutline(QXmlStreamReader &reader, Folder *parent);
+    /** assigns ids to new nodes and schedules loading the article headers */
+    void finishReadingOpml();
 
 private Q_SLOTS:
 
+    /** loads the article headers of some of the feeds read from OPML, until time is up */
+    void slotLoadArticleHeaders();
+
     void slotNodeDestroyed(Akregator::TreeNode *node);
     void slotNodeAdded(Akregator::TreeNode *node);
     void slotNodeRemoved(Akregator::Folder *parent, Akregator::TreeNode *node);
@@ -0,0 +1,226 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "feedparser.h"
+#include "article.h"
+#include "feed.h"
+
+#include "akregator_debug.h"
+
+#include <Syndication/Syndication>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QThread>
+
+using namespace Akregator;
+
+namespace Akregator {
+class Q_DECL_HIDDEN ParseJob : public QRunnable
+{
+public:
+    ParseJob(FeedParser *parser, quint64 ticket, const QByteArray &data, const QUrl &url, const QHash<QString, uint> &knownHashes, const QString &imageFile)
+        : m_parser(parser)
+        , m_ticket(ticket)
+        , m_data(data)
+        , m_url(url)
+        , m_knownHashes(knownHashes)
+        , m_imageFile(imageFile)
+    {
+    }
+
+    void run() override
+    {
+        m_parser->addResult(m_ticket, FeedParser::parseDocument(m_data, m_url, m_knownHashes, m_imageFile));
+    }
+
+private:
+    FeedParser *const m_parser;
+    const quint64 m_ticket;
+    const QByteArray m_data;
+    const QUrl m_url;
+    const QHash<QString, uint> m_knownHashes;
+    const QString m_imageFile;
+};
+} // namespace Akregator
+
+FeedParser::FeedParser(QObject *parent)
+    : QObject(parent)
+{
+    // leave a core to the GUI thread, a handful of parsers keeps up with any number of concurrent downloads
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
+
+    // the parser collection is created lazily and not thread-safe, so create it before the first job runs
+    Syndication::parserCollection();
+}
+
+FeedParser::~FeedParser()
+{
+    shutdown();
+}
+
+void FeedParser::shutdown()
+{
+    m_jobs.clear();
+    m_pool.clear();
+    m_pool.waitForDone();
+    QMutexLocker locker(&m_resultsMutex);
+    m_results.clear();
+}
+
+quint64 FeedParser::parse(Feed *feed, const QByteArray &data, const QUrl &url, const QHash<QString, uint> &knownHashes, const QString &imageFile)
+{
+    const quint64 ticket = m_nextTicket++;
+    m_jobs.insert(ticket, feed);
+    m_pool.start(new ParseJob(this, ticket, data, url, knownHashes, imageFile));
+    return ticket;
+}
+
+void FeedParser::cancel(quint64 ticket)
+{
+    m_jobs.remove(ticket);
+}
+
+void FeedParser::addResult(quint64 ticket, const ParsedFeed &result)
+{
+    {
+        QMutexLocker locker(&m_resultsMutex);
+        m_results.enqueue(qMakePair(ticket, result));
+    }
+    QMetaObject::invokeMethod(this, "slotApplyResult", Qt::QueuedConnection);
+}
+
+void FeedParser::slotApplyResult()
+{
+    QPair<quint64, ParsedFeed> result;
+    {
+        QMutexLocker locker(&m_resultsMutex);
+        if (m_results.isEmpty()) {
+            return;
+        }
+        result = m_results.dequeue();
+    }
+
+    // the feed was deleted or aborted the fetch meanwhile
+    const QPointer<Feed> feed = m_jobs.take(result.first);
+    if (feed) {
+        feed->parseCompleted(result.second);
+    }
+}
+
+ParsedFeed FeedParser::parseDocument(const QByteArray &data, const QUrl &url, const QHash<QString, uint> &knownHashes, const QString &imageFile)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    ParsedFeed result;
+    if (!imageFile.isEmpty()) {
+        result.image.load(imageFile, "PNG");
+    }
+
+    // Thread safety: the parser collection is a process-wide object that is not thread-safe, parse() records
+    // its error code in it on every call. Its parser list is filled in the constructor, on the GUI thread, before
+    // any job runs, and parse() itself is serialized by parseMutex. Everything else used here is owned by this job:
+    // the document source, its DOM and the feed objects returned are never shared with another thread.
+    // The DOM is built before taking the lock, it is the costly part and cached by the source.
+    static QMutex parseMutex;
+    const Syndication::DocumentSource source(data, url.url());
+    source.asDomDocument();
+    Syndication::FeedPtr feed;
+    {
+        QMutexLocker locker(&parseMutex);
+        feed = Syndication::parserCollection()->parse(source);
+    }
+    if (!feed) {
+        if (source.asDomDocument().isNull()) {
+            result.status = Syndication::InvalidXml;
+            result.discoveredFeedUrl = discoverFeedUrl(data, url);
+        } else {
+            result.status = Syndication::XmlNotAccepted;
+        }
+        result.parseTime = timer.elapsed();
+        return result;
+    }
+
+    result.title = Syndication::htmlToPlainText(feed->title());
+    result.description = feed->description();
+    result.link = feed->link();
+
+    const QList<Syndication::ItemPtr> items = feed->items();
+    result.items.reserve(items.count());
+    for (const Syndication::ItemPtr &item : items) {
+        ParsedItem parsed;
+        parsed.guid = item->id();
+        parsed.record = Article::recordFromItem(item);
+        result.items.append(parsed);
+    }
+    result.parseTime = timer.restart();
+
+    for (ParsedItem &item : result.items) {
+        const auto it = knownHashes.constFind(item.guid);
+        if (it == knownHashes.constEnd()) {
+            item.change = ParsedItem::Added;
+        } else if (it.value() != item.record.hash) {
+            item.change = ParsedItem::Modified;
+        } else {
+            // nothing but the enclosure can differ, don't pass the texts around
+            item.change = ParsedItem::Unchanged;
+            Backend::ArticleRecord record;
+            record.hash = item.record.hash;
+            record.hasEnclosure = item.record.hasEnclosure;
+            record.enclosureUrl = item.record.enclosureUrl;
+            record.enclosureType = item.record.enclosureType;
+            record.enclosureLength = item.record.enclosureLength;
+            item.record = record;
+        }
+    }
+    result.diffTime = timer.elapsed();
+
+    return result;
+}
+
+QUrl FeedParser::discoverFeedUrl(const QByteArray &data, const QUrl &url)
+{
+    // looks for <link rel="alternate" type="application/rss+xml" href="..."> in an HTML page
+    const QString html = QString::fromUtf8(data);
+    static const QRegularExpression linkRx(QStringLiteral("<link[^>]*\\brel\\s*=\\s*[\"']?\\s*alternate\\b[^>]*>"), QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression typeRx(QStringLiteral("\\btype\\s*=\\s*[\"']?\\s*application/(rss|atom|rdf)\\+xml"), QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression hrefRx(QStringLiteral("\\bhref\\s*=\\s*[\"']?\\s*([^\"'\\s>]+)"), QRegularExpression::CaseInsensitiveOption);
+
+    QRegularExpressionMatchIterator it = linkRx.globalMatch(html);
+    while (it.hasNext()) {
+        const QString link = it.next().captured(0);
+        if (!typeRx.match(link).hasMatch()) {
+            continue;
+        }
+        const QRegularExpressionMatch href = hrefRx.match(link);
+        if (href.hasMatch()) {
+            return url.resolved(QUrl(href.captured(1)));
+        }
+    }
+    return QUrl();
+}
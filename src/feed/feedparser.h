@@ -0,0 +1,122 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_FEEDPARSER_H
+#define AKREGATOR_FEEDPARSER_H
+
+#include "akregator_export.h"
+#include "feedstorage.h"
+
+#include <Syndication/Global>
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QQueue>
+#include <QString>
+#include <QThreadPool>
+#include <QUrl>
+#include <QVector>
+
+namespace Akregator {
+class Feed;
+
+/** an item of a parsed feed document, classified against the articles known when the document was handed to the parser */
+class ParsedItem
+{
+public:
+    enum Change {
+        Added, /**< the guid was not in the article list */
+        Modified, /**< the guid was in the list with a different hash */
+        Unchanged /**< the guid was in the list with the same hash. Only hash and enclosure of @c record are set */
+    };
+
+    QString guid;
+    Backend::ArticleRecord record;
+    Change change = Added;
+};
+
+/** the result of parsing a feed document, free of any Syndication objects so it can be passed between threads */
+class ParsedFeed
+{
+public:
+    Syndication::ErrorCode status = Syndication::Success;
+    /** feed URL found in an HTML page, if the document was no feed */
+    QUrl discoveredFeedUrl;
+    QString title;
+    QString description;
+    QString link;
+    QVector<ParsedItem> items;
+    /** the cached feed image, if requested */
+    QImage image;
+    qint64 parseTime = 0;
+    qint64 diffTime = 0;
+};
+
+/** Parses downloaded feed documents on a thread pool. Parsing, hashing and diffing the items against the article list run
+    on the pool, the results are handed to the feeds on the GUI thread, one per event loop iteration.
+*/
+class AKREGATOR_EXPORT FeedParser : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FeedParser(QObject *parent = nullptr);
+    ~FeedParser() override;
+
+    /** starts parsing @p data downloaded from @p url for @p feed.
+        @param knownHashes the hashes of the articles in the feed's article list, by guid
+        @param imageFile file name of the cached feed image to load, or an empty string
+        @return a ticket identifying the job, for cancel()
+    */
+    quint64 parse(Feed *feed, const QByteArray &data, const QUrl &url, const QHash<QString, uint> &knownHashes, const QString &imageFile);
+
+    /** drops the result of the job @p ticket. The job itself finishes in the background */
+    void cancel(quint64 ticket);
+
+    /** drops all jobs and waits for the running ones to finish. Called at shutdown, while the application still exists */
+    void shutdown();
+
+private Q_SLOTS:
+    void slotApplyResult();
+
+private:
+    friend class ParseJob;
+    static ParsedFeed parseDocument(const QByteArray &data, const QUrl &url, const QHash<QString, uint> &knownHashes, const QString &imageFile);
+    static QUrl discoverFeedUrl(const QByteArray &data, const QUrl &url);
+    void addResult(quint64 ticket, const ParsedFeed &result);
+
+    QThreadPool m_pool;
+    QHash<quint64, QPointer<Feed> > m_jobs;
+    quint64 m_nextTicket = 1;
+
+    QMutex m_resultsMutex;
+    QQueue<QPair<quint64, ParsedFeed> > m_results;
+};
+} // namespace Akregator
+
+#endif // AKREGATOR_FEEDPARSER_H
@@ -0,0 +1,172 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "feedretriever.h"
+#include "akregatorconfig.h"
+
+#include <KIO/TransferJob>
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QStringList>
+#include <QTimer>
+#include <QUrl>
+
+using namespace Akregator;
+
+QString FeedRetriever::s_userAgent;
+
+FeedRetriever::FeedRetriever(const QString &etag, const QString &lastModified, const QByteArray &digest)
+    : m_etag(etag)
+    , m_lastModified(lastModified)
+    , m_digest(digest)
+{
+}
+
+FeedRetriever::~FeedRetriever()
+{
+    delete m_buffer;
+}
+
+void FeedRetriever::setUserAgent(const QString &userAgent)
+{
+    s_userAgent = userAgent;
+}
+
+void FeedRetriever::retrieveData(const QUrl &url)
+{
+    if (m_buffer) {
+        return;
+    }
+
+    m_buffer = new QBuffer;
+    m_buffer->open(QIODevice::WriteOnly);
+
+    QUrl u = url;
+    if (u.scheme() == QLatin1String("feed")) {
+        u.setScheme(QStringLiteral("http"));
+    }
+
+    QStringList conditions;
+    if (!m_etag.isEmpty()) {
+        conditions.append(QLatin1String("If-None-Match: ") + m_etag);
+    }
+    if (!m_lastModified.isEmpty()) {
+        conditions.append(QLatin1String("If-Modified-Since: ") + m_lastModified);
+    }
+
+    m_job = KIO::get(u, KIO::NoReload, KIO::HideProgressInfo);
+    m_job->addMetaData(QStringLiteral("UserAgent"), s_userAgent);
+    m_job->addMetaData(QStringLiteral("PropagateHttpHeader"), QStringLiteral("true"));
+    if (!conditions.isEmpty()) {
+        // we validate ourselves, the HTTP cache would answer with the cached document instead of 304
+        m_job->addMetaData(QStringLiteral("cache"), QStringLiteral("reload"));
+        m_job->addMetaData(QStringLiteral("customHTTPHeader"), conditions.join(QLatin1String("\r\n")));
+    } else {
+        m_job->addMetaData(QStringLiteral("cache"), Settings::useHTMLCache() ? QStringLiteral("refresh") : QStringLiteral("reload"));
+    }
+
+    QTimer::singleShot(1000 * 90, this, &FeedRetriever::slotTimeout);
+
+    connect(m_job, &KIO::TransferJob::data, this, &FeedRetriever::slotData);
+    connect(m_job, &KJob::result, this, &FeedRetriever::slotResult);
+}
+
+int FeedRetriever::errorCode() const
+{
+    return m_lastError;
+}
+
+void FeedRetriever::abort()
+{
+    if (m_job) {
+        m_job->kill();
+        m_job = nullptr;
+    }
+}
+
+void FeedRetriever::slotTimeout()
+{
+    abort();
+
+    delete m_buffer;
+    m_buffer = nullptr;
+
+    m_lastError = KIO::ERR_SERVER_TIMEOUT;
+
+    Q_EMIT dataRetrieved(QByteArray(), false);
+}
+
+void FeedRetriever::slotData(KIO::Job *, const QByteArray &data)
+{
+    m_buffer->write(data.data(), data.size());
+}
+
+void FeedRetriever::slotResult(KJob *job)
+{
+    m_job = nullptr;
+
+    QByteArray data = m_buffer->buffer();
+    data.detach();
+
+    delete m_buffer;
+    m_buffer = nullptr;
+
+    KIO::Job *const kioJob = static_cast<KIO::Job *>(job);
+    if (kioJob->queryMetaData(QStringLiteral("responsecode")).toInt() == 304) {
+        m_lastError = NotModified;
+        Q_EMIT dataRetrieved(QByteArray(), false);
+        return;
+    }
+
+    m_lastError = job->error();
+    if (m_lastError == 0) {
+        QString etag;
+        QString lastModified;
+        const QStringList headers = kioJob->queryMetaData(QStringLiteral("HTTP-Headers")).split(QLatin1Char('\n'));
+        for (const QString &header : headers) {
+            const int colon = header.indexOf(QLatin1Char(':'));
+            if (colon == -1) {
+                continue;
+            }
+            const QStringRef name = header.leftRef(colon).trimmed();
+            if (name.compare(QLatin1String("ETag"), Qt::CaseInsensitive) == 0) {
+                etag = header.mid(colon + 1).trimmed();
+            } else if (name.compare(QLatin1String("Last-Modified"), Qt::CaseInsensitive) == 0) {
+                lastModified = header.mid(colon + 1).trimmed();
+            }
+        }
+        // emitted for an unchanged document as well, the server may have sent new validators for it
+        const QByteArray digest = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+        Q_EMIT validatorsReceived(etag, lastModified, digest);
+
+        if (!m_digest.isEmpty() && digest == m_digest) {
+            m_lastError = Unchanged;
+            Q_EMIT dataRetrieved(QByteArray(), false);
+            return;
+        }
+    }
+
+    Q_EMIT dataRetrieved(data, m_lastError == 0);
+}
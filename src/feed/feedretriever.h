@@ -0,0 +1,86 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_FEEDRETRIEVER_H
+#define AKREGATOR_FEEDRETRIEVER_H
+
+#include "akregator_export.h"
+
+#include <Syndication/DataRetriever>
+
+#include <QString>
+
+class KJob;
+class QBuffer;
+
+namespace KIO {
+class Job;
+class TransferJob;
+}
+
+namespace Akregator {
+/** Downloads a feed like Syndication::FileRetriever, but sends the HTTP validators (ETag and Last-Modified) of the previous fetch.
+    If the server replies "304 Not Modified", the retrieval fails with errorCode() NotModified and no data.
+    If the document is byte-identical to the previous one, it fails with errorCode() Unchanged, so it is not parsed again.
+*/
+class AKREGATOR_EXPORT FeedRetriever : public Syndication::DataRetriever
+{
+    Q_OBJECT
+public:
+    enum {
+        NotModified = -304, /**< error code if the feed did not change since the validators were sent */
+        Unchanged = -305 /**< error code if the downloaded document has the digest passed to the constructor */
+    };
+
+    FeedRetriever(const QString &etag, const QString &lastModified, const QByteArray &digest);
+    ~FeedRetriever() override;
+
+    void retrieveData(const QUrl &url) override;
+    int errorCode() const override;
+    void abort() override;
+
+    static void setUserAgent(const QString &userAgent);
+
+Q_SIGNALS:
+    /** emitted before dataRetrieved() with the validators sent by the server and the digest of the document, also if the document is Unchanged */
+    void validatorsReceived(const QString &etag, const QString &lastModified, const QByteArray &digest);
+
+private Q_SLOTS:
+    void slotData(KIO::Job *job, const QByteArray &data);
+    void slotResult(KJob *job);
+    void slotTimeout();
+
+private:
+    static QString s_userAgent;
+
+    QString m_etag;
+    QString m_lastModified;
+    QByteArray m_digest;
+    QBuffer *m_buffer = nullptr;
+    KIO::TransferJob *m_job = nullptr;
+    int m_lastError = 0;
+};
+} // namespace Akregator
+
+#endif // AKREGATOR_FEEDRETRIEVER_H
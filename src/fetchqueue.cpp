@@ -28,20 +28,86 @@
 #include "feed.h"
 #include "treenode.h"
 
-#include <QList>
+#include <QDateTime>
+#include <QHash>
+#include <QUrl>
+#include <QVector>
 
+#include <algorithm>
 #include <cassert>
 
 using namespace Akregator;
 
+namespace {
+/** extra delay for interval fetches of feeds failing repeatedly, doubled with every further error */
+const uint BackoffBase = 30 * 60;
+const uint MaxBackoff = 24 * 3600;
+
+uint currentTime()
+{
+    return QDateTime::currentDateTimeUtc().toTime_t();
+}
+
+QString hostOf(const Feed *feed)
+{
+    return QUrl(feed->xmlUrl()).host();
+}
+}
+
 class FetchQueue::FetchQueuePrivate
 {
 public:
 
-    QList<Feed *> queuedFeeds;
-    QList<Feed *> fetchingFeeds;
+    struct Entry {
+        Feed *feed;
+        QString host;
+        uint dueTime;
+        quint64 seq;
+    };
+
+    struct Failures {
+        int count = 0;
+        uint lastError = 0;
+    };
+
+    /** heap order: the entry due first is on top, ties are fetched in insertion order */
+    static bool dueLater(const Entry &a, const Entry &b)
+    {
+        return a.dueTime > b.dueTime || (a.dueTime == b.dueTime && a.seq > b.seq);
+    }
+
+    void enqueue(Feed *feed, uint dueTime);
+    bool isBackingOff(Feed *feed, uint now) const;
+
+    /** heap of queued entries. Entries whose seq does not match queuedFeeds any more are stale and skipped */
+    QVector<Entry> heap;
+    QHash<Feed *, Entry> queuedFeeds;
+    /** fetching feeds and their hosts */
+    QHash<Feed *, QString> fetchingFeeds;
+    QHash<QString, int> fetchingPerHost;
+    /** keyed by URL, so that entries of deleted feeds do not dangle once the feed is no longer queued */
+    QHash<QString, Failures> failures;
+    quint64 nextSeq = 0;
 };
 
+void FetchQueue::FetchQueuePrivate::enqueue(Feed *feed, uint dueTime)
+{
+    const Entry entry = { feed, hostOf(feed), dueTime, nextSeq++ };
+    queuedFeeds.insert(feed, entry);
+    heap.append(entry);
+    std::push_heap(heap.begin(), heap.end(), dueLater);
+}
+
+bool FetchQueue::FetchQueuePrivate::isBackingOff(Feed *feed, uint now) const
+{
+    const auto it = failures.constFind(feed->xmlUrl());
+    if (it == failures.constEnd() || it->count < 2) {
+        return false;
+    }
+    const uint backoff = std::min(BackoffBase << std::min(it->count - 2, 10), MaxBackoff);
+    return now - it->lastError < backoff;
+}
+
 FetchQueue::FetchQueue(QObject *parent) : QObject(parent)
     , d(new FetchQueuePrivate)
 {
@@ -56,50 +122,106 @@ FetchQueue::~FetchQueue()
 
 void FetchQueue::slotAbort()
 {
-    for (Feed *const i : qAsConst(d->fetchingFeeds)) {
+    const QList<Feed *> fetching = d->fetchingFeeds.keys();
+    for (Feed *const i : fetching) {
         disconnectFromFeed(i);
         i->slotAbortFetch();
     }
     d->fetchingFeeds.clear();
+    d->fetchingPerHost.clear();
 
-    for (Feed *const i : qAsConst(d->queuedFeeds)) {
-        disconnectFromFeed(i);
+    for (auto it = d->queuedFeeds.constBegin(), end = d->queuedFeeds.constEnd(); it != end; ++it) {
+        disconnectFromFeed(it.key());
     }
     d->queuedFeeds.clear();
+    d->heap.clear();
 
     Q_EMIT signalStopped();
 }
 
 void FetchQueue::addFeed(Feed *f)
 {
-    if (!d->queuedFeeds.contains(f) && !d->fetchingFeeds.contains(f)) {
-        connectToFeed(f);
-        d->queuedFeeds.append(f);
-        fetchNextFeed();
+    scheduleFeed(f, 0, false);
+}
+
+void FetchQueue::addFeed(Feed *f, uint dueTime)
+{
+    scheduleFeed(f, dueTime, true);
+}
+
+void FetchQueue::scheduleFeed(Feed *f, uint dueTime, bool intervalFetch)
+{
+    if (d->fetchingFeeds.contains(f)) {
+        return;
+    }
+
+    const auto queued = d->queuedFeeds.constFind(f);
+    if (queued != d->queuedFeeds.constEnd()) {
+        // already waiting: only move it forward, the old heap entry becomes stale
+        if (dueTime < queued->dueTime) {
+            d->enqueue(f, dueTime);
+        }
+        return;
+    }
+
+    if (intervalFetch && d->isBackingOff(f, currentTime())) {
+        return;
     }
+
+    const bool wasEmpty = isEmpty();
+    connectToFeed(f);
+    d->enqueue(f, dueTime);
+    if (wasEmpty) {
+        Q_EMIT signalStarted();
+    }
+    fetchNextFeed();
 }
 
 void FetchQueue::fetchNextFeed()
 {
-    if (!d->queuedFeeds.isEmpty() && d->fetchingFeeds.count() < Settings::concurrentFetches()) {
-        if (d->fetchingFeeds.isEmpty() && d->queuedFeeds.count() == 1) {
-            Q_EMIT signalStarted();
+    const int maxFetches = Settings::concurrentFetches();
+    const int maxPerHost = Settings::concurrentFetchesPerHost();
+
+    // entries whose host is busy are set aside and put back afterwards, so that other hosts are not starved
+    QVector<FetchQueuePrivate::Entry> blocked;
+
+    while (!d->heap.isEmpty() && d->fetchingFeeds.count() < maxFetches) {
+        std::pop_heap(d->heap.begin(), d->heap.end(), FetchQueuePrivate::dueLater);
+        const FetchQueuePrivate::Entry entry = d->heap.takeLast();
+
+        const auto queued = d->queuedFeeds.constFind(entry.feed);
+        if (queued == d->queuedFeeds.constEnd() || queued->seq != entry.seq) {
+            continue;
+        }
+        if (maxPerHost > 0 && d->fetchingPerHost.value(entry.host) >= maxPerHost) {
+            blocked.append(entry);
+            continue;
         }
-        Feed *f = *(d->queuedFeeds.begin());
-        d->queuedFeeds.pop_front();
-        d->fetchingFeeds.append(f);
-        f->fetch(false);
+
+        d->queuedFeeds.erase(queued);
+        d->fetchingFeeds.insert(entry.feed, entry.host);
+        ++d->fetchingPerHost[entry.host];
+        entry.feed->fetch(false);
+    }
+
+    for (const FetchQueuePrivate::Entry &entry : qAsConst(blocked)) {
+        d->heap.append(entry);
+        std::push_heap(d->heap.begin(), d->heap.end(), FetchQueuePrivate::dueLater);
     }
 }
 
 void FetchQueue::slotFeedFetched(Feed *f)
 {
+    d->failures.remove(f->xmlUrl());
     Q_EMIT fetched(f);
     feedDone(f);
 }
 
 void FetchQueue::slotFetchError(Feed *f)
 {
+    FetchQueuePrivate::Failures &failures = d->failures[f->xmlUrl()];
+    ++failures.count;
+    failures.lastError = currentTime();
     Q_EMIT fetchError(f);
     feedDone(f);
 }
@@ -118,7 +240,7 @@ bool FetchQueue::isEmpty() const
 void FetchQueue::feedDone(Feed *f)
 {
     disconnectFromFeed(f);
-    d->fetchingFeeds.removeAll(f);
+    removeFetching(f);
     if (isEmpty()) {
         Q_EMIT signalStopped();
     } else {
@@ -126,6 +248,19 @@ void FetchQueue::feedDone(Feed *f)
     }
 }
 
+void FetchQueue::removeFetching(Feed *f)
+{
+    const auto it = d->fetchingFeeds.find(f);
+    if (it == d->fetchingFeeds.end()) {
+        return;
+    }
+    const auto host = d->fetchingPerHost.find(it.value());
+    if (host != d->fetchingPerHost.end() && --host.value() <= 0) {
+        d->fetchingPerHost.erase(host);
+    }
+    d->fetchingFeeds.erase(it);
+}
+
 void FetchQueue::connectToFeed(Feed *feed)
 {
     connect(feed, &Feed::fetched, this, &FetchQueue::slotFeedFetched);
@@ -144,6 +279,6 @@ void FetchQueue::slotNodeDestroyed(TreeNode *node)
     Feed *const feed = qobject_cast<Feed *>(node);
     Q_ASSERT(feed);
 
-    d->fetchingFeeds.removeAll(feed);
-    d->queuedFeeds.removeAll(feed);
+    removeFetching(feed);
+    d->queuedFeeds.remove(feed);
 }
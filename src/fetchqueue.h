@@ -45,9 +45,14 @@ public:
     /** returns true when no feeds are neither fetching nor queued */
     bool isEmpty() const;
 
-    /** adds a feed to the queue */
+    /** adds a feed to the queue, to be fetched as soon as possible */
     void addFeed(Feed *f);
 
+    /** adds a feed to the queue for an interval fetch. Feeds are fetched in order of @p dueTime (seconds since epoch, UTC).
+        Feeds failing repeatedly are skipped until their backoff delay has passed.
+     */
+    void addFeed(Feed *f, uint dueTime);
+
 public Q_SLOTS:
 
     /** aborts currently fetching feeds and empties the queue */
@@ -66,6 +71,9 @@ protected:
     void fetchNextFeed();
 
     void feedDone(Feed *f);
+    void scheduleFeed(Feed *f, uint dueTime, bool intervalFetch);
+    /** removes @p f from the fetching feeds and releases its host slot */
+    void removeFetching(Feed *f);
     void connectToFeed(Feed *feed);
     void disconnectFromFeed(Feed *feed);
 
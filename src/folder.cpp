@@ -31,28 +31,17 @@
 #include "treenodevisitor.h"
 
 #include <qdom.h>
+#include <QHash>
 #include <QList>
 
 #include <QIcon>
+#include <QXmlStreamAttributes>
 #include "akregator_debug.h"
 
 #include <cassert>
 
 using namespace Akregator;
 
-// efficient alternative so we don't convert first to a temporary QList then to QVector
-template<typename T>
-static QVector<T> hashValuesToVector(const QHash<int, T> &hash)
-{
-    QVector<T> result;
-    result.reserve(hash.count());
-    for (auto it = hash.cbegin(), end = hash.cend(); it != end; ++it) {
-        result.append(it.value());
-    }
-
-    return result;
-}
-
 class Folder::FolderPrivate
 {
     Folder *const q;
@@ -62,11 +51,26 @@ public:
 
     /** List of children */
     QList<TreeNode *> children;
-    /** caching unread count of children */
-    mutable int unread;
+    /** accumulated unread count of the children, kept up to date from their change notifications */
+    int unread;
+    /** unread count of each child as included in unread */
+    QHash<const TreeNode *, int> childUnread;
+    /** accumulated total count of the children, -1 if it must be recomputed */
+    mutable int totalCount;
     /** whether or not the folder is expanded */
     bool open;
 
+    /** flattened feeds and folders of the subtree, rebuilt after structural changes */
+    mutable bool treeCachesValid = false;
+    mutable QVector<Feed *> feeds;
+    mutable QVector<const Feed *> constFeeds;
+    mutable QVector<Folder *> folders;
+    mutable QVector<const Folder *> constFolders;
+
+    /** position of each child in children */
+    mutable bool childIndicesValid = false;
+    mutable QHash<const TreeNode *, int> childIndices;
+
     /** caches guids for notifying added articles */
     QVector<Article> addedArticlesNotify;
     /** caches guids for notifying removed articles */
@@ -75,6 +79,7 @@ public:
 
 Folder::FolderPrivate::FolderPrivate(Folder *qq) : q(qq)
     , unread(0)
+    , totalCount(-1)
     , open(false)
 {
 }
@@ -105,6 +110,14 @@ Folder *Folder::fromOPML(const QDomElement &e)
     return fg;
 }
 
+Folder *Folder::fromOPML(const QXmlStreamAttributes &attributes)
+{
+    Folder *fg = new Folder(attributes.hasAttribute(QStringLiteral("text")) ? attributes.value(QStringLiteral("text")).toString() : attributes.value(QStringLiteral("title")).toString());
+    fg->setOpen(attributes.value(QStringLiteral("isOpen")) == QLatin1String("true"));
+    fg->setId(attributes.value(QStringLiteral("id")).toUInt());
+    return fg;
+}
+
 Folder::Folder(const QString &title) : TreeNode()
     , d(new FolderPrivate(this))
 {
@@ -157,56 +170,76 @@ QList<TreeNode *> Folder::children()
 
 QVector<const Akregator::Feed *> Folder::feeds() const
 {
-    QHash<int, const Akregator::Feed *> feedsById;
-    for (const TreeNode *i : qAsConst(d->children)) {
-        Q_FOREACH (const Akregator::Feed *j, i->feeds()) {
-            feedsById.insert(j->id(), j);
-        }
-    }
-
-    return hashValuesToVector<const Akregator::Feed *>(feedsById);
+    updateTreeCaches();
+    return d->constFeeds;
 }
 
 QVector<Akregator::Feed *> Folder::feeds()
 {
-    QHash<int, Akregator::Feed *> feedsById;
-    for (TreeNode *i : qAsConst(d->children)) {
-        Q_FOREACH (Akregator::Feed *j, i->feeds()) {
-            feedsById.insert(j->id(), j);
-        }
-    }
-
-    return hashValuesToVector<Akregator::Feed *>(feedsById);
+    updateTreeCaches();
+    return d->feeds;
 }
 
 QVector<const Folder *> Folder::folders() const
 {
-    QHash<int, const Folder *> foldersById;
-    foldersById.insert(id(), this);
-    for (const TreeNode *i : qAsConst(d->children)) {
-        Q_FOREACH (const Folder *j, i->folders()) {
-            foldersById.insert(j->id(), j);
-        }
-    }
-
-    return hashValuesToVector<const Folder *>(foldersById);
+    updateTreeCaches();
+    return d->constFolders;
 }
 
 QVector<Folder *> Folder::folders()
 {
-    QHash<int, Folder *> foldersById;
-    foldersById.insert(id(), this);
+    updateTreeCaches();
+    return d->folders;
+}
+
+void Folder::updateTreeCaches() const
+{
+    if (d->treeCachesValid) {
+        return;
+    }
+
+    d->feeds.clear();
+    d->constFeeds.clear();
+    d->folders.clear();
+    d->constFolders.clear();
+    d->folders.append(const_cast<Folder *>(this));
+    d->constFolders.append(this);
     for (TreeNode *i : qAsConst(d->children)) {
-        Q_FOREACH (Folder *j, i->folders()) {
-            foldersById.insert(j->id(), j);
+        if (Folder *const folder = qobject_cast<Folder *>(i)) {
+            folder->updateTreeCaches();
+            d->feeds += folder->d->feeds;
+            d->constFeeds += folder->d->constFeeds;
+            d->folders += folder->d->folders;
+            d->constFolders += folder->d->constFolders;
+        } else if (Feed *const feed = qobject_cast<Feed *>(i)) {
+            d->feeds.append(feed);
+            d->constFeeds.append(feed);
         }
     }
-    return hashValuesToVector<Folder *>(foldersById);
+    d->treeCachesValid = true;
+}
+
+void Folder::invalidateTreeCaches()
+{
+    d->childIndicesValid = false;
+    // a folder's cache is only valid if those of its subfolders are, so stop at the first invalid one
+    for (Folder *folder = this; folder && folder->d->treeCachesValid; folder = folder->parent()) {
+        folder->d->treeCachesValid = false;
+    }
 }
 
 int Folder::indexOf(const TreeNode *node) const
 {
-    return children().indexOf(node);
+    if (!d->childIndicesValid) {
+        d->childIndices.clear();
+        d->childIndices.reserve(d->children.count());
+        const int childrenCount(d->children.count());
+        for (int i = 0; i < childrenCount; ++i) {
+            d->childIndices.insert(d->children.at(i), i);
+        }
+        d->childIndicesValid = true;
+    }
+    return d->childIndices.value(node, -1);
 }
 
 void Folder::insertChild(TreeNode *node, TreeNode *after)
@@ -235,8 +268,9 @@ void Folder::insertChild(int index, TreeNode *node)
             d->children.insert(index, node);
         }
         node->setParent(this);
+        invalidateTreeCaches();
         connectToNode(node);
-        updateUnreadCount();
+        addChildCounts(node);
         Q_EMIT signalChildAdded(node);
         d->addedArticlesNotify += node->articles();
         articlesModified();
@@ -251,8 +285,9 @@ void Folder::appendChild(TreeNode *node)
     if (node) {
         d->children.append(node);
         node->setParent(this);
+        invalidateTreeCaches();
         connectToNode(node);
-        updateUnreadCount();
+        addChildCounts(node);
         Q_EMIT signalChildAdded(node);
         d->addedArticlesNotify += node->articles();
         articlesModified();
@@ -267,8 +302,9 @@ void Folder::prependChild(TreeNode *node)
     if (node) {
         d->children.prepend(node);
         node->setParent(this);
+        invalidateTreeCaches();
         connectToNode(node);
-        updateUnreadCount();
+        addChildCounts(node);
         Q_EMIT signalChildAdded(node);
         d->addedArticlesNotify += node->articles();
         articlesModified();
@@ -286,8 +322,9 @@ void Folder::removeChild(TreeNode *node)
     Q_EMIT signalAboutToRemoveChild(node);
     node->setParent(nullptr);
     d->children.removeOne(node);
+    invalidateTreeCaches();
     disconnectFromNode(node);
-    updateUnreadCount();
+    removeChildCounts(node);
     Q_EMIT signalChildRemoved(this, node);
     d->removedArticlesNotify += node->articles();
     articlesModified(); // articles were removed, TODO: add guids to a list
@@ -296,22 +333,22 @@ void Folder::removeChild(TreeNode *node)
 
 TreeNode *Folder::firstChild()
 {
-    return d->children.isEmpty() ? nullptr : children().first();
+    return d->children.isEmpty() ? nullptr : d->children.first();
 }
 
 const TreeNode *Folder::firstChild() const
 {
-    return d->children.isEmpty() ? nullptr : children().first();
+    return d->children.isEmpty() ? nullptr : d->children.first();
 }
 
 TreeNode *Folder::lastChild()
 {
-    return d->children.isEmpty() ? nullptr : children().last();
+    return d->children.isEmpty() ? nullptr : d->children.last();
 }
 
 const TreeNode *Folder::lastChild() const
 {
-    return d->children.isEmpty() ? nullptr : children().last();
+    return d->children.isEmpty() ? nullptr : d->children.last();
 }
 
 bool Folder::isOpen() const
@@ -331,20 +368,28 @@ int Folder::unread() const
 
 int Folder::totalCount() const
 {
-    int total = 0;
-    Q_FOREACH (const Feed *const i, feeds()) {
-        total += i->totalCount();
+    if (d->totalCount == -1) {
+        int total = 0;
+        for (const TreeNode *i : qAsConst(d->children)) {
+            total += i->totalCount();
+        }
+        d->totalCount = total;
     }
-    return total;
+    return d->totalCount;
 }
 
-void Folder::updateUnreadCount() const
+void Folder::addChildCounts(const TreeNode *child)
 {
-    int unread = 0;
-    Q_FOREACH (const Feed *const i, feeds()) {
-        unread += i->unread();
-    }
-    d->unread = unread;
+    const int unread = child->unread();
+    d->childUnread.insert(child, unread);
+    d->unread += unread;
+    d->totalCount = -1;
+}
+
+void Folder::removeChildCounts(const TreeNode *child)
+{
+    d->unread -= d->childUnread.take(child);
+    d->totalCount = -1;
 }
 
 KJob *Folder::createMarkAsReadJob()
@@ -356,16 +401,29 @@ KJob *Folder::createMarkAsReadJob()
     return job;
 }
 
-void Folder::slotChildChanged(TreeNode * /*node*/)
+void Folder::slotChildChanged(TreeNode *node)
 {
-    updateUnreadCount();
+    // apply the difference only, child folders keep their own sums
+    const auto it = d->childUnread.find(node);
+    if (it != d->childUnread.end()) {
+        const int unread = node->unread();
+        d->unread += unread - it.value();
+        it.value() = unread;
+    }
+    d->totalCount = -1;
     nodeModified();
 }
 
+void Folder::slotChildArticlesChanged()
+{
+    d->totalCount = -1;
+}
+
 void Folder::slotChildDestroyed(TreeNode *node)
 {
     d->children.removeAll(node);
-    updateUnreadCount();
+    invalidateTreeCaches();
+    removeChildCounts(node);
     nodeModified();
 }
 
@@ -408,6 +466,8 @@ void Folder::connectToNode(TreeNode *child)
 {
     connect(child, &TreeNode::signalChanged, this, &Folder::slotChildChanged);
     connect(child, &TreeNode::signalDestroyed, this, &Folder::slotChildDestroyed);
+    connect(child, &TreeNode::signalArticlesAdded, this, &Folder::slotChildArticlesChanged);
+    connect(child, &TreeNode::signalArticlesRemoved, this, &Folder::slotChildArticlesChanged);
     connect(child, &TreeNode::signalArticlesAdded, this, &TreeNode::signalArticlesAdded);
     connect(child, &TreeNode::signalArticlesRemoved, this, &TreeNode::signalArticlesRemoved);
     connect(child, &TreeNode::signalArticlesUpdated, this, &TreeNode::signalArticlesUpdated);
@@ -31,6 +31,7 @@
 
 class QDomDocument;
 class QDomElement;
+class QXmlStreamAttributes;
 template<class T> class QList;
 
 namespace Akregator {
@@ -49,6 +50,8 @@ public:
     @param e the element representing the feed group
     @return a freshly created feed group */
     static Folder *fromOPML(const QDomElement &e);
+    /** creates a feed group from the attributes of an OPML outline element */
+    static Folder *fromOPML(const QXmlStreamAttributes &attributes);
 
     /** Creates a new folder with a given title
     @param title The title of the feed group
@@ -181,6 +184,11 @@ public Q_SLOTS:
     @param queue a fetch queue */
     void slotAddToFetchQueue(Akregator::FetchQueue *queue, bool intervalFetchesOnly = false) override;
 
+private Q_SLOTS:
+
+    /** invalidates the accumulated total count when a child's articles were added or removed */
+    void slotChildArticlesChanged();
+
 protected:
 
     /** inserts @c node as child on position @c index
@@ -196,7 +204,15 @@ private:
     void connectToNode(TreeNode *child);
     void disconnectFromNode(TreeNode *child);
 
-    void updateUnreadCount() const;
+    /** rebuilds the flattened feed and folder lists of the subtree if needed */
+    void updateTreeCaches() const;
+    /** drops the cached lists and child positions of this folder and its ancestors after a structural change */
+    void invalidateTreeCaches();
+
+    /** adds the counts of a new child to the accumulated counts */
+    void addChildCounts(const TreeNode *child);
+    /** subtracts the counts of a removed child from the accumulated counts */
+    void removeChildCounts(const TreeNode *child);
 
     class FolderPrivate;
     FolderPrivate *d;
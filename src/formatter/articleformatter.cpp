@@ -59,6 +59,30 @@ ArticleFormatter::~ArticleFormatter()
     delete d;
 }
 
+QStringList ArticleFormatter::formatArticleFragments(const QVector<Article> &articles, IconOption icon) const
+{
+    QStringList fragments;
+    fragments.reserve(articles.count());
+    for (const Article &article : articles) {
+        fragments.append(htmlBody(formatArticles(QVector<Article>() << article, icon)));
+    }
+    return fragments;
+}
+
+QString ArticleFormatter::htmlBody(const QString &html)
+{
+    const int bodyTag = html.indexOf(QLatin1String("<body"), 0, Qt::CaseInsensitive);
+    if (bodyTag == -1) {
+        return html;
+    }
+    const int begin = html.indexOf(QLatin1Char('>'), bodyTag);
+    const int end = html.lastIndexOf(QLatin1String("</body>"), -1, Qt::CaseInsensitive);
+    if (begin == -1 || end < begin) {
+        return html;
+    }
+    return html.mid(begin + 1, end - begin - 1);
+}
+
 QString ArticleFormatter::formatEnclosure(const Enclosure &enclosure)
 {
     if (enclosure.isNull()) {
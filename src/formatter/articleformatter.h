@@ -26,6 +26,7 @@
 #define AKREGATOR_ARTICLEFORMATTER_H
 
 #include <enclosure.h>
+#include <QStringList>
 #include <QVector>
 
 namespace Akregator {
@@ -49,8 +50,16 @@ public:
 
     virtual QString formatSummary(TreeNode *node) const = 0;
 
+    /** formats each article on its own and returns the HTML body of each, for views updating the page article by article.
+        The default implementation calls formatArticles() once per article.
+    */
+    virtual QStringList formatArticleFragments(const QVector<Article> &articles, IconOption icon) const;
+
     static QString formatEnclosure(const Syndication::Enclosure &enclosure);
 
+    /** returns the content of the body element of the HTML page @p html, or @p html if it has none */
+    static QString htmlBody(const QString &html);
+
 private:
     class Private;
     Private *const d;
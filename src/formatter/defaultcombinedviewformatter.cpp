@@ -51,6 +51,15 @@ QString DefaultCombinedViewFormatter::formatArticles(const QVector<Article> &art
     return mGrantleeViewFormatter->formatArticles(articles, icon);
 }
 
+QStringList DefaultCombinedViewFormatter::formatArticleFragments(const QVector<Article> &articles, IconOption icon) const
+{
+    QStringList fragments = mGrantleeViewFormatter->formatArticlesSeparately(articles, icon);
+    for (QString &fragment : fragments) {
+        fragment = htmlBody(fragment);
+    }
+    return fragments;
+}
+
 QString DefaultCombinedViewFormatter::formatSummary(TreeNode *) const
 {
     return QString();
@@ -35,6 +35,8 @@ public:
 
     QString formatSummary(TreeNode *node) const override;
 
+    QStringList formatArticleFragments(const QVector<Article> &articles, IconOption icon) const override;
+
 private:
     DefaultCombinedViewFormatter();
     GrantleeViewFormatter *mGrantleeViewFormatter = nullptr;
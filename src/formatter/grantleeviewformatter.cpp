@@ -152,14 +152,42 @@ QString GrantleeViewFormatter::formatArticles(const QVector<Article> &article, A
     articleObject.insert(QStringLiteral("articles"), articlesList);
 
     addStandardObject(articleObject);
+    addArticleStrings(articleObject);
 
+    const QString str = render(articleObject);
+    qDeleteAll(lstObj);
+    return str;
+}
+
+QStringList GrantleeViewFormatter::formatArticlesSeparately(const QVector<Article> &articles, ArticleFormatter::IconOption icon)
+{
+    setDefaultHtmlMainFile(mHtmlArticleFileName);
+    QStringList pages;
+    pages.reserve(articles.count());
+    if (!errorMessage().isEmpty()) {
+        for (int i = 0; i < articles.count(); ++i) {
+            pages.append(errorMessage());
+        }
+        return pages;
+    }
+
+    QVariantHash articleObject;
+    addStandardObject(articleObject);
+    addArticleStrings(articleObject);
+
+    for (const Article &article : articles) {
+        ArticleGrantleeObject articleObj(mImageDir, article, icon);
+        articleObject.insert(QStringLiteral("articles"), QVariantList() << QVariant::fromValue(static_cast<QObject *>(&articleObj)));
+        pages.append(render(articleObject));
+    }
+    return pages;
+}
+
+void GrantleeViewFormatter::addArticleStrings(QVariantHash &articleObject)
+{
     articleObject.insert(QStringLiteral("dateI18n"), i18n("Date"));
     articleObject.insert(QStringLiteral("commentI18n"), i18n("Comment"));
     articleObject.insert(QStringLiteral("completeStoryI18n"), i18n("Complete Story"));
     articleObject.insert(QStringLiteral("authorI18n"), i18n("Author"));
     articleObject.insert(QStringLiteral("enclosureI18n"), i18n("Enclosure"));
-
-    const QString str = render(articleObject);
-    qDeleteAll(lstObj);
-    return str;
 }
@@ -34,10 +34,13 @@ public:
     ~GrantleeViewFormatter();
 
     QString formatArticles(const QVector<Article> &article, ArticleFormatter::IconOption icon);
+    /** renders a page for each of @p articles, loading the template only once */
+    QStringList formatArticlesSeparately(const QVector<Article> &articles, ArticleFormatter::IconOption icon);
     QString formatFolder(Akregator::Folder *node);
     QString formatFeed(Akregator::Feed *feed);
 private:
     void addStandardObject(QVariantHash &grantleeObject);
+    void addArticleStrings(QVariantHash &articleObject);
     int pointsToPixel(int pointSize) const;
     QUrl mImageDir;
     QString mHtmlArticleFileName;
@@ -25,6 +25,7 @@
 #include "kernel.h"
 
 #include "feedlist.h"
+#include "feedparser.h"
 #include "fetchqueue.h"
 #include "framemanager.h"
 
@@ -48,12 +49,15 @@ public:
     Backend::Storage *storage = nullptr;
     QSharedPointer<FeedList> feedList;
     FetchQueue *fetchQueue = nullptr;
+    FeedParser *feedParser = nullptr;
+    SearchIndex *searchIndex = nullptr;
     FrameManager *frameManager = nullptr;
 };
 
 Kernel::Kernel() : d(new KernelPrivate)
 {
     d->fetchQueue = new FetchQueue();
+    d->feedParser = new FeedParser();
     d->frameManager = new FrameManager();
     d->storage = nullptr;
 }
@@ -61,6 +65,7 @@ Kernel::Kernel() : d(new KernelPrivate)
 Kernel::~Kernel()
 {
     delete d->fetchQueue;
+    delete d->feedParser;
     delete d->frameManager;
     delete d;
     d = nullptr;
@@ -91,6 +96,21 @@ FetchQueue *Kernel::fetchQueue() const
     return d->fetchQueue;
 }
 
+FeedParser *Kernel::feedParser() const
+{
+    return d->feedParser;
+}
+
+SearchIndex *Kernel::searchIndex() const
+{
+    return d->searchIndex;
+}
+
+void Kernel::setSearchIndex(SearchIndex *searchIndex)
+{
+    d->searchIndex = searchIndex;
+}
+
 FrameManager *Kernel::frameManager() const
 {
     return d->frameManager;
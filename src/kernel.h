@@ -35,8 +35,10 @@ class Storage;
 }
 
 class FeedList;
+class FeedParser;
 class FetchQueue;
 class FrameManager;
+class SearchIndex;
 
 class AKREGATOR_EXPORT Kernel
 {
@@ -54,6 +56,13 @@ public:
 
     FetchQueue *fetchQueue() const;
 
+    /** returns the parser of downloaded feed documents */
+    FeedParser *feedParser() const;
+
+    /** returns the full-text index of the archive, or @c nullptr if there is none */
+    SearchIndex *searchIndex() const;
+    void setSearchIndex(SearchIndex *searchIndex);
+
     FrameManager *frameManager() const;
 
 private:
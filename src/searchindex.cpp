@@ -0,0 +1,478 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#include "searchindex.h"
+#include "akregator_debug.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+using namespace Akregator;
+
+namespace {
+const quint32 IndexMagic = 0x414b5349;
+const quint32 IndexVersion = 1;
+
+/** compacts the posting lists once this many articles were removed, and at least half of them */
+const int CompactThreshold = 50000;
+
+/** length of the substrings in the gram table, shorter query words are looked up by scanning all words */
+const int GramLength = 3;
+
+/** returns the unique substrings of @p word with GramLength characters */
+QSet<QString> grams(const QString &word)
+{
+    QSet<QString> result;
+    for (int i = 0; i + GramLength <= word.length(); ++i) {
+        result.insert(word.mid(i, GramLength));
+    }
+    return result;
+}
+
+/** splits @p text into unique words, folding the case per character like QString::indexOf(Qt::CaseInsensitive) does */
+QSet<QString> words(const QString &text)
+{
+    QSet<QString> result;
+    QString word;
+    const int length = text.length();
+    for (int i = 0; i <= length; ++i) {
+        if (i < length && text.at(i).isLetterOrNumber()) {
+            word += text.at(i).toCaseFolded();
+        } else if (!word.isEmpty()) {
+            result.insert(word);
+            word.clear();
+        }
+    }
+    return result;
+}
+}
+
+class Q_DECL_HIDDEN SearchIndex::Private
+{
+public:
+    struct Document {
+        int feed = -1;  // -1 once removed
+        QString guid;
+    };
+
+    explicit Private(const QString &path)
+        : filePath(path)
+    {
+    }
+
+    void ensureLoaded();
+    void load();
+    /** marks the document removed, call compactIfNeeded() afterwards */
+    void removeDocument(quint32 id);
+    void compactIfNeeded();
+    void compact();
+    void addWordGrams(const QString &word) const;
+    void ensureGrams() const;
+    /** returns the indexed words containing @p queryWord */
+    QVector<QString> wordsContaining(const QString &queryWord) const;
+    /** returns false if @p text contains no words to look up */
+    bool candidates(const QString &text, QSet<quint32> &result) const;
+
+    QString filePath;
+    bool loaded = false;
+
+    QStringList feedUrls;
+    QHash<QString, int> feedIndexes;
+    QSet<QString> indexedFeeds;
+    QVector<Document> documents;
+    /** feed URL -> guid -> document */
+    QHash<QString, QHash<QString, quint32> > documentIds;
+    /** word -> documents containing it, ascending */
+    QHash<QString, QVector<quint32> > postings;
+    int removedCount = 0;
+
+    /** substring of GramLength characters -> indexed words containing it, built on the first search */
+    mutable QHash<QString, QVector<QString> > gramWords;
+    mutable bool gramsBuilt = false;
+
+    /** bumped on every change, invalidates the cached query */
+    quint64 generation = 0;
+    mutable QString lastQuery;
+    mutable quint64 lastGeneration = 0;
+    mutable bool lastValid = false;
+    mutable QSet<quint32> lastCandidates;
+};
+
+void SearchIndex::Private::ensureLoaded()
+{
+    if (!loaded) {
+        loaded = true;
+        load();
+        // until the index is saved again, the file would not know about the changes made meanwhile
+        QFile::remove(filePath);
+    }
+}
+
+void SearchIndex::Private::load()
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QDataStream in(&file);
+    quint32 magic;
+    quint32 version;
+    in >> magic >> version;
+    if (magic != IndexMagic || version != IndexVersion) {
+        return;
+    }
+
+    QStringList indexed;
+    in >> feedUrls >> indexed;
+    for (int i = 0; i < feedUrls.count(); ++i) {
+        feedIndexes.insert(feedUrls.at(i), i);
+    }
+
+    quint32 count;
+    in >> count;
+    documents.resize(count);
+    for (quint32 id = 0; id < count; ++id) {
+        Document &doc = documents[id];
+        qint32 feed;
+        in >> feed >> doc.guid;
+        doc.feed = feed;
+        if (feed >= 0 && feed < feedUrls.count()) {
+            documentIds[feedUrls.at(feed)].insert(doc.guid, id);
+        } else {
+            doc.feed = -1;
+            ++removedCount;
+        }
+    }
+
+    in >> postings;
+
+    if (in.status() != QDataStream::Ok) {
+        qCWarning(AKREGATOR_LOG) << "Discarding corrupt search index" << filePath;
+        feedUrls.clear();
+        feedIndexes.clear();
+        documents.clear();
+        documentIds.clear();
+        postings.clear();
+        removedCount = 0;
+        return;
+    }
+
+    indexedFeeds = indexed.toSet();
+    qCDebug(AKREGATOR_LOG) << "Loaded search index with" << documents.count() - removedCount << "articles and" << postings.count() << "words in" << timer.elapsed() << "ms";
+}
+
+void SearchIndex::Private::removeDocument(quint32 id)
+{
+    Document &doc = documents[id];
+    doc.feed = -1;
+    doc.guid.clear();
+    ++removedCount;
+}
+
+void SearchIndex::Private::compactIfNeeded()
+{
+    if (removedCount >= CompactThreshold && removedCount * 2 >= documents.count()) {
+        compact();
+    }
+}
+
+void SearchIndex::Private::compact()
+{
+    QVector<quint32> newIds(documents.count(), 0);
+    QVector<Document> kept;
+    kept.reserve(documents.count() - removedCount);
+    for (int id = 0; id < documents.count(); ++id) {
+        if (documents.at(id).feed != -1) {
+            newIds[id] = kept.count();
+            kept.append(documents.at(id));
+        }
+    }
+
+    for (auto it = postings.begin(); it != postings.end();) {
+        QVector<quint32> ids;
+        for (quint32 id : qAsConst(it.value())) {
+            if (documents.at(id).feed != -1) {
+                ids.append(newIds.at(id));
+            }
+        }
+        if (ids.isEmpty()) {
+            it = postings.erase(it);
+        } else {
+            it.value() = ids;
+            ++it;
+        }
+    }
+
+    documents = kept;
+    documentIds.clear();
+    for (int id = 0; id < documents.count(); ++id) {
+        documentIds[feedUrls.at(documents.at(id).feed)].insert(documents.at(id).guid, id);
+    }
+    removedCount = 0;
+    // words without documents were dropped
+    gramWords.clear();
+    gramsBuilt = false;
+    ++generation;
+}
+
+void SearchIndex::Private::addWordGrams(const QString &word) const
+{
+    const QSet<QString> wordGrams = grams(word);
+    for (const QString &gram : wordGrams) {
+        gramWords[gram].append(word);
+    }
+}
+
+void SearchIndex::Private::ensureGrams() const
+{
+    if (gramsBuilt) {
+        return;
+    }
+    gramsBuilt = true;
+    QElapsedTimer timer;
+    timer.start();
+    for (auto it = postings.constBegin(), end = postings.constEnd(); it != end; ++it) {
+        addWordGrams(it.key());
+    }
+    qCDebug(AKREGATOR_LOG) << "Built search index gram table with" << gramWords.count() << "entries in" << timer.elapsed() << "ms";
+}
+
+QVector<QString> SearchIndex::Private::wordsContaining(const QString &queryWord) const
+{
+    QVector<QString> result;
+    if (queryWord.length() < GramLength) {
+        for (auto it = postings.constBegin(), end = postings.constEnd(); it != end; ++it) {
+            if (it.key().contains(queryWord)) {
+                result.append(it.key());
+            }
+        }
+        return result;
+    }
+
+    ensureGrams();
+    // a matching word contains every gram of the query word, check the words of the rarest one
+    const QVector<QString> *shortest = nullptr;
+    const QSet<QString> queryGrams = grams(queryWord);
+    for (const QString &gram : queryGrams) {
+        const auto it = gramWords.constFind(gram);
+        if (it == gramWords.constEnd()) {
+            return result;
+        }
+        if (!shortest || it.value().count() < shortest->count()) {
+            shortest = &it.value();
+        }
+    }
+    for (const QString &word : *shortest) {
+        if (word.contains(queryWord)) {
+            result.append(word);
+        }
+    }
+    return result;
+}
+
+bool SearchIndex::Private::candidates(const QString &text, QSet<quint32> &result) const
+{
+    const QSet<QString> queryWords = words(text);
+    if (queryWords.isEmpty()) {
+        return false;
+    }
+
+    // every word of the text lies within a word of a matching article, so each of them narrows the candidates
+    bool first = true;
+    for (const QString &queryWord : queryWords) {
+        QSet<quint32> docs;
+        const QVector<QString> matchingWords = wordsContaining(queryWord);
+        for (const QString &word : matchingWords) {
+            for (quint32 id : postings.value(word)) {
+                docs.insert(id);
+            }
+        }
+        if (first) {
+            result = docs;
+            first = false;
+        } else {
+            result.intersect(docs);
+        }
+        if (result.isEmpty()) {
+            break;
+        }
+    }
+    return true;
+}
+
+SearchIndex::SearchIndex(const QString &filePath)
+    : d(new Private(filePath))
+{
+}
+
+SearchIndex::~SearchIndex()
+{
+    delete d;
+}
+
+void SearchIndex::addArticle(const QString &feedUrl, const QString &guid, const QString &title, const QString &description, const QString &author)
+{
+    d->ensureLoaded();
+
+    QHash<QString, quint32> &ids = d->documentIds[feedUrl];
+    const auto it = ids.constFind(guid);
+    if (it != ids.constEnd()) {
+        d->removeDocument(it.value());
+        d->compactIfNeeded();
+    }
+
+    int feed = d->feedIndexes.value(feedUrl, -1);
+    if (feed == -1) {
+        feed = d->feedUrls.count();
+        d->feedUrls.append(feedUrl);
+        d->feedIndexes.insert(feedUrl, feed);
+    }
+
+    const quint32 id = d->documents.count();
+    Private::Document doc;
+    doc.feed = feed;
+    doc.guid = guid;
+    d->documents.append(doc);
+    // compact() may have rebuilt the hash
+    d->documentIds[feedUrl].insert(guid, id);
+
+    const QSet<QString> articleWords = words(title + QLatin1Char(' ') + description + QLatin1Char(' ') + author);
+    for (const QString &word : articleWords) {
+        auto it = d->postings.find(word);
+        if (it == d->postings.end()) {
+            it = d->postings.insert(word, QVector<quint32>());
+            if (d->gramsBuilt) {
+                d->addWordGrams(word);
+            }
+        }
+        it.value().append(id);
+    }
+    ++d->generation;
+}
+
+void SearchIndex::removeArticle(const QString &feedUrl, const QString &guid)
+{
+    d->ensureLoaded();
+
+    auto feedIt = d->documentIds.find(feedUrl);
+    if (feedIt == d->documentIds.end()) {
+        return;
+    }
+    const auto it = feedIt.value().find(guid);
+    if (it == feedIt.value().end()) {
+        return;
+    }
+    const quint32 id = it.value();
+    feedIt.value().erase(it);
+    d->removeDocument(id);
+    d->compactIfNeeded();
+    ++d->generation;
+}
+
+void SearchIndex::removeFeed(const QString &feedUrl)
+{
+    d->ensureLoaded();
+
+    d->indexedFeeds.remove(feedUrl);
+    // compact() rebuilds the guid hashes, so mark all documents removed before
+    const QHash<QString, quint32> ids = d->documentIds.take(feedUrl);
+    for (quint32 id : ids) {
+        d->removeDocument(id);
+    }
+    d->compactIfNeeded();
+    ++d->generation;
+}
+
+bool SearchIndex::isFeedIndexed(const QString &feedUrl) const
+{
+    d->ensureLoaded();
+    return d->indexedFeeds.contains(feedUrl);
+}
+
+void SearchIndex::setFeedIndexed(const QString &feedUrl)
+{
+    d->ensureLoaded();
+    d->indexedFeeds.insert(feedUrl);
+}
+
+SearchIndex::Answer SearchIndex::mayContain(const QString &feedUrl, const QString &guid, const QString &text) const
+{
+    d->ensureLoaded();
+    if (!d->indexedFeeds.contains(feedUrl)) {
+        return Unknown;
+    }
+    const auto feedIt = d->documentIds.constFind(feedUrl);
+    if (feedIt == d->documentIds.constEnd()) {
+        return Unknown;
+    }
+    const auto it = feedIt.value().constFind(guid);
+    if (it == feedIt.value().constEnd()) {
+        return Unknown;
+    }
+
+    // a search asks for the same text for every article, compute the candidates once
+    if (text != d->lastQuery || d->lastGeneration != d->generation) {
+        d->lastQuery = text;
+        d->lastGeneration = d->generation;
+        d->lastCandidates.clear();
+        d->lastValid = d->candidates(text, d->lastCandidates);
+    }
+    if (!d->lastValid) {
+        return Unknown;
+    }
+    return d->lastCandidates.contains(it.value()) ? Maybe : No;
+}
+
+void SearchIndex::save()
+{
+    if (!d->loaded) {
+        return;
+    }
+
+    QSaveFile file(d->filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(AKREGATOR_LOG) << "Cannot write search index" << d->filePath;
+        return;
+    }
+
+    QDataStream out(&file);
+    out << IndexMagic << IndexVersion;
+    out << d->feedUrls << d->indexedFeeds.toList();
+    out << static_cast<quint32>(d->documents.count());
+    for (const Private::Document &doc : qAsConst(d->documents)) {
+        out << static_cast<qint32>(doc.feed) << doc.guid;
+    }
+    out << d->postings;
+    file.commit();
+}
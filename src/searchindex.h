@@ -0,0 +1,79 @@
+/*
+    This file is part of Akregator.
+
+    Copyright (C) 2018 The Akregator Developers
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+    As a special exception, permission is given to link this program
+    with any edition of Qt, and distribute the resulting executable,
+    without including the source code for Qt in the source distribution.
+*/
+
+#ifndef AKREGATOR_SEARCHINDEX_H
+#define AKREGATOR_SEARCHINDEX_H
+
+#include "akregator_export.h"
+
+#include <QString>
+
+namespace Akregator {
+/**
+ * An inverted index of the words in article titles, descriptions and authors, used to rule out
+ * articles in text searches without reading them from the archive.
+ *
+ * The index answers whether an article @em may contain a text: it returns a superset of the
+ * matches, which the caller still has to verify. Feeds are only trusted once all their articles
+ * were added, see setFeedIndexed().
+ *
+ * The index is loaded on first use and written back by save(). The file is removed while the
+ * index is in use, so that after a crash it is rebuilt instead of missing articles.
+ */
+class AKREGATOR_EXPORT SearchIndex
+{
+public:
+    enum Answer {
+        Unknown, /**< the index cannot tell, the article has to be checked */
+        No,      /**< the article does not contain the text */
+        Maybe    /**< the article may contain the text */
+    };
+
+    explicit SearchIndex(const QString &filePath);
+    ~SearchIndex();
+
+    /** adds an article, replacing the words indexed for it before */
+    void addArticle(const QString &feedUrl, const QString &guid, const QString &title, const QString &description, const QString &author);
+    void removeArticle(const QString &feedUrl, const QString &guid);
+    /** removes all articles of a deleted feed */
+    void removeFeed(const QString &feedUrl);
+
+    /** returns whether all articles of the feed were added */
+    bool isFeedIndexed(const QString &feedUrl) const;
+    void setFeedIndexed(const QString &feedUrl);
+
+    /** returns whether the article may contain @p text, ignoring case */
+    Answer mayContain(const QString &feedUrl, const QString &guid, const QString &text) const;
+
+    /** writes the index to disk, if it was loaded */
+    void save();
+
+private:
+    Q_DISABLE_COPY(SearchIndex)
+    class Private;
+    Private *const d;
+};
+} // namespace Akregator
+
+#endif // AKREGATOR_SEARCHINDEX_H
@@ -29,6 +29,7 @@
 #include "article.h"
 #include "articlejobs.h"
 #include "articlemodel.h"
+#include "feed.h"
 #include "feedlist.h"
 #include "subscriptionlistmodel.h"
 #include "treenode.h"
@@ -232,7 +233,30 @@ void Akregator::SelectionController::articleHeadersAvailable(KJob *job)
     Q_ASSERT(node);   // if there was no error, the node must still exist
     Q_ASSERT(node == m_selectedSubscription);   //...and equal the previously selected node
 
-    ArticleModel *const newModel = new ArticleModel(m_listJob->articles());
+    if (!m_articleModelListed) {
+        // nothing was listed, show the empty node
+        setUpArticleModel(node, QVector<Article>());
+    }
+
+    m_articleLister->setScrollBarPositions(node->listViewScrollBarPositions());
+}
+
+void Akregator::SelectionController::articlesListed(ArticleListJob *job, const QVector<Article> &articles)
+{
+    Q_ASSERT(job == m_listJob);
+
+    if (!m_articleModelListed) {
+        setUpArticleModel(job->node(), articles);
+    } else {
+        m_articleModel->articlesAdded(job->node(), articles);
+    }
+}
+
+void Akregator::SelectionController::setUpArticleModel(TreeNode *node, const QVector<Article> &articles)
+{
+    Q_ASSERT(node);
+
+    ArticleModel *const newModel = new ArticleModel(articles);
 
     connect(node, &QObject::destroyed, newModel, &ArticleModel::clear);
     connect(node, &TreeNode::signalArticlesAdded, newModel, &ArticleModel::articlesAdded);
@@ -247,9 +271,7 @@ void Akregator::SelectionController::articleHeadersAvailable(KJob *job)
     disconnect(m_articleLister->articleSelectionModel(), &QItemSelectionModel::selectionChanged, this, &SelectionController::articleSelectionChanged);
     connect(m_articleLister->articleSelectionModel(), &QItemSelectionModel::selectionChanged, this, &SelectionController::articleSelectionChanged);
 
-    if (node) {
-        m_articleLister->setScrollBarPositions(node->listViewScrollBarPositions());
-    }
+    m_articleModelListed = true;
 }
 
 void Akregator::SelectionController::subscriptionDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
@@ -294,16 +316,22 @@ void Akregator::SelectionController::selectedSubscriptionChanged(const QModelInd
         m_selectedSubscription->setListViewScrollBarPositions(m_articleLister->scrollBarPositions());
     }
 
+    if (Feed *const feed = qobject_cast<Feed *>(m_selectedSubscription.data())) {
+        feed->setArchivePinned(false);
+    }
     m_selectedSubscription = selectedSubscription();
+    if (Feed *const feed = qobject_cast<Feed *>(m_selectedSubscription.data())) {
+        feed->setArchivePinned(true);
+    }
     Q_EMIT currentSubscriptionChanged(m_selectedSubscription);
 
-    // using a timer here internally to simulate async data fetching (which is still synchronous),
-    // to ensure the UI copes with async behavior later on
+    // the articles are listed in chunks from the event loop, the old listing is cancelled
 
     if (m_listJob) {
         m_listJob->disconnect(this);   //Ignore if ~KJob() emits finished()
-        delete m_listJob;
+        m_listJob->kill();
     }
+    m_articleModelListed = false;
 
     if (!m_selectedSubscription) {
         return;
@@ -312,6 +340,8 @@ void Akregator::SelectionController::selectedSubscriptionChanged(const QModelInd
     ArticleListJob *const job(new ArticleListJob(m_selectedSubscription));
     connect(job, &KJob::finished,
             this, &SelectionController::articleHeadersAvailable);
+    connect(job, &ArticleListJob::articlesListed,
+            this, &SelectionController::articlesListed);
     m_listJob = job;
     m_listJob->start();
 }
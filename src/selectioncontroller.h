@@ -93,10 +93,13 @@ private Q_SLOTS:
     void articleIndexDoubleClicked(const QModelIndex &index);
     void subscriptionContextMenuRequested(const QPoint &point);
     void articleHeadersAvailable(KJob *);
+    void articlesListed(Akregator::ArticleListJob *job, const QVector<Akregator::Article> &articles);
 
 private:
 
     void setCurrentSubscriptionModel();
+    /** replaces the article model with one listing @p node, starting with @p articles */
+    void setUpArticleModel(TreeNode *node, const QVector<Akregator::Article> &articles);
 
     QSharedPointer<FeedList> m_feedList;
     QPointer<QAbstractItemView> m_feedSelector;
@@ -108,6 +111,8 @@ private:
     Akregator::ArticleModel *m_articleModel = nullptr;
     QPointer<TreeNode> m_selectedSubscription;
     QPointer<ArticleListJob> m_listJob;
+    /** whether the article model was already replaced for the running list job */
+    bool m_articleModelListed = false;
 };
 } // namespace Akregator
 
@@ -23,9 +23,11 @@
 */
 
 #include "subscriptionlistjobs.h"
+#include "feed.h"
 #include "feedlist.h"
 #include "folder.h"
 #include "kernel.h"
+#include "searchindex.h"
 #include "treenode.h"
 
 #include <KLocalizedString>
@@ -146,7 +148,24 @@ void DeleteSubscriptionJob::doDelete()
 {
     const QSharedPointer<FeedList> feedList = m_feedList.lock();
     if (m_id > 0 && feedList) {
-        delete feedList->findByID(m_id);
+        TreeNode *const node = feedList->findByID(m_id);
+        QStringList urls;
+        if (node) {
+            const QVector<Feed *> feeds = node->feeds();
+            for (const Feed *feed : feeds) {
+                urls.append(feed->xmlUrl());
+            }
+        }
+        delete node;
+
+        if (SearchIndex *index = Kernel::self()->searchIndex()) {
+            for (const QString &url : qAsConst(urls)) {
+                // the same URL may still be subscribed elsewhere in the list
+                if (!feedList->findByURL(url)) {
+                    index->removeFeed(url);
+                }
+            }
+        }
     }
     emitResult();
 }
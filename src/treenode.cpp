@@ -103,10 +103,7 @@ TreeNode *TreeNode::nextSibling()
     if (!d->parent) {
         return nullptr;
     }
-    const QList<TreeNode *> children = parent()->children();
-    const int idx = children.indexOf(this);
-
-    return (idx + 1 < children.size()) ? children.at(idx + 1) : nullptr;
+    return d->parent->childAt(d->parent->indexOf(this) + 1);
 }
 
 const TreeNode *TreeNode::nextSibling() const
@@ -114,10 +111,8 @@ const TreeNode *TreeNode::nextSibling() const
     if (!d->parent) {
         return nullptr;
     }
-    const QList<const TreeNode *> children = parent()->children();
-    const int idx = children.indexOf(this);
-
-    return (idx + 1 < children.size()) ? children.at(idx + 1) : nullptr;
+    const Folder *parent = d->parent;
+    return parent->childAt(parent->indexOf(this) + 1);
 }
 
 TreeNode *TreeNode::prevSibling()
@@ -125,10 +120,8 @@ TreeNode *TreeNode::prevSibling()
     if (!d->parent) {
         return nullptr;
     }
-    const QList<TreeNode *> children = parent()->children();
-
-    const int idx = children.indexOf(this);
-    return (idx > 0) ? children.at(idx - 1) : nullptr;
+    const int idx = d->parent->indexOf(this);
+    return (idx > 0) ? d->parent->childAt(idx - 1) : nullptr;
 }
 
 const TreeNode *TreeNode::prevSibling() const
@@ -136,9 +129,9 @@ const TreeNode *TreeNode::prevSibling() const
     if (!d->parent) {
         return nullptr;
     }
-    const QList<const TreeNode *> children = parent()->children();
-    const int idx = children.indexOf(this);
-    return (idx > 0) ? children.at(idx - 1) : nullptr;
+    const Folder *parent = d->parent;
+    const int idx = parent->indexOf(this);
+    return (idx > 0) ? parent->childAt(idx - 1) : nullptr;
 }
 
 const Folder *TreeNode::parent() const